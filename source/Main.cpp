@@ -1,9 +1,20 @@
+#include <chrono>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "RunTests.hpp"
 
+#include "format/DDSFileFormat.hpp"
+#include "format/DDSStreamWriter.hpp"
+#include "format/DDSVolumeWriter.hpp"
 #include "generators/Interpolator.hpp"
 #include "generators/noise/BetterGradientNoise.hpp"
+#include "generators/noise/FractalNoise.hpp"
 #include "generators/noise/GaborNoise.hpp"
 #include "generators/noise/ModifiedNoise.hpp"
 #include "generators/noise/PerlinNoise.hpp"
@@ -15,6 +26,10 @@
 #include "image/ChannelConversion.hpp"
 #include "image/ImageData.hpp"
 #include "utility/ArgumentParser.hpp"
+#include "utility/ContentHash.hpp"
+#include "utility/Profiler.hpp"
+#include "utility/ResultCache.hpp"
+#include "utility/ThreadPool.hpp"
 
 // Checker defaults
 static constexpr u64 kDefaultBrightMax = 255;
@@ -32,28 +47,87 @@ static constexpr u64 kDefaultCellSize = 32;
 // Lattice defaults
 static constexpr u64 kDefaultLatticeWidth = 32;
 static constexpr u64 kDefaultLatticeHeight = 32;
+static constexpr u64 kDefaultLatticeDepth = 32;
+
+// Fractal defaults
+static constexpr u64 kDefaultOctaves = 4;
+static constexpr u64 kDefaultLacunarity = 200;
+static constexpr u64 kDefaultGain = 50;
 
 // Image defaults
 static constexpr u64 kDefaultWidth = 1024;
 static constexpr u64 kDefaultHeight = 1024;
+static constexpr u64 kDefaultDepth = 0;
+
+// Output defaults
+static constexpr u64 kDefaultStripHeight = 0;
+
+// Execution defaults
+static constexpr u64 kDefaultThreadCount = 0;
 
 static constexpr f32 kPI = 3.1416f;
 
+// Part of every cache key. Bump it when a generator or a file format changes its output, so files cached by older builds
+// are not used.
+static constexpr u64 kCacheVersion = 1;
+
+enum class Generator
+{
+    kChecker,
+    kWorley,
+    kWhite,
+    kWavelet,
+    kValue,
+    kPerlin,
+    kModified,
+    kGabor,
+    kBetterGradient,
+};
+
+enum class Fractal
+{
+    kNone,
+    kFbm,
+    kRidged,
+    kTurbulence,
+};
+
+enum class FileFormat
+{
+    kTga,
+    kDds,
+};
+
 static void printOptions(const ArgumentParser& parser)
 {
     std::cout << "Options:" << std::endl;
     parser.PrintOptions();
 }
 
-static ImageData* createImage(const ArgumentParser& parser, u32 numChannels)
+// Images kept from one job to the next job that runs on the same thread, reallocated only when a job needs another size.
+struct JobBuffers
 {
-    u32 w = parser.GetValueAs<u32>("width");
-    u32 h = parser.GetValueAs<u32>("height");
+    ImageData* image = nullptr;
+    ImageData* expanded = nullptr;
 
-    if (w == 0 || h == 0)
-        return nullptr;
+    ~JobBuffers()
+    {
+        delete image;
+        delete expanded;
+    }
+};
 
-    return new ImageData(w, h, numChannels, parser.IsEnabled("mipmaps"));
+static ImageData& acquireImage(ImageData*& image, u32 w, u32 h, u32 numChannels, bool generateMipChain)
+{
+    bool fits = image != nullptr && image->GetWidth() == w && image->GetHeight() == h &&
+        image->GetChannelCount() == numChannels && (image->GetMipLevelCount() > 1) == generateMipChain;
+    if (!fits)
+    {
+        delete image;
+        // Every generator writes all pixels of every mip level, so the pixels are not cleared.
+        image = new ImageData(w, h, numChannels, generateMipChain, false);
+    }
+    return *image;
 }
 
 template<class Generator>
@@ -83,14 +157,15 @@ static void generateChecker(TilingMode mode, const ArgumentParser& parser, Image
     generate<Checker>(mode, parameters, result);
 }
 
-static void generateWorley(TilingMode mode, const ArgumentParser& parser, ImageData& result)
+static WorleyNoise::Parameters getWorleyParameters(const ArgumentParser& parser)
 {
     WorleyNoise::Parameters parameters;
 
     parameters.minPointsPerCell = parser.GetValueAs<u32>("min-points-per-cell");
     parameters.maxPointsPerCell = parser.GetValueAs<u32>("max-points-per-cell");
     parameters.cellSize = parser.GetValueAs<u32>("cell-size");
-    parameters.cellsPerRow = result.GetWidth() / parameters.cellSize;
+    parameters.cellsPerRow = parser.GetValueAs<u32>("width") / parameters.cellSize;
+    parameters.cellLayers = parser.GetValueAs<u32>("depth") / parameters.cellSize;
     parameters.cellIndexOffset = 1;
     parameters.rMul = 1.0f;
     parameters.gMul = 1.0f;
@@ -99,12 +174,18 @@ static void generateWorley(TilingMode mode, const ArgumentParser& parser, ImageD
     parameters.gAdd = 0.0f;
     parameters.bAdd = 0.0f;
 
-    generate<WorleyNoise>(mode, parameters, result);
+    return parameters;
+}
+
+static void generateWorley(TilingMode mode, const ArgumentParser& parser, ImageData& result)
+{
+    generate<WorleyNoise>(mode, getWorleyParameters(parser), result);
 }
 
-static void generateWhiteNoise(TilingMode mode, ImageData& result)
+static void generateWhiteNoise(TilingMode mode, const ArgumentParser& parser, ImageData& result)
 {
     WhiteNoise::Parameters parameters;
+    parameters.hash = parser.GetValueAs<WhiteNoise::Hash>("hash");
     generate<WhiteNoise>(mode, parameters, result);
 }
 
@@ -117,24 +198,36 @@ static void generateWavelet(TilingMode mode, const ArgumentParser& parser, Image
     generate<WaveletNoise<FifthOrderInterpolator>>(mode, parameters, result);
 }
 
-static void generateValue(TilingMode mode, const ArgumentParser& parser, ImageData& result)
+static ValueNoise<LinearInterpolator>::Parameters getValueParameters(const ArgumentParser& parser)
 {
     ValueNoise<LinearInterpolator>::Parameters parameters;
     parameters.latticeWidth = parser.GetValueAs<u32>("lattice-width");
     parameters.latticeHeight = parser.GetValueAs<u32>("lattice-height");
+    parameters.latticeDepth = parser.GetValueAs<u32>("lattice-depth");
     parameters.rangeMin = 0.0f;
     parameters.rangeMax = 1.0f;
 
-    generate<ValueNoise<LinearInterpolator>>(mode, parameters, result);
+    return parameters;
 }
 
-static void generatePerlin(TilingMode mode, const ArgumentParser& parser, ImageData& result)
+static void generateValue(TilingMode mode, const ArgumentParser& parser, ImageData& result)
+{
+    generate<ValueNoise<LinearInterpolator>>(mode, getValueParameters(parser), result);
+}
+
+static PerlinNoise<FifthOrderInterpolator>::Parameters getPerlinParameters(const ArgumentParser& parser)
 {
     PerlinNoise<FifthOrderInterpolator>::Parameters parameters;
     parameters.latticeWidth = parser.GetValueAs<u32>("lattice-width");
     parameters.latticeHeight = parser.GetValueAs<u32>("lattice-height");
+    parameters.latticeDepth = parser.GetValueAs<u32>("lattice-depth");
 
-    generate<PerlinNoise<FifthOrderInterpolator>>(mode, parameters, result);
+    return parameters;
+}
+
+static void generatePerlin(TilingMode mode, const ArgumentParser& parser, ImageData& result)
+{
+    generate<PerlinNoise<FifthOrderInterpolator>>(mode, getPerlinParameters(parser), result);
 }
 
 static void generateModified(TilingMode mode, const ArgumentParser& parser, ImageData& result)
@@ -160,22 +253,344 @@ static void generateGabor(TilingMode mode, const ArgumentParser& parser, ImageDa
     parameters.gaussianWidth = kPI / (parameters.cellSize * parameters.cellSize);
     parameters.numberOfImpulsesPerCell = parser.GetValueAs<u32>("min-points-per-cell");
     parameters.numberOfImpulsesPerCellCap = parser.GetValueAs<u32>("max-points-per-cell");
+    parameters.precision = parser.GetValueAs<GaborNoise::Precision>("gabor-precision");
+    parameters.cellsPerRow = result.GetWidth() / static_cast<u32>(parameters.cellSize);
 
     generate<GaborNoise>(mode, parameters, result);
 }
 
-static void generateBetterGradient(TilingMode mode, const ArgumentParser& parser, ImageData& result)
+static BetterGradientNoise<FifthOrderInterpolator>::Parameters getBetterGradientParameters(const ArgumentParser& parser)
 {
     BetterGradientNoise<FifthOrderInterpolator>::Parameters parameters;
     parameters.latticeWidth = parser.GetValueAs<u32>("lattice-width");
     parameters.latticeHeight = parser.GetValueAs<u32>("lattice-height");
+    parameters.latticeDepth = parser.GetValueAs<u32>("lattice-depth");
 
-    generate<BetterGradientNoise<FifthOrderInterpolator>>(mode, parameters, result);
+    return parameters;
 }
 
-i32 main(i32 argc, const char** argv)
+static void generateBetterGradient(TilingMode mode, const ArgumentParser& parser, ImageData& result)
+{
+    generate<BetterGradientNoise<FifthOrderInterpolator>>(mode, getBetterGradientParameters(parser), result);
+}
+
+template<class Noise>
+static void generateFractal(const typename Noise::Parameters& noise, const ArgumentParser& parser, ImageData& result)
+{
+    typename FractalNoise<Noise>::Parameters parameters;
+    parameters.noise = noise;
+    parameters.octaveCount = parser.GetValueAs<u32>("octaves");
+    parameters.lacunarity = parser.GetValueAs<f32>("lacunarity") / 100.0f;
+    parameters.gain = parser.GetValueAs<f32>("gain") / 100.0f;
+    switch (parser.GetValueAs<Fractal>("fractal"))
+    {
+    case Fractal::kRidged:
+        parameters.mode = FractalNoise<Noise>::Mode::kRidged;
+        break;
+    case Fractal::kTurbulence:
+        parameters.mode = FractalNoise<Noise>::Mode::kTurbulence;
+        break;
+    default:
+        parameters.mode = FractalNoise<Noise>::Mode::kFbm;
+        break;
+    }
+
+    FractalNoise<Noise>::GenerateSimple(parameters, result);
+}
+
+static bool hasFractals(Generator selected)
+{
+    return selected == Generator::kValue || selected == Generator::kPerlin || selected == Generator::kBetterGradient;
+}
+
+static void generateImage(Generator selected, TilingMode mode, const ArgumentParser& parser, ImageData& result)
+{
+    PROFILE_SCOPE_BYTES("generate", result.GetByteCount());
+    if (parser.GetValueAs<Fractal>("fractal") != Fractal::kNone)
+    {
+        switch (selected)
+        {
+        case Generator::kValue:
+            generateFractal<ValueNoise<LinearInterpolator>>(getValueParameters(parser), parser, result);
+            break;
+        case Generator::kPerlin:
+            generateFractal<PerlinNoise<FifthOrderInterpolator>>(getPerlinParameters(parser), parser, result);
+            break;
+        case Generator::kBetterGradient:
+            generateFractal<BetterGradientNoise<FifthOrderInterpolator>>(getBetterGradientParameters(parser), parser, result);
+            break;
+        default:
+            break;
+        }
+        return;
+    }
+
+    switch (selected)
+    {
+    case Generator::kChecker:
+        generateChecker(mode, parser, result);
+        break;
+    case Generator::kWorley:
+        generateWorley(mode, parser, result);
+        break;
+    case Generator::kWhite:
+        generateWhiteNoise(mode, parser, result);
+        break;
+    case Generator::kWavelet:
+        generateWavelet(mode, parser, result);
+        break;
+    case Generator::kValue:
+        generateValue(mode, parser, result);
+        break;
+    case Generator::kPerlin:
+        generatePerlin(mode, parser, result);
+        break;
+    case Generator::kModified:
+        generateModified(mode, parser, result);
+        break;
+    case Generator::kGabor:
+        generateGabor(mode, parser, result);
+        break;
+    case Generator::kBetterGradient:
+        generateBetterGradient(mode, parser, result);
+        break;
+    }
+}
+
+// Generates the image a strip at a time and writes each strip to the DDS file before the next one is generated.
+static void generateStrips(Generator selected, TilingMode mode, const ArgumentParser& parser, u32 numChannels, u32 stripHeight)
+{
+    u32 w = parser.GetValueAs<u32>("width");
+    u32 h = parser.GetValueAs<u32>("height");
+
+    ImageData* strip = ImageData::CreateStrip(w, h, numChannels, stripHeight);
+    DDSStreamWriter writer(parser.GetText("output") + ".dds", w, h, numChannels, parser.IsEnabled("mipmaps"), parser.GetValueAs<DDSFileFormat::PixelFormat>("pixel-format"));
+    for (u64 y = 0; y < h; y += stripHeight)
+    {
+        strip->SetStrip(static_cast<u32>(y));
+        generateImage(selected, mode, parser, *strip);
+
+        u32 firstRow;
+        u32 rowCount;
+        strip->GetRows(0, firstRow, rowCount);
+        writer.Write(strip->GetPixels(0), rowCount);
+    }
+    delete strip;
+}
+
+static bool hasVolumes(Generator selected)
+{
+    return selected == Generator::kWorley || selected == Generator::kValue || selected == Generator::kPerlin || selected == Generator::kBetterGradient;
+}
+
+static void generateSlice(Generator selected, const ArgumentParser& parser, u32 z, ImageData& slice)
+{
+    PROFILE_SCOPE_BYTES("generate", slice.GetByteCount());
+    u32 depth = parser.GetValueAs<u32>("depth");
+    switch (selected)
+    {
+    case Generator::kWorley:
+        WorleyNoise::GenerateSlice(getWorleyParameters(parser), z, slice);
+        break;
+    case Generator::kValue:
+        ValueNoise<LinearInterpolator>::GenerateSlice(getValueParameters(parser), depth, z, slice);
+        break;
+    case Generator::kPerlin:
+        PerlinNoise<FifthOrderInterpolator>::GenerateSlice(getPerlinParameters(parser), depth, z, slice);
+        break;
+    case Generator::kBetterGradient:
+        BetterGradientNoise<FifthOrderInterpolator>::GenerateSlice(getBetterGradientParameters(parser), depth, z, slice);
+        break;
+    default:
+        break;
+    }
+}
+
+// Generates the volume a slice at a time and writes each slice to the DDS file before the next one is generated.
+static void generateVolume(Generator selected, const ArgumentParser& parser, u32 numChannels, JobBuffers& buffers)
+{
+    u32 w = parser.GetValueAs<u32>("width");
+    u32 h = parser.GetValueAs<u32>("height");
+    u32 depth = parser.GetValueAs<u32>("depth");
+
+    ImageData& slice = acquireImage(buffers.image, w, h, numChannels, false);
+    DDSVolumeWriter writer(parser.GetText("output") + ".dds", w, h, depth, numChannels, parser.GetValueAs<DDSFileFormat::PixelFormat>("pixel-format"));
+    for (u32 z = 0; z < depth; ++z)
+    {
+        generateSlice(selected, parser, z, slice);
+        writer.WriteSlice(slice.GetPixels(0));
+    }
+}
+
+static u32 getChannelCount(Generator selected)
+{
+    return selected == Generator::kWorley ? 4 : 1;
+}
+
+// Returns why the options do not describe an image or a volume that can be generated, or nullptr if they do.
+static const char* validateJob(const ArgumentParser& parser)
+{
+    Generator selected = parser.GetValueAs<Generator>("generator");
+    TilingMode tiling = parser.GetValueAs<TilingMode>("tiling");
+
+    if (parser.GetValueAs<u32>("width") == 0 || parser.GetValueAs<u32>("height") == 0)
+        return "Incorrect image parameters provided.";
+
+    if (parser.GetValueAs<Fractal>("fractal") != Fractal::kNone)
+    {
+        bool isSupported = hasFractals(selected) && tiling == TilingMode::kSimple && parser.GetValueAs<u32>("depth") == 0;
+        if (!isSupported || parser.GetValueAs<u32>("octaves") == 0)
+            return "Fractal noise is made of value, Perlin or better gradient noise images with simple tiling and at least one octave.";
+    }
+
+    if (parser.GetValueAs<u32>("depth") > 0)
+    {
+        if (!hasVolumes(selected))
+            return "Volumes can only be generated with Worley, value, Perlin and better gradient noise.";
+
+        if (parser.GetValueAs<FileFormat>("file-format") != FileFormat::kDds || parser.IsEnabled("mipmaps") || tiling != TilingMode::kSimple)
+            return "Volumes are written to DDS files without mipmaps and only tile simply.";
+
+        // Worley volumes wrap their cell layers with a mask, like the cells of a row.
+        u32 depth = parser.GetValueAs<u32>("depth");
+        u32 cellSize = parser.GetValueAs<u32>("cell-size");
+        u32 cellLayers = cellSize > 0 ? depth / cellSize : 0;
+        if (selected == Generator::kWorley && (cellLayers == 0 || depth % cellSize != 0 || (cellLayers & (cellLayers - 1)) != 0))
+            return "Worley volumes are a power of 2 cells deep, so the depth must be the cell size times a power of 2.";
+    }
+    else if (parser.GetValueAs<u32>("strip-height") > 0 && parser.GetValueAs<FileFormat>("file-format") != FileFormat::kDds)
+    {
+        return "Only DDS files can be written in strips.";
+    }
+
+    // The TGA header stores 16 bit dimensions.
+    if (parser.GetValueAs<FileFormat>("file-format") != FileFormat::kDds &&
+        (parser.GetValueAs<u32>("width") > 0xFFFF || parser.GetValueAs<u32>("height") > 0xFFFF))
+    {
+        return "TGA files are at most 65535 pixels wide and high. Write larger images with --file-format dds, in strips with --strip-height if they do not fit in memory.";
+    }
+
+    return nullptr;
+}
+
+// Generates and writes the image or volume of validated options.
+static void runJob(const ArgumentParser& parser, JobBuffers& buffers)
+{
+    Generator selected = parser.GetValueAs<Generator>("generator");
+    TilingMode tiling = parser.GetValueAs<TilingMode>("tiling");
+    u32 numChannels = getChannelCount(selected);
+
+    if (parser.GetValueAs<u32>("depth") > 0)
+    {
+        generateVolume(selected, parser, numChannels, buffers);
+        return;
+    }
+
+    u32 stripHeight = parser.GetValueAs<u32>("strip-height");
+    if (stripHeight > 0)
+    {
+        generateStrips(selected, tiling, parser, numChannels, stripHeight);
+        return;
+    }
+
+    ImageData& generated = acquireImage(buffers.image, parser.GetValueAs<u32>("width"), parser.GetValueAs<u32>("height"), numChannels, parser.IsEnabled("mipmaps"));
+    generateImage(selected, tiling, parser, generated);
+
+    const std::string& output = parser.GetText("output");
+    bool compress = parser.IsEnabled("tga-rle");
+    if (parser.GetValueAs<FileFormat>("file-format") == FileFormat::kDds)
+    {
+        DDSFileFormat::Save(generated, parser.GetValueAs<DDSFileFormat::PixelFormat>("pixel-format"), output + ".dds");
+    }
+    else if (numChannels == 1 && !compress)
+    {
+        ImageData& expanded = acquireImage(buffers.expanded, generated.GetWidth(), generated.GetHeight(), 4, generated.GetMipLevelCount() > 1);
+        ChannelConverter::RToRRR1(generated, expanded);
+        expanded.Save(output);
+    }
+    else
+    {
+        generated.Save(output, compress);
+    }
+}
+
+// Options that select what to run or where to write it, rather than what is written.
+static bool affectsOutput(const std::string& name)
+{
+    return name != "run-tests" && name != "help" && name != "output" && name != "threads" && name != "batch" &&
+        name != "cache" && name != "profile" && name != "trace";
+}
+
+// Hashes every option that affects the written files, defaults included. The generator parameters are made from these
+// options alone, so equal keys mean equal files.
+static u64 getCacheKey(const ArgumentParser& parser)
+{
+    ContentHash hash;
+    hash.Add(kCacheVersion);
+    for (const std::string& name : parser.GetNames())
+    {
+        if (!affectsOutput(name))
+            continue;
+
+        hash.Add(name);
+        if (parser.IsText(name))
+            hash.Add(parser.GetText(name));
+        else
+            hash.Add(parser.GetValue(name));
+    }
+    return hash.Get();
+}
+
+// Suffixes runJob adds to the output name, one for every file it writes.
+static std::vector<std::string> getOutputSuffixes(const ArgumentParser& parser)
+{
+    if (parser.GetValueAs<FileFormat>("file-format") == FileFormat::kDds)
+        return { ".dds" };
+    if (!parser.IsEnabled("mipmaps"))
+        return { ".tga" };
+
+    std::vector<std::string> suffixes;
+    u32 w = parser.GetValueAs<u32>("width");
+    u32 h = parser.GetValueAs<u32>("height");
+    for (u32 mip = 0; ; ++mip)
+    {
+        suffixes.push_back("_mip" + std::to_string(mip) + ".tga");
+        if (w == 1 && h == 1)
+            break;
+        w = w > 1 ? w >> 1 : 1;
+        h = h > 1 ? h >> 1 : 1;
+    }
+    return suffixes;
+}
+
+// Copies the files of an earlier job with the same options from the cache, if there is one. Returns true on a hit.
+static bool runCachedJob(const ArgumentParser& parser, ResultCache* cache, JobBuffers& buffers)
+{
+    PROFILE_SCOPE("job");
+    if (cache == nullptr)
+    {
+        runJob(parser, buffers);
+        return false;
+    }
+
+    u64 key = getCacheKey(parser);
+    const std::string& output = parser.GetText("output");
+    if (cache->Fetch(key, output))
+        return true;
+
+    runJob(parser, buffers);
+    cache->Store(key, output, getOutputSuffixes(parser));
+    return false;
+}
+
+static void printCacheStats(const ResultCache& cache)
+{
+    ResultCache::Stats stats = cache.GetStats();
+    std::cout << "Cache: " << stats.hits << " hits, " << stats.misses << " misses, " << stats.bytesSaved << " bytes saved." << std::endl;
+}
+
+static void addArguments(ArgumentParser& arguments)
 {
-    ArgumentParser arguments;
     // Generic parameters
     arguments.AddKnownArgument("run-tests", "rt", { "" }, {"run unit tests"});
     arguments.AddKnownArgument("help", "h", { "" }, { "print options" });
@@ -201,7 +616,7 @@ i32 main(i32 argc, const char** argv)
         });
 
     // Checker parameters
-    arguments.AddKnownArgument("cheker-bright-max", "bmax", {}, { "maximum brightness of a bright checker tile. Must be in range [0; 255]" }, kDefaultBrightMax);
+    arguments.AddKnownArgument("checker-bright-max", "bmax", {}, { "maximum brightness of a bright checker tile. Must be in range [0; 255]" }, kDefaultBrightMax);
     arguments.AddKnownArgument("checker-bright-min", "bmin", {}, { "minimum brightness of a bright checker tile. Must be in range [0; 255]" }, kDefaultBrightMin);
     arguments.AddKnownArgument("checker-dark-max", "dmax", {}, { "maximum brightness of a dark checker tile. Must be in range [0; 255]" }, kDefaultDarkMax);
     arguments.AddKnownArgument("checker-dark-min", "dmin", {}, { "minimum brightness of a dark checker tile. Must be in range [0; 255]" }, kDefaultDarkMin);
@@ -214,103 +629,254 @@ i32 main(i32 argc, const char** argv)
     arguments.AddKnownArgument("cell-size", "cs", {}, { "size of a single cell for Worley or Gabor noise" }, kDefaultCellSize);
 
     arguments.AddKnownArgument("anisotropic", "a", { "" }, { "generate anisotropic Gabor noise" });
+    arguments.AddKnownArgument("gabor-precision", "gp", { "exact", "fast" }, {
+        "select accuracy of the Gabor kernel evaluation",
+
+        "use the standard library exp and cos",
+        "use vectorized polynomial approximations of exp and cos",
+        });
+
+    // White noise parameters
+    arguments.AddKnownArgument("hash", "hs", { "md5", "pcg", "philox" }, {
+        "select the hash function used for white noise",
+
+        "MD5 of the pixel coordinates",
+        "pcg4d integer hash, the fastest option",
+        "Philox-4x32-10 counter-based generator",
+        });
 
     // Lattice parameters
     arguments.AddKnownArgument("lattice-width", "lw", {}, { "width of the lattice for lattice-based noises" }, kDefaultLatticeWidth);
     arguments.AddKnownArgument("lattice-height", "lh", {}, { "height of the lattice for lattice-based noises" }, kDefaultLatticeHeight);
+    arguments.AddKnownArgument("lattice-depth", "ld", {}, { "depth of the lattice for lattice-based noise volumes" }, kDefaultLatticeDepth);
+
+    // Fractal parameters
+    arguments.AddKnownArgument("fractal", "fr", { "none", "fbm", "ridged", "turbulence" }, {
+        "sum octaves of value, Perlin or better gradient noise in a single pass. The lattice size sets the first octave",
+
+        "a single octave",
+        "fractional Brownian motion, octaves summed as they are",
+        "ridged noise, sharp crests where an octave crosses its midpoint",
+        "turbulence, creases where an octave crosses its midpoint",
+        });
+    arguments.AddKnownArgument("octaves", "oc", {}, { "number of octaves of fractal noise. Must be greater than 0" }, kDefaultOctaves);
+    arguments.AddKnownArgument("lacunarity", "lac", {}, { "lattice size growth from one octave to the next, in hundredths" }, kDefaultLacunarity);
+    arguments.AddKnownArgument("gain", "gn", {}, { "amplitude factor from one octave to the next, in hundredths" }, kDefaultGain);
 
     // Image parameters
     arguments.AddKnownArgument("width", "w", {}, { "image width. Must be greater than 0" }, kDefaultWidth);
     arguments.AddKnownArgument("height", "h", {}, { "image height. Must be greater than 0" }, kDefaultHeight);
+    arguments.AddKnownArgument("depth", "d", {}, { "volume depth. Volumes are written a slice at a time to a single DDS file without mipmaps, with simple tiling. 0 generates an image" }, kDefaultDepth);
     arguments.AddKnownArgument("mipmaps", "m", { "" }, { "generate mipmaps" });
 
-    if (!arguments.Parse(argc, argv))
+    // Output parameters
+    arguments.AddKnownArgument("file-format", "ff", { "tga", "dds" }, {
+        "output file format",
+
+        "one TGA file per mip level",
+        "a single DDS file holding every mip level. One channel noise is written as a single channel",
+        });
+    arguments.AddKnownArgument("pixel-format", "pf", { "unorm8", "float16", "float32", "bc" }, {
+        "pixel format of DDS files",
+
+        "8 bit normalized integers",
+        "16 bit floats",
+        "32 bit floats",
+        "block compressed: BC4 for one channel noise, BC1 for Worley RGB",
+        });
+    arguments.AddKnownArgument("tga-rle", "rle", { "" }, { "write run-length encoded TGA files. One channel noise is written as grayscale" });
+    arguments.AddKnownTextArgument("output", "o", "name of the output files, without extension. Mip levels of TGA files are written to <name>_mip<level>.tga", "output");
+    arguments.AddKnownTextArgument("cache", "ca", "directory of generated files. A job with the same options as a cached one copies its files instead of "
+        "generating them. Batches use the directory given on the command line", "");
+    arguments.AddKnownArgument("strip-height", "sh", {}, { "generate and write the image this many rows at a time, so images larger than memory can be written. DDS files only. Mip levels are box filtered from the top level, so they differ from the mip levels a whole image run generates. 0 keeps the whole image in memory" }, kDefaultStripHeight);
+
+    // Execution parameters
+    arguments.AddKnownArgument("threads", "j", {}, { "number of threads used for generation. 0 uses all hardware threads" }, kDefaultThreadCount);
+    arguments.AddKnownTextArgument("batch", "b", "generate the jobs of a job file on one thread pool and print the time of each job. Every line is a job, "
+        "given as options that are added to the options of the command line. Empty lines and lines starting with # are skipped", "");
+    arguments.AddKnownArgument("profile", "pr", { "" }, { "print the time and the amount of data of every stage once all jobs are done, summed over threads and jobs" });
+    arguments.AddKnownTextArgument("trace", "tr", "write when every thread ran each stage and thread pool band to this file once all jobs are done, as a "
+        "Chrome trace for chrome://tracing or the Perfetto UI", "");
+}
+
+struct Job
+{
+    u32 line;
+    std::vector<std::string> arguments;
+};
+
+static bool readJobs(const std::string& fileName, std::vector<Job>& outJobs)
+{
+    std::ifstream file(fileName);
+    if (!file)
+        return false;
+
+    std::string text;
+    u32 line = 0;
+    while (std::getline(file, text))
     {
-        printOptions(arguments);
-        return 1;
+        ++line;
+        Job job;
+        job.line = line;
+        std::istringstream tokens(text);
+        std::string token;
+        while (tokens >> token)
+            job.arguments.push_back(token);
+
+        if (!job.arguments.empty() && job.arguments[0][0] != '#')
+            outJobs.push_back(std::move(job));
     }
+    return true;
+}
 
-    if (arguments.IsEnabled("run-tests"))
-        return runTests();
-    if (arguments.IsEnabled("help"))
+// The options of a job follow the options of the command line, so options shared by every job can be given once.
+static bool parseJob(i32 argc, const char** argv, const Job& job, ArgumentParser& parser)
+{
+    addArguments(parser);
+    if (!parser.Parse(argc, argv))
+        return false;
+
+    std::vector<const char*> jobArguments;
+    jobArguments.push_back(argv[0]);
+    for (const std::string& argument : job.arguments)
+        jobArguments.push_back(argument.c_str());
+    return parser.Parse(static_cast<i32>(jobArguments.size()), jobArguments.data());
+}
+
+// Runs every job of the job file on the shared thread pool, so lookup tables are built once and images are reused
+// between jobs. All jobs are validated before the first one runs.
+static i32 runBatch(i32 argc, const char** argv, const std::string& jobFileName, ResultCache* cache)
+{
+    std::vector<Job> jobs;
+    if (!readJobs(jobFileName, jobs))
     {
-        printOptions(arguments);
-        return 1;
+        std::cout << "Could not read job file '" << jobFileName << "'." << std::endl;
+        return 2;
     }
 
-    enum class Generator
+    std::vector<std::string> outputs;
+    std::unordered_map<std::string, u32> outputLines;
+    for (const Job& job : jobs)
     {
-        kChecker,
-        kWorley,
-        kWhite,
-        kWavelet,
-        kValue,
-        kPerlin,
-        kModified,
-        kGabor,
-        kBetterGradient,
+        ArgumentParser parser;
+        if (!parseJob(argc, argv, job, parser))
+        {
+            std::cout << "Line " << job.line << " of '" << jobFileName << "' has invalid options." << std::endl;
+            return 2;
+        }
+
+        const char* error = validateJob(parser);
+        if (error != nullptr)
+        {
+            std::cout << "Line " << job.line << " of '" << jobFileName << "': " << error << std::endl;
+            return 2;
+        }
+
+        auto inserted = outputLines.emplace(parser.GetText("output"), job.line);
+        if (!inserted.second)
+        {
+            std::cout << "Lines " << inserted.first->second << " and " << job.line << " of '" << jobFileName << "' both write '" << parser.GetText("output") << "'." << std::endl;
+            return 2;
+        }
+        outputs.push_back(parser.GetText("output"));
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    std::vector<f64> jobMilliseconds(jobs.size());
+    std::vector<u8> isCached(jobs.size());
+    auto runJobs = [&](u32 begin, u32 end)
+    {
+        JobBuffers buffers;
+        for (u32 i = begin; i < end; ++i)
+        {
+            Clock::time_point start = Clock::now();
+            ArgumentParser parser;
+            parseJob(argc, argv, jobs[i], parser);
+            isCached[i] = runCachedJob(parser, cache, buffers);
+            jobMilliseconds[i] = std::chrono::duration<f64, std::milli>(Clock::now() - start).count();
+        }
     };
 
-    u32 numChannels = 1;
+    Clock::time_point start = Clock::now();
+    ThreadPool& pool = ThreadPool::Instance();
+    u32 jobCount = static_cast<u32>(jobs.size());
+    // With at least a job per thread, jobs run side by side, each on a single thread. Fewer jobs run one after the
+    // other, each spread over the whole pool.
+    if (jobCount >= pool.GetThreadCount())
+        pool.ParallelFor(jobCount, runJobs);
+    else
+        runJobs(0, jobCount);
+    f64 totalMilliseconds = std::chrono::duration<f64, std::milli>(Clock::now() - start).count();
+
+    f64 jobSum = 0.0;
+    std::cout << std::fixed << std::setprecision(1);
+    for (u32 i = 0; i < jobCount; ++i)
+    {
+        std::cout << "  line " << jobs[i].line << ", " << outputs[i] << ": " << jobMilliseconds[i] << " ms" << (isCached[i] ? ", cached" : "") << std::endl;
+        jobSum += jobMilliseconds[i];
+    }
+    std::cout << jobCount << " jobs in " << totalMilliseconds << " ms on " << pool.GetThreadCount() << " threads, " << jobSum << " ms summed over jobs." << std::endl;
 
-    Generator selected = arguments.GetValueAs<Generator>("generator");
-    TilingMode tiling = arguments.GetValueAs<TilingMode>("tiling");
+    return 0;
+}
 
-    if (selected == Generator::kWorley)
-        numChannels = 4;
+i32 main(i32 argc, const char** argv)
+{
+    ArgumentParser arguments;
+    addArguments(arguments);
 
-    ImageData* generated = createImage(arguments, numChannels);
-    if (generated == nullptr)
+    if (!arguments.Parse(argc, argv))
     {
-        std::cout << "Incorrect image parameters provided." << std::endl;
         printOptions(arguments);
-        return 2;
+        return 1;
     }
 
-    switch (selected)
+    if (arguments.IsEnabled("run-tests"))
+        return runTests();
+    if (arguments.IsEnabled("help"))
     {
-    case Generator::kChecker:
-        generateChecker(tiling, arguments, *generated);
-        break;
-    case Generator::kWorley:
-        generateWorley(tiling, arguments, *generated);
-        break;
-    case Generator::kWhite:
-        generateWhiteNoise(tiling, *generated);
-        break;
-    case Generator::kWavelet:
-        generateWavelet(tiling, arguments, *generated);
-        break;
-    case Generator::kValue:
-        generateValue(tiling, arguments, *generated);
-        break;
-    case Generator::kPerlin:
-        generatePerlin(tiling, arguments, *generated);
-        break;
-    case Generator::kModified:
-        generateModified(tiling, arguments, *generated);
-        break;
-    case Generator::kGabor:
-        generateGabor(tiling, arguments, *generated);
-        break;
-    case Generator::kBetterGradient:
-        generateBetterGradient(tiling, arguments, *generated);
-        break;
-    };
+        printOptions(arguments);
+        return 1;
+    }
+
+    ThreadPool::Instance().SetThreadCount(arguments.GetValueAs<u32>("threads"));
+    Profiler::SetEnabled(arguments.IsEnabled("profile"));
+    const std::string& traceFileName = arguments.GetText("trace");
+    Profiler::SetTracing(!traceFileName.empty());
 
-    if (numChannels == 1)
+    const std::string& jobFileName = arguments.GetText("batch");
+    if (jobFileName.empty())
     {
-        ImageData* expanded = new ImageData(generated->GetWidth(), generated->GetHeight(), 4, generated->GetMipLevelCount() > 1);
-        ChannelConverter::RToRRR1(*generated, *expanded);
-        expanded->Save("output");
+        const char* error = validateJob(arguments);
+        if (error != nullptr)
+        {
+            std::cout << error << std::endl;
+            printOptions(arguments);
+            return 2;
+        }
+    }
 
-        delete expanded;
+    const std::string& cacheDirectory = arguments.GetText("cache");
+    ResultCache* cache = cacheDirectory.empty() ? nullptr : new ResultCache(cacheDirectory);
+
+    i32 result = 0;
+    if (!jobFileName.empty())
+    {
+        result = runBatch(argc, argv, jobFileName, cache);
     }
     else
     {
-        generated->Save("output");
+        JobBuffers buffers;
+        runCachedJob(arguments, cache, buffers);
     }
-    delete generated;
 
-    return 0;
+    if (cache != nullptr && result == 0)
+        printCacheStats(*cache);
+    if (Profiler::IsEnabled())
+        Profiler::Print();
+    if (Profiler::IsTracing() && !Profiler::WriteTrace(traceFileName))
+        std::cout << "Could not write trace file '" << traceFileName << "'." << std::endl;
+    delete cache;
+
+    return result;
 }
@@ -0,0 +1,398 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "generators/Interpolator.hpp"
+#include "generators/TilingMode.hpp"
+#include "generators/noise/BetterGradientNoise.hpp"
+#include "generators/noise/FractalNoise.hpp"
+#include "generators/noise/GaborNoise.hpp"
+#include "generators/noise/ModifiedNoise.hpp"
+#include "generators/noise/PerlinNoise.hpp"
+#include "generators/noise/ValueNoise.hpp"
+#include "generators/noise/WaveletNoise.hpp"
+#include "generators/noise/WhiteNoise.hpp"
+#include "generators/noise/WorleyNoise.hpp"
+#include "generators/simple/Checker.hpp"
+#include "image/ImageData.hpp"
+#include "utility/ArgumentParser.hpp"
+#include "utility/Simd.hpp"
+#include "utility/ThreadPool.hpp"
+
+// Times every generator of the command line tool over image sizes, lattice or cell sizes, tilings and mipmaps, and
+// prints the throughput of each case. The same results are written as JSON, so builds can be compared.
+
+// Set by the build to the revision being measured.
+#if !defined(NOISE_REVISION)
+#define NOISE_REVISION "unknown"
+#endif
+
+static constexpr u64 kDefaultRepetitions = 7;
+static constexpr u64 kDefaultMinSize = 256;
+static constexpr u64 kDefaultMaxSize = 1024;
+static constexpr u64 kDefaultThreadCount = 0;
+
+static constexpr f32 kPI = 3.1416f;
+
+// The helper types stay local, noise-core defines types of the same names for its own use.
+namespace
+{
+// What the scale of a generator sets. Each has its own set of scales to try.
+enum class Scale
+{
+    kNone,
+    kLattice,
+    kCell,
+    kTile,
+};
+
+// Parameters follow the defaults of the command line tool, except for the scale.
+typedef void (*GenerateFunction)(TilingMode mode, u32 scale, ImageData& data);
+
+struct Generator
+{
+    const char* name;
+    Scale scale;
+    u32 channels;
+    bool hasWang;
+    GenerateFunction generate;
+};
+
+struct Result
+{
+    const Generator* generator;
+    u32 scale;
+    TilingMode tiling;
+    bool mipmaps;
+    u32 size;
+    // Pixels of every mip level.
+    u64 pixels;
+    f64 medianMilliseconds;
+    f64 p95Milliseconds;
+};
+}
+
+template<class Noise>
+static void generate(TilingMode mode, const typename Noise::Parameters& parameters, ImageData& data)
+{
+    switch (mode)
+    {
+    case TilingMode::kSimple:
+        Noise::GenerateSimple(parameters, data);
+        break;
+    case TilingMode::kWang:
+        Noise::GenerateWang(parameters, data);
+        break;
+    }
+}
+
+template<class Noise>
+static void generateLattice(TilingMode mode, u32 scale, ImageData& data)
+{
+    typename Noise::Parameters parameters = {};
+    parameters.latticeWidth = scale;
+    parameters.latticeHeight = scale;
+    generate<Noise>(mode, parameters, data);
+}
+
+static void generateValue(TilingMode mode, u32 scale, ImageData& data)
+{
+    ValueNoise<LinearInterpolator>::Parameters parameters = {};
+    parameters.latticeWidth = scale;
+    parameters.latticeHeight = scale;
+    parameters.rangeMin = 0.0f;
+    parameters.rangeMax = 1.0f;
+    generate<ValueNoise<LinearInterpolator>>(mode, parameters, data);
+}
+
+static void generateChecker(TilingMode mode, u32 scale, ImageData& data)
+{
+    Checker::Parameters parameters;
+    parameters.tileWidth = scale;
+    parameters.tileHeight = scale;
+    parameters.brightMax = 1.0f;
+    parameters.brightMin = 192.0f / 255.0f;
+    parameters.darkMax = 64.0f / 255.0f;
+    parameters.darkMin = 0.0f;
+    generate<Checker>(mode, parameters, data);
+}
+
+static void generateWorley(TilingMode mode, u32 scale, ImageData& data)
+{
+    WorleyNoise::Parameters parameters;
+    parameters.minPointsPerCell = 2;
+    parameters.maxPointsPerCell = 2;
+    parameters.cellSize = scale;
+    parameters.cellsPerRow = data.GetWidth() / scale;
+    parameters.cellLayers = 0;
+    parameters.cellIndexOffset = 1;
+    parameters.rMul = 1.0f;
+    parameters.gMul = 1.0f;
+    parameters.bMul = 1.0f;
+    parameters.rAdd = 0.0f;
+    parameters.gAdd = 0.0f;
+    parameters.bAdd = 0.0f;
+    generate<WorleyNoise>(mode, parameters, data);
+}
+
+template<WhiteNoise::Hash kHash>
+static void generateWhite(TilingMode mode, u32 /*scale*/, ImageData& data)
+{
+    WhiteNoise::Parameters parameters;
+    parameters.hash = kHash;
+    generate<WhiteNoise>(mode, parameters, data);
+}
+
+template<GaborNoise::Precision kPrecision>
+static void generateGabor(TilingMode mode, u32 scale, ImageData& data)
+{
+    GaborNoise::Parameters parameters;
+    parameters.cellOffset = 1;
+    parameters.cellSize = static_cast<f32>(scale);
+    parameters.frequencyMagnitudeMax = 0.05f * kPI;
+    parameters.frequencyMagnitudeMin = 0.05f * kPI;
+    parameters.frequencyOrientationMax = 2.0f * kPI;
+    parameters.frequencyOrientationMin = 0.0f;
+    parameters.gaussianMagnitude = 0.1f;
+    parameters.gaussianWidth = kPI / (parameters.cellSize * parameters.cellSize);
+    parameters.numberOfImpulsesPerCell = 2;
+    parameters.numberOfImpulsesPerCellCap = 2;
+    parameters.precision = kPrecision;
+    parameters.cellsPerRow = data.GetWidth() / scale;
+    generate<GaborNoise>(mode, parameters, data);
+}
+
+static void generatePerlinFbm(TilingMode /*mode*/, u32 scale, ImageData& data)
+{
+    FractalNoise<PerlinNoise<FifthOrderInterpolator>>::Parameters parameters;
+    parameters.noise.latticeWidth = scale;
+    parameters.noise.latticeHeight = scale;
+    parameters.noise.latticeDepth = 1;
+    parameters.mode = FractalNoise<PerlinNoise<FifthOrderInterpolator>>::Mode::kFbm;
+    parameters.octaveCount = 4;
+    parameters.lacunarity = 2.0f;
+    parameters.gain = 0.5f;
+    FractalNoise<PerlinNoise<FifthOrderInterpolator>>::GenerateSimple(parameters, data);
+}
+
+static const Generator kGenerators[] = {
+    { "checker", Scale::kTile, 1, true, generateChecker },
+    { "worley", Scale::kCell, 4, true, generateWorley },
+    { "white-md5", Scale::kNone, 1, true, generateWhite<WhiteNoise::Hash::kMd5> },
+    { "white-pcg", Scale::kNone, 1, true, generateWhite<WhiteNoise::Hash::kPcg> },
+    { "white-philox", Scale::kNone, 1, true, generateWhite<WhiteNoise::Hash::kPhilox> },
+    { "wavelet", Scale::kLattice, 1, true, generateLattice<WaveletNoise<FifthOrderInterpolator>> },
+    { "value", Scale::kLattice, 1, true, generateValue },
+    { "perlin", Scale::kLattice, 1, true, generateLattice<PerlinNoise<FifthOrderInterpolator>> },
+    { "modified", Scale::kLattice, 1, true, generateLattice<ModifiedNoise<FifthOrderInterpolator>> },
+    { "gabor", Scale::kCell, 1, true, generateGabor<GaborNoise::Precision::kExact> },
+    { "gabor-fast", Scale::kCell, 1, true, generateGabor<GaborNoise::Precision::kFast> },
+    { "better", Scale::kLattice, 1, true, generateLattice<BetterGradientNoise<FifthOrderInterpolator>> },
+    { "perlin-fbm", Scale::kLattice, 1, false, generatePerlinFbm },
+};
+
+static std::vector<u32> getScales(Scale scale)
+{
+    switch (scale)
+    {
+    case Scale::kLattice:
+        return { 8, 32 };
+    case Scale::kCell:
+        return { 16, 32 };
+    case Scale::kTile:
+        return { 16, 64 };
+    default:
+        return { 0 };
+    }
+}
+
+static const char* getScaleName(Scale scale)
+{
+    switch (scale)
+    {
+    case Scale::kLattice:
+        return "lattice";
+    case Scale::kCell:
+        return "cell";
+    case Scale::kTile:
+        return "tile";
+    default:
+        return "none";
+    }
+}
+
+static u64 countPixels(const ImageData& image)
+{
+    u64 pixels = 0;
+    for (u32 mip = 0; mip < image.GetMipLevelCount(); ++mip)
+    {
+        u32 w;
+        u32 h;
+        image.GetDimensions(w, h, mip);
+        pixels += static_cast<u64>(w) * h;
+    }
+    return pixels;
+}
+
+// The element at the given fraction of the sorted times, by the nearest rank.
+static f64 getPercentile(const std::vector<f64>& sortedTimes, f64 fraction)
+{
+    u64 rank = static_cast<u64>(fraction * static_cast<f64>(sortedTimes.size()) + 0.999999);
+    rank = rank > 0 ? rank : 1;
+    return sortedTimes[rank - 1];
+}
+
+static Result measure(const Generator& generator, u32 scale, TilingMode tiling, bool mipmaps, u32 size, u32 repetitions)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    // The image is allocated once, generators write all of its pixels. The first run builds lookup tables and touches
+    // the pages of the image, so it is not timed.
+    ImageData image(size, size, generator.channels, mipmaps, false);
+    generator.generate(tiling, scale, image);
+
+    std::vector<f64> times;
+    for (u32 i = 0; i < repetitions; ++i)
+    {
+        Clock::time_point start = Clock::now();
+        generator.generate(tiling, scale, image);
+        times.push_back(std::chrono::duration<f64, std::milli>(Clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+
+    Result result;
+    result.generator = &generator;
+    result.scale = scale;
+    result.tiling = tiling;
+    result.mipmaps = mipmaps;
+    result.size = size;
+    result.pixels = countPixels(image);
+    u32 middle = repetitions / 2;
+    result.medianMilliseconds = repetitions % 2 == 1 ? times[middle] : 0.5 * (times[middle - 1] + times[middle]);
+    result.p95Milliseconds = getPercentile(times, 0.95);
+    return result;
+}
+
+static f64 getMegapixelsPerSecond(const Result& result)
+{
+    return static_cast<f64>(result.pixels) / (result.medianMilliseconds * 1000.0);
+}
+
+static void printResult(const Result& result)
+{
+    std::cout << std::left << std::setw(14) << result.generator->name
+        << std::setw(8) << (result.tiling == TilingMode::kSimple ? "simple" : "wang")
+        << std::setw(6) << (result.mipmaps ? "mips" : "-")
+        << std::right << std::setw(6) << result.size
+        << std::setw(9) << getScaleName(result.generator->scale) << std::setw(4) << result.scale
+        << std::fixed << std::setprecision(3)
+        << std::setw(12) << result.medianMilliseconds
+        << std::setw(12) << result.p95Milliseconds
+        << std::setprecision(1) << std::setw(12) << getMegapixelsPerSecond(result) << std::endl;
+}
+
+static bool writeJson(const std::string& fileName, const std::vector<Result>& results, u32 repetitions)
+{
+    std::ofstream file(fileName);
+    if (!file)
+        return false;
+
+    file << "{\n";
+    file << "  \"revision\": \"" << NOISE_REVISION << "\",\n";
+    file << "  \"simd\": \"" << (NOISE_SIMD_AVX512 ? "avx512" : NOISE_SIMD_AVX2 ? "avx2" : NOISE_SIMD_SSE2 ? "sse2" : "scalar") << "\",\n";
+    file << "  \"threads\": " << ThreadPool::Instance().GetThreadCount() << ",\n";
+    file << "  \"repetitions\": " << repetitions << ",\n";
+    file << "  \"results\": [\n";
+    file << std::fixed << std::setprecision(4);
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Result& result = results[i];
+        file << "    { \"generator\": \"" << result.generator->name << "\""
+            << ", \"tiling\": \"" << (result.tiling == TilingMode::kSimple ? "simple" : "wang") << "\""
+            << ", \"mipmaps\": " << (result.mipmaps ? "true" : "false")
+            << ", \"size\": " << result.size
+            << ", \"scale\": \"" << getScaleName(result.generator->scale) << "\""
+            << ", \"scaleSize\": " << result.scale
+            << ", \"pixels\": " << result.pixels
+            << ", \"medianMs\": " << result.medianMilliseconds
+            << ", \"p95Ms\": " << result.p95Milliseconds
+            << ", \"mpixelsPerSecond\": " << getMegapixelsPerSecond(result)
+            << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n";
+    file << "}\n";
+    return file.good();
+}
+
+i32 main(i32 argc, const char** argv)
+{
+    ArgumentParser arguments;
+    arguments.AddKnownArgument("help", "h", { "" }, { "print options" });
+    arguments.AddKnownArgument("repetitions", "r", {}, { "timed runs of every case, after one untimed run. Must be greater than 0" }, kDefaultRepetitions);
+    arguments.AddKnownArgument("min-size", "mins", {}, { "width and height of the smallest image. Sizes double up to the largest one. Must be a power of 2 of at least 256, so Wang tiles hold whole cells" }, kDefaultMinSize);
+    arguments.AddKnownArgument("max-size", "maxs", {}, { "width and height of the largest image" }, kDefaultMaxSize);
+    arguments.AddKnownTextArgument("filter", "f", "only time generators whose name contains this text", "");
+    arguments.AddKnownTextArgument("json", "js", "file the results are written to as JSON", "benchmark.json");
+    arguments.AddKnownArgument("threads", "j", {}, { "number of threads used for generation. 0 uses all hardware threads" }, kDefaultThreadCount);
+
+    if (!arguments.Parse(argc, argv) || arguments.IsEnabled("help"))
+    {
+        std::cout << "Options:" << std::endl;
+        arguments.PrintOptions();
+        return 1;
+    }
+
+    u32 repetitions = arguments.GetValueAs<u32>("repetitions");
+    u32 minSize = arguments.GetValueAs<u32>("min-size");
+    u32 maxSize = arguments.GetValueAs<u32>("max-size");
+    if (repetitions == 0 || minSize < 256 || (minSize & (minSize - 1)) != 0)
+    {
+        std::cout << "Incorrect benchmark parameters provided." << std::endl;
+        arguments.PrintOptions();
+        return 2;
+    }
+
+    ThreadPool::Instance().SetThreadCount(arguments.GetValueAs<u32>("threads"));
+    const std::string& filter = arguments.GetText("filter");
+
+    std::cout << std::left << std::setw(14) << "generator" << std::setw(8) << "tiling" << std::setw(6) << "mips"
+        << std::right << std::setw(6) << "size" << std::setw(13) << "scale"
+        << std::setw(12) << "median ms" << std::setw(12) << "p95 ms" << std::setw(12) << "Mpixel/s" << std::endl;
+
+    std::vector<Result> results;
+    for (const Generator& generator : kGenerators)
+    {
+        if (std::string(generator.name).find(filter) == std::string::npos)
+            continue;
+
+        for (u32 size = minSize; size <= maxSize; size *= 2)
+        {
+            for (u32 scale : getScales(generator.scale))
+            {
+                for (TilingMode tiling : { TilingMode::kSimple, TilingMode::kWang })
+                {
+                    if (tiling == TilingMode::kWang && !generator.hasWang)
+                        continue;
+
+                    for (bool mipmaps : { false, true })
+                    {
+                        results.push_back(measure(generator, scale, tiling, mipmaps, size, repetitions));
+                        printResult(results.back());
+                    }
+                }
+            }
+        }
+    }
+
+    const std::string& jsonFileName = arguments.GetText("json");
+    if (!writeJson(jsonFileName, results, repetitions))
+    {
+        std::cout << "Could not write '" << jsonFileName << "'." << std::endl;
+        return 2;
+    }
+    return 0;
+}
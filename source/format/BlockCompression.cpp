@@ -0,0 +1,269 @@
+#include "BlockCompression.hpp"
+
+#include "utility/Simd.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+static constexpr u32 kBlockPixelCount = 16;
+// Position of a value on the ramp from the smaller to the larger endpoint, turned into the index stored in the block.
+static constexpr u8 kBC4RampToIndex[8] = { 1, 7, 6, 5, 4, 3, 2, 0 };
+static constexpr u8 kBC1RampToIndex[4] = { 1, 3, 2, 0 };
+
+static u32 quantize(f32 value, f32 scale)
+{
+	f32 scaled = value * scale;
+	return static_cast<u32>(floor(scaled + 0.5f));
+}
+
+static void loadBlock(const f32* pixels, u32 width, u32 height, u32 channels, u32 channel, u32 blockX, u32 blockY, f32* values)
+{
+	for (u32 y = 0; y < BlockCompressor::kBlockDimension; ++y)
+	{
+		u32 pixelY = blockY * BlockCompressor::kBlockDimension + y;
+		pixelY = pixelY < height ? pixelY : height - 1;
+		for (u32 x = 0; x < BlockCompressor::kBlockDimension; ++x)
+		{
+			u32 pixelX = blockX * BlockCompressor::kBlockDimension + x;
+			pixelX = pixelX < width ? pixelX : width - 1;
+			f32 value = pixels[(static_cast<u64>(pixelY) * width + pixelX) * channels + channel];
+			values[y * BlockCompressor::kBlockDimension + x] = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+		}
+	}
+}
+
+#if NOISE_SIMD_AVX2
+static f32 horizontalMin(__m256 a, __m256 b)
+{
+	__m256 m = _mm256_min_ps(a, b);
+	__m128 h = _mm_min_ps(_mm256_castps256_ps128(m), _mm256_extractf128_ps(m, 1));
+	h = _mm_min_ps(h, _mm_movehl_ps(h, h));
+	h = _mm_min_ss(h, _mm_movehdup_ps(h));
+	return _mm_cvtss_f32(h);
+}
+
+static f32 horizontalMax(__m256 a, __m256 b)
+{
+	__m256 m = _mm256_max_ps(a, b);
+	__m128 h = _mm_max_ps(_mm256_castps256_ps128(m), _mm256_extractf128_ps(m, 1));
+	h = _mm_max_ps(h, _mm_movehl_ps(h, h));
+	h = _mm_max_ss(h, _mm_movehdup_ps(h));
+	return _mm_cvtss_f32(h);
+}
+#endif
+
+static void findRange(const f32* values, f32& minimum, f32& maximum)
+{
+#if NOISE_SIMD_AVX2
+	__m256 low = _mm256_loadu_ps(values);
+	__m256 high = _mm256_loadu_ps(values + 8);
+	minimum = horizontalMin(low, high);
+	maximum = horizontalMax(low, high);
+#else
+	minimum = values[0];
+	maximum = values[0];
+	for (u32 i = 1; i < kBlockPixelCount; ++i)
+	{
+		minimum = values[i] < minimum ? values[i] : minimum;
+		maximum = values[i] > maximum ? values[i] : maximum;
+	}
+#endif
+}
+
+u32 BlockCompressor::GetBlockSize(u32 channels)
+{
+	assert(channels == 1 || channels == 2 || channels == 4);
+	return channels == 2 ? 16 : 8;
+}
+
+void BlockCompressor::CompressBlockRow(const f32* pixels, u32 width, u32 height, u32 channels, u32 blockRow, u8* destination)
+{
+	const u32 blockCount = GetBlockCount(width);
+	const u32 blockSize = GetBlockSize(channels);
+	alignas(32) f32 values[4][kBlockPixelCount];
+
+	for (u32 blockX = 0; blockX < blockCount; ++blockX)
+	{
+		u32 usedChannels = channels < 3 ? channels : 3;
+		for (u32 channel = 0; channel < usedChannels; ++channel)
+			loadBlock(pixels, width, height, channels, channel, blockX, blockRow, values[channel]);
+
+		u8* block = destination + blockX * blockSize;
+		if (channels == 1)
+		{
+			CompressBC4(values[0], block);
+		}
+		else if (channels == 2)
+		{
+			CompressBC4(values[0], block);
+			CompressBC4(values[1], block + 8);
+		}
+		else
+		{
+			CompressBC1(values[0], values[1], values[2], block);
+		}
+	}
+}
+
+void BlockCompressor::CompressBC4(const f32* values, u8* destination)
+{
+	f32 minimum;
+	f32 maximum;
+	findRange(values, minimum, maximum);
+
+	// The larger endpoint comes first, which selects 6 interpolated values between the endpoints.
+	const u32 first = quantize(maximum, 255.0f);
+	const u32 second = quantize(minimum, 255.0f);
+	destination[0] = static_cast<u8>(first);
+	destination[1] = static_cast<u8>(second);
+	memset(destination + 2, 0, 6);
+	if (first == second)
+		return;
+
+	const f32 scale = 7.0f / static_cast<f32>(first - second);
+	const f32 offset = static_cast<f32>(second);
+	alignas(32) i32 ramp[kBlockPixelCount];
+#if NOISE_SIMD_AVX2
+	for (u32 i = 0; i < kBlockPixelCount; i += 8)
+	{
+		__m256 t = _mm256_sub_ps(_mm256_mul_ps(_mm256_loadu_ps(values + i), _mm256_set1_ps(255.0f)), _mm256_set1_ps(offset));
+		t = _mm256_floor_ps(_mm256_add_ps(_mm256_mul_ps(t, _mm256_set1_ps(scale)), _mm256_set1_ps(0.5f)));
+		__m256i position = _mm256_cvttps_epi32(t);
+		position = _mm256_min_epi32(_mm256_max_epi32(position, _mm256_setzero_si256()), _mm256_set1_epi32(7));
+		_mm256_store_si256(reinterpret_cast<__m256i*>(ramp + i), position);
+	}
+#else
+	for (u32 i = 0; i < kBlockPixelCount; ++i)
+	{
+		f32 t = values[i] * 255.0f;
+		t = t - offset;
+		t = t * scale;
+		i32 position = static_cast<i32>(floor(t + 0.5f));
+		ramp[i] = position < 0 ? 0 : (position > 7 ? 7 : position);
+	}
+#endif
+
+	// 16 indices of 3 bits, the first pixel in the lowest bits.
+	u64 indices = 0;
+	for (u32 i = 0; i < kBlockPixelCount; ++i)
+		indices |= static_cast<u64>(kBC4RampToIndex[ramp[i]]) << (i * 3);
+	for (u32 i = 0; i < 6; ++i)
+		destination[2 + i] = static_cast<u8>(indices >> (i * 8));
+}
+
+void BlockCompressor::CompressBC1(const f32* red, const f32* green, const f32* blue, u8* destination)
+{
+	const f32* channels[3] = { red, green, blue };
+	f32 minimum[3];
+	f32 maximum[3];
+	for (u32 c = 0; c < 3; ++c)
+	{
+		findRange(channels[c], minimum[c], maximum[c]);
+		// Moving the endpoints inwards by 1/16 of the range lowers the average error of the interpolated colors.
+		f32 inset = (maximum[c] - minimum[c]) * (1.0f / 16.0f);
+		minimum[c] += inset;
+		maximum[c] -= inset;
+	}
+
+	// The bounding box diagonal follows red. Green and blue are flipped when they fall while red rises.
+	const f32 centerRed = (minimum[0] + maximum[0]) * 0.5f;
+	for (u32 c = 1; c < 3; ++c)
+	{
+		f32 center = (minimum[c] + maximum[c]) * 0.5f;
+		f32 covariance = 0.0f;
+		for (u32 i = 0; i < kBlockPixelCount; ++i)
+		{
+			f32 product = (red[i] - centerRed) * (channels[c][i] - center);
+			covariance += product;
+		}
+		if (covariance < 0.0f)
+		{
+			f32 swap = minimum[c];
+			minimum[c] = maximum[c];
+			maximum[c] = swap;
+		}
+	}
+
+	static constexpr f32 kScales[3] = { 31.0f, 63.0f, 31.0f };
+	u32 first[3];
+	u32 second[3];
+	for (u32 c = 0; c < 3; ++c)
+	{
+		first[c] = quantize(maximum[c], kScales[c]);
+		second[c] = quantize(minimum[c], kScales[c]);
+	}
+	u32 firstColor = (first[0] << 11) | (first[1] << 5) | first[2];
+	u32 secondColor = (second[0] << 11) | (second[1] << 5) | second[2];
+	// The first color must be the larger one, equal colors would select the mode with transparent black.
+	if (firstColor < secondColor)
+	{
+		u32 swap = firstColor;
+		firstColor = secondColor;
+		secondColor = swap;
+		for (u32 c = 0; c < 3; ++c)
+		{
+			swap = first[c];
+			first[c] = second[c];
+			second[c] = swap;
+		}
+	}
+
+	destination[0] = static_cast<u8>(firstColor);
+	destination[1] = static_cast<u8>(firstColor >> 8);
+	destination[2] = static_cast<u8>(secondColor);
+	destination[3] = static_cast<u8>(secondColor >> 8);
+	memset(destination + 4, 0, 4);
+	if (firstColor == secondColor)
+		return;
+
+	// Every pixel is projected onto the line between the quantized endpoints.
+	f32 start[3];
+	f32 direction[3];
+	f32 lengthSquared = 0.0f;
+	for (u32 c = 0; c < 3; ++c)
+	{
+		start[c] = static_cast<f32>(second[c]) / kScales[c];
+		direction[c] = static_cast<f32>(first[c]) / kScales[c] - start[c];
+		f32 square = direction[c] * direction[c];
+		lengthSquared += square;
+	}
+	const f32 scale = 3.0f / lengthSquared;
+
+	alignas(32) i32 ramp[kBlockPixelCount];
+#if NOISE_SIMD_AVX2
+	for (u32 i = 0; i < kBlockPixelCount; i += 8)
+	{
+		__m256 dot = _mm256_setzero_ps();
+		for (u32 c = 0; c < 3; ++c)
+		{
+			__m256 offset = _mm256_sub_ps(_mm256_loadu_ps(channels[c] + i), _mm256_set1_ps(start[c]));
+			dot = _mm256_add_ps(dot, _mm256_mul_ps(offset, _mm256_set1_ps(direction[c])));
+		}
+		__m256 t = _mm256_floor_ps(_mm256_add_ps(_mm256_mul_ps(dot, _mm256_set1_ps(scale)), _mm256_set1_ps(0.5f)));
+		__m256i position = _mm256_cvttps_epi32(t);
+		position = _mm256_min_epi32(_mm256_max_epi32(position, _mm256_setzero_si256()), _mm256_set1_epi32(3));
+		_mm256_store_si256(reinterpret_cast<__m256i*>(ramp + i), position);
+	}
+#else
+	for (u32 i = 0; i < kBlockPixelCount; ++i)
+	{
+		f32 dot = 0.0f;
+		for (u32 c = 0; c < 3; ++c)
+		{
+			f32 product = (channels[c][i] - start[c]) * direction[c];
+			dot += product;
+		}
+		f32 t = dot * scale;
+		i32 position = static_cast<i32>(floor(t + 0.5f));
+		ramp[i] = position < 0 ? 0 : (position > 3 ? 3 : position);
+	}
+#endif
+
+	// 16 indices of 2 bits, the first pixel in the lowest bits.
+	u32 indices = 0;
+	for (u32 i = 0; i < kBlockPixelCount; ++i)
+		indices |= static_cast<u32>(kBC1RampToIndex[ramp[i]]) << (i * 2);
+	for (u32 i = 0; i < 4; ++i)
+		destination[4 + i] = static_cast<u8>(indices >> (i * 8));
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "utility/Types.hpp"
+
+// Encodes 4x4 pixel blocks straight from f32 pixels: BC4 for one channel, BC5 for two and BC1 for RGB(A) images.
+// Blocks past the right or bottom edge repeat the edge pixels.
+struct BlockCompressor final
+{
+	static constexpr u32 kBlockDimension = 4;
+
+	static u32 GetBlockSize(u32 channels);
+	static u32 GetBlockCount(u32 size) { return (size + kBlockDimension - 1) / kBlockDimension; }
+
+	// Encodes one row of blocks, blockRow counts 4 pixel high rows from the top.
+	static void CompressBlockRow(const f32* pixels, u32 width, u32 height, u32 channels, u32 blockRow, u8* destination);
+
+	// Encode a single block of 16 values in [0; 1], row by row.
+	static void CompressBC4(const f32* values, u8* destination);
+	static void CompressBC1(const f32* red, const f32* green, const f32* blue, u8* destination);
+};
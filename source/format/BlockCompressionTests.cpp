@@ -0,0 +1,207 @@
+#include "BlockCompression.hpp"
+
+#include "testing/TestFixture.hpp"
+#include "testing/TestRunner.hpp"
+#include "testing/TestSuite.hpp"
+
+#include <cmath>
+#include <vector>
+
+// Category 1: BC4
+// 1.1: Constant block, decodes to the value
+// 1.2: Gradient block, decodes within half a palette step
+// 1.3: Image smaller than a block, edge pixels repeated
+// Category 2: BC1
+// 2.1: Constant color, never selects the transparent mode
+// 2.2: Two colors on the endpoints, decode within 565 precision
+// 2.3: Four channel image, one block per 4x4 pixels
+
+struct BlockCompressionFixture
+{
+	u8 block[16] = {};
+	f32 decoded[16][3] = {};
+
+	void DecodeBC4(const u8* data)
+	{
+		f32 palette[8];
+		palette[0] = data[0] / 255.0f;
+		palette[1] = data[1] / 255.0f;
+		for (u32 i = 2; i < 8; ++i)
+		{
+			palette[i] = data[0] > data[1] ?
+				((8 - i) * data[0] + (i - 1) * data[1]) / (7.0f * 255.0f) :
+				((6 - i) * data[0] + (i - 1) * data[1]) / (5.0f * 255.0f);
+		}
+		if (data[0] <= data[1])
+		{
+			palette[6] = 0.0f;
+			palette[7] = 1.0f;
+		}
+
+		u64 indices = 0;
+		for (u32 i = 0; i < 6; ++i)
+			indices |= static_cast<u64>(data[2 + i]) << (i * 8);
+		for (u32 i = 0; i < 16; ++i)
+			decoded[i][0] = palette[(indices >> (i * 3)) & 7];
+	}
+
+	void DecodeBC1(const u8* data)
+	{
+		u32 colors[2] = { static_cast<u32>(data[0] | (data[1] << 8)), static_cast<u32>(data[2] | (data[3] << 8)) };
+		f32 palette[4][3];
+		for (u32 i = 0; i < 2; ++i)
+		{
+			palette[i][0] = (colors[i] >> 11) / 31.0f;
+			palette[i][1] = ((colors[i] >> 5) & 63) / 63.0f;
+			palette[i][2] = (colors[i] & 31) / 31.0f;
+		}
+		for (u32 c = 0; c < 3; ++c)
+		{
+			palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+			palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+		}
+
+		u32 indices = data[4] | (data[5] << 8u) | (data[6] << 16u) | (data[7] << 24u);
+		for (u32 i = 0; i < 16; ++i)
+		{
+			for (u32 c = 0; c < 3; ++c)
+				decoded[i][c] = palette[(indices >> (i * 2)) & 3][c];
+		}
+	}
+
+	bool IsFourColorMode() const
+	{
+		return (block[0] | (block[1] << 8u)) > (block[2] | (block[3] << 8u));
+	}
+};
+
+// Category 1: BC4
+TEST_SUITE(BlockCompression_BC4)
+{
+	// 1.1: Constant block, decodes to the value
+	TEST_FIXTURE(BlockCompressionFixture, ConstantBlock_CompressBC4_DecodesToValue)
+	{
+		f32 values[16];
+		for (u32 i = 0; i < 16; ++i)
+			values[i] = 0.4f;
+
+		BlockCompressor::CompressBC4(values, block);
+		DecodeBC4(block);
+
+		bool matches = true;
+		for (u32 i = 0; i < 16; ++i)
+			matches = matches && fabsf(decoded[i][0] - 0.4f) <= 0.5f / 255.0f;
+		Check(matches);
+	}
+
+	// 1.2: Gradient block, decodes within half a palette step
+	TEST_FIXTURE(BlockCompressionFixture, GradientBlock_CompressBC4_DecodesWithinHalfStep)
+	{
+		f32 values[16];
+		for (u32 i = 0; i < 16; ++i)
+			values[i] = 0.2f + i * 0.03f;
+
+		BlockCompressor::CompressBC4(values, block);
+		DecodeBC4(block);
+
+		const f32 step = (values[15] - values[0]) / 7.0f;
+		bool matches = true;
+		for (u32 i = 0; i < 16; ++i)
+			matches = matches && fabsf(decoded[i][0] - values[i]) <= step * 0.5f + 1.0f / 255.0f;
+		Check(matches);
+	}
+
+	// 1.3: Image smaller than a block, edge pixels repeated
+	TEST_FIXTURE(BlockCompressionFixture, TwoByTwoImage_CompressBlockRow_EdgesRepeated)
+	{
+		const f32 pixels[] = { 0.0f, 1.0f, 1.0f, 0.0f };
+
+		BlockCompressor::CompressBlockRow(pixels, 2, 2, 1, 0, block);
+		DecodeBC4(block);
+
+		bool matches = true;
+		for (u32 y = 0; y < 4; ++y)
+		{
+			for (u32 x = 0; x < 4; ++x)
+			{
+				f32 expected = pixels[(y < 2 ? y : 1) * 2 + (x < 2 ? x : 1)];
+				matches = matches && decoded[y * 4 + x][0] == expected;
+			}
+		}
+		Check(matches);
+	}
+}
+
+// Category 2: BC1
+TEST_SUITE(BlockCompression_BC1)
+{
+	// 2.1: Constant color, never selects the transparent mode
+	TEST_FIXTURE(BlockCompressionFixture, ConstantColor_CompressBC1_OpaqueAndClose)
+	{
+		f32 red[16];
+		f32 green[16];
+		f32 blue[16];
+		for (u32 i = 0; i < 16; ++i)
+		{
+			red[i] = 0.3f;
+			green[i] = 0.6f;
+			blue[i] = 0.9f;
+		}
+
+		BlockCompressor::CompressBC1(red, green, blue, block);
+		DecodeBC1(block);
+
+		u32 indices = block[4] | (block[5] << 8u) | (block[6] << 16u) | (block[7] << 24u);
+		Check(IsFourColorMode() || indices == 0);
+		Check(fabsf(decoded[0][0] - 0.3f) <= 0.5f / 31.0f);
+		Check(fabsf(decoded[0][1] - 0.6f) <= 0.5f / 63.0f);
+		Check(fabsf(decoded[0][2] - 0.9f) <= 0.5f / 31.0f);
+	}
+
+	// 2.2: Two colors on the endpoints, decode within 565 precision
+	TEST_FIXTURE(BlockCompressionFixture, TwoColors_CompressBC1_DecodesClose)
+	{
+		f32 red[16];
+		f32 green[16];
+		f32 blue[16];
+		for (u32 i = 0; i < 16; ++i)
+		{
+			bool bright = (i % 3) == 0;
+			red[i] = bright ? 1.0f : 0.0f;
+			green[i] = bright ? 0.0f : 1.0f;
+			blue[i] = bright ? 1.0f : 0.0f;
+		}
+
+		BlockCompressor::CompressBC1(red, green, blue, block);
+		DecodeBC1(block);
+
+		bool matches = IsFourColorMode();
+		for (u32 i = 0; i < 16; ++i)
+		{
+			matches = matches && fabsf(decoded[i][0] - red[i]) <= 0.2f;
+			matches = matches && fabsf(decoded[i][1] - green[i]) <= 0.2f;
+			matches = matches && fabsf(decoded[i][2] - blue[i]) <= 0.2f;
+		}
+		Check(matches);
+	}
+
+	// 2.3: Four channel image, one block per 4x4 pixels
+	TEST_FIXTURE(BlockCompressionFixture, FourChannelImage_CompressBlockRow_BlockPerFourPixels)
+	{
+		const u32 width = 8;
+		std::vector<f32> pixels(width * 4 * 4, 0.0f);
+		for (u32 y = 0; y < 4; ++y)
+		{
+			for (u32 x = 4; x < width; ++x)
+				pixels[(y * width + x) * 4 + 1] = 1.0f;
+		}
+		u8 blocks[16];
+
+		BlockCompressor::CompressBlockRow(pixels.data(), width, 4, 4, 0, blocks);
+
+		DecodeBC1(blocks);
+		Check(decoded[0][1] == 0.0f);
+		DecodeBC1(blocks + 8);
+		Check(decoded[0][1] == 1.0f);
+	}
+}
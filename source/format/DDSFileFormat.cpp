@@ -0,0 +1,218 @@
+#include "DDSFileFormat.hpp"
+
+#include "BlockCompression.hpp"
+#include "image/ImageData.hpp"
+#include "utility/Profiler.hpp"
+#include "utility/Simd.hpp"
+#include "utility/ThreadPool.hpp"
+#include "utility/Unorm8.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+static constexpr u32 kMagic = 0x20534444; // "DDS "
+static constexpr u32 kFourCCDx10 = 0x30315844; // "DX10"
+
+static constexpr u32 kFlagCaps = 0x1;
+static constexpr u32 kFlagHeight = 0x2;
+static constexpr u32 kFlagWidth = 0x4;
+static constexpr u32 kFlagPitch = 0x8;
+static constexpr u32 kFlagPixelFormat = 0x1000;
+static constexpr u32 kFlagMipMapCount = 0x20000;
+static constexpr u32 kFlagLinearSize = 0x80000;
+static constexpr u32 kFlagDepth = 0x800000;
+static constexpr u32 kPixelFormatFlagFourCC = 0x4;
+static constexpr u32 kCapsComplex = 0x8;
+static constexpr u32 kCapsTexture = 0x1000;
+static constexpr u32 kCapsMipMap = 0x400000;
+static constexpr u32 kCaps2Volume = 0x200000;
+static constexpr u32 kResourceDimensionTexture2D = 3;
+static constexpr u32 kResourceDimensionTexture3D = 4;
+
+static constexpr u64 kChunkSize = 4 * 1024 * 1024;
+
+void DDSFileFormat::Save(const ImageData& image, PixelFormat format, const std::string& fileName)
+{
+	PROFILE_SCOPE_BYTES("save dds", image.GetByteCount());
+	const u32 channels = image.GetChannelCount();
+	const u32 mipCount = image.GetMipLevelCount();
+
+	std::ofstream file;
+	file.open(fileName.c_str(), std::ios::binary);
+	WriteHeader(file, image.GetWidth(), image.GetHeight(), 0, channels, mipCount, format);
+
+	for (u32 mip = 0; mip < mipCount; ++mip)
+	{
+		u32 width;
+		u32 height;
+		image.GetDimensions(width, height, mip);
+		WriteRows(file, image.GetPixels(mip), width, height, channels, format);
+	}
+}
+
+u16 DDSFileFormat::ToHalf(f32 value)
+{
+	u32 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	const u32 sign = (bits >> 16) & 0x8000;
+	const u32 magnitude = bits & 0x7FFFFFFF;
+
+	// NaNs stay quiet NaNs, infinities and values that round past 65504 become infinity.
+	if (magnitude > 0x7F800000)
+		return static_cast<u16>(sign | 0x7E00 | ((magnitude >> 13) & 0x3FF));
+	if (magnitude >= 0x477FF000)
+		return static_cast<u16>(sign | 0x7C00);
+
+	u32 result;
+	u32 shift;
+	if (magnitude >= 0x38800000)
+	{
+		// Normal: rebias the exponent from 127 to 15.
+		result = magnitude - 0x38000000;
+		shift = 13;
+	}
+	else
+	{
+		// Subnormal: the implicit bit moves into the mantissa, values below half the smallest subnormal become 0.
+		u32 exponent = magnitude >> 23;
+		if (exponent < 102)
+			return static_cast<u16>(sign);
+		result = (magnitude & 0x7FFFFF) | 0x800000;
+		shift = 126 - exponent;
+	}
+
+	const u32 remainder = result & ((1u << shift) - 1);
+	const u32 halfway = 1u << (shift - 1);
+	result >>= shift;
+	if (remainder > halfway || (remainder == halfway && (result & 1) != 0))
+		++result;
+	return static_cast<u16>(sign | result);
+}
+
+u32 DDSFileFormat::GetDxgiFormat(u32 channels, PixelFormat format)
+{
+	// DXGI_FORMAT values for R, RG and RGBA.
+	static constexpr u32 kFormats[4][3] = {
+		{ 61, 49, 28 },
+		{ 54, 34, 10 },
+		{ 41, 16, 2 },
+		{ 80, 83, 71 },
+	};
+	assert(channels == 1 || channels == 2 || channels == 4);
+	return kFormats[static_cast<u32>(format)][channels == 4 ? 2 : channels - 1];
+}
+
+u32 DDSFileFormat::GetBytesPerValue(PixelFormat format)
+{
+	static constexpr u32 kSizes[] = { 1, 2, 4 };
+	assert(format != PixelFormat::kBlockCompressed);
+	return kSizes[static_cast<u32>(format)];
+}
+
+u64 DDSFileFormat::GetRowSize(u32 width, u32 channels, PixelFormat format)
+{
+	if (format == PixelFormat::kBlockCompressed)
+		return static_cast<u64>(BlockCompressor::GetBlockCount(width)) * BlockCompressor::GetBlockSize(channels);
+	return static_cast<u64>(width) * channels * GetBytesPerValue(format);
+}
+
+void DDSFileFormat::WriteHeader(std::ofstream& file, u32 width, u32 height, u32 depth, u32 channels, u32 mipCount, PixelFormat format)
+{
+	const bool isCompressed = format == PixelFormat::kBlockCompressed;
+	const bool isVolume = depth > 0;
+	const u64 topRowSize = GetRowSize(width, channels, format);
+
+	Header header = {};
+	header.size = sizeof(Header);
+	header.flags = kFlagCaps | kFlagHeight | kFlagWidth | kFlagPixelFormat | (mipCount > 1 ? kFlagMipMapCount : 0);
+	header.flags |= isCompressed ? kFlagLinearSize : kFlagPitch;
+	header.flags |= isVolume ? kFlagDepth : 0;
+	header.height = height;
+	header.width = width;
+	// Compressed formats store the size of the whole top level (of a single slice) instead of the row pitch.
+	header.pitchOrLinearSize = static_cast<u32>(isCompressed ? topRowSize * BlockCompressor::GetBlockCount(height) : topRowSize);
+	header.depth = depth;
+	header.mipMapCount = mipCount;
+	header.pixelFormat.size = sizeof(PixelFormatHeader);
+	header.pixelFormat.flags = kPixelFormatFlagFourCC;
+	header.pixelFormat.fourCC = kFourCCDx10;
+	header.caps = kCapsTexture | (mipCount > 1 ? kCapsComplex | kCapsMipMap : 0) | (isVolume ? kCapsComplex : 0);
+	header.caps2 = isVolume ? kCaps2Volume : 0;
+
+	HeaderDx10 headerDx10 = {};
+	headerDx10.dxgiFormat = GetDxgiFormat(channels, format);
+	headerDx10.resourceDimension = isVolume ? kResourceDimensionTexture3D : kResourceDimensionTexture2D;
+	headerDx10.arraySize = 1;
+
+	file.write(reinterpret_cast<const char*>(&kMagic), sizeof(kMagic));
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(&headerDx10), sizeof(headerDx10));
+}
+
+void DDSFileFormat::WriteRows(std::ofstream& file, const f32* pixels, u32 width, u32 height, u32 channels, PixelFormat format)
+{
+	const bool isCompressed = format == PixelFormat::kBlockCompressed;
+	const u64 valuesPerRow = static_cast<u64>(width) * channels;
+	const u64 rowSize = GetRowSize(width, channels, format);
+	const u32 rows = isCompressed ? BlockCompressor::GetBlockCount(height) : height;
+
+	// Rows (of pixels or blocks) are converted a chunk at a time, spread across threads, and each chunk is written at once.
+	u64 rowsPerChunk = kChunkSize / rowSize;
+	rowsPerChunk = rowsPerChunk > 0 ? rowsPerChunk : 1;
+	rowsPerChunk = rowsPerChunk < rows ? rowsPerChunk : rows;
+	std::vector<u8> buffer(rowsPerChunk * rowSize);
+
+	for (u32 firstRow = 0; firstRow < rows; firstRow += static_cast<u32>(rowsPerChunk))
+	{
+		u32 rowCount = rows - firstRow < rowsPerChunk ? rows - firstRow : static_cast<u32>(rowsPerChunk);
+		ThreadPool::Instance().ParallelFor(rowCount, [&](u32 begin, u32 end)
+		{
+			for (u32 y = begin; y < end; ++y)
+			{
+				if (isCompressed)
+					BlockCompressor::CompressBlockRow(pixels, width, height, channels, firstRow + y, &buffer[y * rowSize]);
+				else
+					ConvertRow(pixels + (firstRow + y) * valuesPerRow, valuesPerRow, format, &buffer[y * rowSize]);
+			}
+		});
+		file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(rowCount * rowSize));
+	}
+}
+
+void DDSFileFormat::ConvertRow(const f32* pixels, u64 count, PixelFormat format, u8* destination)
+{
+	u64 i = 0;
+	switch (format)
+	{
+	case PixelFormat::kUnorm8:
+	{
+#if NOISE_SIMD_AVX2
+		for (; i + 32 <= count; i += 32)
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), ToUnorm8(pixels + i));
+#endif
+		for (; i < count; ++i)
+			destination[i] = ToUnorm8(pixels[i]);
+		break;
+	}
+	case PixelFormat::kFloat16:
+	{
+		u16* values = reinterpret_cast<u16*>(destination);
+#if NOISE_SIMD_F16C
+		for (; i + 8 <= count; i += 8)
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(values + i), _mm256_cvtps_ph(_mm256_loadu_ps(pixels + i), _MM_FROUND_TO_NEAREST_INT));
+#endif
+		for (; i < count; ++i)
+			values[i] = ToHalf(pixels[i]);
+		break;
+	}
+	case PixelFormat::kFloat32:
+		memcpy(destination, pixels, count * sizeof(f32));
+		break;
+	case PixelFormat::kBlockCompressed:
+		assert(false);
+		break;
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "utility/Types.hpp"
+
+#include <iosfwd>
+#include <string>
+
+class ImageData;
+
+// DirectDraw Surface files with the DX10 header extension. Every mip level follows the header, tightly packed
+// from the largest to the smallest, so the file can be mapped and handed to the graphics API as it is.
+class DDSFileFormat
+{
+public:
+	enum class PixelFormat
+	{
+		kUnorm8,
+		kFloat16,
+		kFloat32,
+		// BC4 for 1 channel, BC5 for 2 channel and BC1 for 4 channel images.
+		kBlockCompressed,
+	};
+
+	// Writes every mip level of a 1, 2 or 4 channel image into a single file. Block compression ignores alpha.
+	static void Save(const ImageData& image, PixelFormat format, const std::string& fileName);
+
+	// Rounds to the nearest half precision value, ties to even.
+	static u16 ToHalf(f32 value);
+
+private:
+	friend class DDSStreamWriter;
+	friend class DDSVolumeWriter;
+
+	struct PixelFormatHeader
+	{
+		u32 size;
+		u32 flags;
+		u32 fourCC;
+		u32 rgbBitCount;
+		u32 rBitMask;
+		u32 gBitMask;
+		u32 bBitMask;
+		u32 aBitMask;
+	};
+
+	struct Header
+	{
+		u32 size;
+		u32 flags;
+		u32 height;
+		u32 width;
+		u32 pitchOrLinearSize;
+		u32 depth;
+		u32 mipMapCount;
+		u32 reserved1[11];
+		PixelFormatHeader pixelFormat;
+		u32 caps;
+		u32 caps2;
+		u32 caps3;
+		u32 caps4;
+		u32 reserved2;
+	};
+
+	struct HeaderDx10
+	{
+		u32 dxgiFormat;
+		u32 resourceDimension;
+		u32 miscFlag;
+		u32 arraySize;
+		u32 miscFlags2;
+	};
+
+	static u32 GetDxgiFormat(u32 channels, PixelFormat format);
+	static u32 GetBytesPerValue(PixelFormat format);
+	// Size of a row of pixels, or of a row of blocks for block compressed formats.
+	static u64 GetRowSize(u32 width, u32 channels, PixelFormat format);
+	// A depth of 0 describes a 2D texture, anything else a volume texture.
+	static void WriteHeader(std::ofstream& file, u32 width, u32 height, u32 depth, u32 channels, u32 mipCount, PixelFormat format);
+	// Converts and appends height rows of pixels, or the rows of blocks covering them, blocks repeat the bottom row.
+	static void WriteRows(std::ofstream& file, const f32* pixels, u32 width, u32 height, u32 channels, PixelFormat format);
+	// Converts count values, keeping their order.
+	static void ConvertRow(const f32* pixels, u64 count, PixelFormat format, u8* destination);
+};
@@ -0,0 +1,145 @@
+#include "DDSFileFormat.hpp"
+
+#include "image/ImageData.hpp"
+#include "testing/TestFixture.hpp"
+#include "testing/TestRunner.hpp"
+#include "testing/TestSuite.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+// Category 1: Layout
+// 1.1: Four channels with mips, header describes RGBA8 and every mip follows the header
+// 1.2: One channel without mips, header describes R16F and no mip chain
+// Category 2: Pixel data
+// 2.1: 8 bit, values rounded, mip 1 follows mip 0
+// 2.2: 32 bit floats, values copied unchanged
+// Category 3: Half precision
+// 3.1: Exact values, rounding to even, overflow and subnormals
+
+static const char* const kFileName = "dds_file_format_test.dds";
+// Magic, header and DX10 header.
+static constexpr u32 kDataOffset = 148;
+
+struct DDSFileFormatFixture
+{
+	virtual ~DDSFileFormatFixture()
+	{
+		delete image;
+		std::remove(kFileName);
+	}
+
+	ImageData* image = nullptr;
+	std::vector<u8> bytes;
+
+	void Fill(const f32* values, u32 count)
+	{
+		u32 imageCount = image->GetWidth() * image->GetHeight() * image->GetChannelCount();
+		f32* pixels = image->GetPixels(0);
+		for (u32 i = 0; i < imageCount; ++i)
+			pixels[i] = values[i % count];
+	}
+
+	void Save(DDSFileFormat::PixelFormat format)
+	{
+		DDSFileFormat::Save(*image, format, kFileName);
+		std::ifstream file(kFileName, std::ios::binary);
+		bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	u32 ReadU32(u32 offset) const
+	{
+		u32 value = 0;
+		memcpy(&value, &bytes[offset], sizeof(value));
+		return value;
+	}
+};
+
+// Category 1: Layout
+TEST_SUITE(DDSFileFormat_Layout)
+{
+	// 1.1: Four channels with mips, header describes RGBA8 and every mip follows the header
+	TEST_FIXTURE(DDSFileFormatFixture, FourChannelsWithMips_Save_AllMipsInOneFile)
+	{
+		image = new ImageData(8, 4, 4, true);
+
+		Save(DDSFileFormat::PixelFormat::kUnorm8);
+
+		Check(bytes.size() == kDataOffset + (8 * 4 + 4 * 2 + 2 * 1 + 1 * 1) * 4);
+		Check(ReadU32(0) == 0x20534444);
+		Check(ReadU32(12) == 4 && ReadU32(16) == 8);
+		Check(ReadU32(28) == 4);
+		Check(ReadU32(128) == 28);
+	}
+
+	// 1.2: One channel without mips, header describes R16F and no mip chain
+	TEST_FIXTURE(DDSFileFormatFixture, OneChannelNoMips_Save_SingleLevel)
+	{
+		image = new ImageData(5, 3, 1, false);
+
+		Save(DDSFileFormat::PixelFormat::kFloat16);
+
+		Check(bytes.size() == kDataOffset + 5 * 3 * 2);
+		Check(ReadU32(28) == 1);
+		Check((ReadU32(8) & 0x20000) == 0);
+		Check(ReadU32(128) == 54);
+	}
+}
+
+// Category 2: Pixel data
+TEST_SUITE(DDSFileFormat_PixelData)
+{
+	// 2.1: 8 bit, values rounded, mip 1 follows mip 0
+	TEST_FIXTURE(DDSFileFormatFixture, Unorm8_Save_ValuesRoundedInOrder)
+	{
+		image = new ImageData(64, 2, 1, true);
+		const f32 values[] = { -1.0f, 0.0f, 0.5f, 1.0f, 2.0f, 0.1f };
+		Fill(values, 6);
+		image->GetPixels(1)[0] = 0.25f;
+
+		Save(DDSFileFormat::PixelFormat::kUnorm8);
+
+		const u8 expected[] = { 0, 0, 128, 255, 255, 26 };
+		bool matches = true;
+		for (u32 i = 0; i < 128; ++i)
+			matches = matches && bytes[kDataOffset + i] == expected[i % 6];
+		Check(matches);
+		Check(bytes[kDataOffset + 128] == 64);
+	}
+
+	// 2.2: 32 bit floats, values copied unchanged
+	TEST_FIXTURE(DDSFileFormatFixture, Float32_Save_ValuesUnchanged)
+	{
+		image = new ImageData(3, 1, 4, false);
+		const f32 values[] = { -1.5f, 0.0f, 0.3f, 7.0f, 1e-20f, 42.0f };
+		Fill(values, 6);
+
+		Save(DDSFileFormat::PixelFormat::kFloat32);
+
+		Check(memcmp(&bytes[kDataOffset], image->GetPixels(0), 3 * 4 * sizeof(f32)) == 0);
+	}
+}
+
+// Category 3: Half precision
+TEST_SUITE(DDSFileFormat_Half)
+{
+	// 3.1: Exact values, rounding to even, overflow and subnormals
+	TEST_FIXTURE(DDSFileFormatFixture, Values_ToHalf_MatchIeeeRounding)
+	{
+		Check(DDSFileFormat::ToHalf(0.0f) == 0x0000);
+		Check(DDSFileFormat::ToHalf(-0.0f) == 0x8000);
+		Check(DDSFileFormat::ToHalf(1.0f) == 0x3C00);
+		Check(DDSFileFormat::ToHalf(-2.0f) == 0xC000);
+		Check(DDSFileFormat::ToHalf(65504.0f) == 0x7BFF);
+		Check(DDSFileFormat::ToHalf(65520.0f) == 0x7C00);
+		// 1 + 2^-11 lies halfway between 1 and the next half, ties go to the even 1.
+		Check(DDSFileFormat::ToHalf(1.00048828125f) == 0x3C00);
+		Check(DDSFileFormat::ToHalf(1.00146484375f) == 0x3C02);
+		// Smallest subnormal and half of it, which rounds to 0.
+		Check(DDSFileFormat::ToHalf(5.9604644775390625e-8f) == 0x0001);
+		Check(DDSFileFormat::ToHalf(2.98023223876953125e-8f) == 0x0000);
+	}
+}
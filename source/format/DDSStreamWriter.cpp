@@ -0,0 +1,188 @@
+#include "DDSStreamWriter.hpp"
+
+#include "BlockCompression.hpp"
+#include "image/ImageData.hpp"
+#include "utility/Profiler.hpp"
+#include "utility/ThreadPool.hpp"
+
+#include <cassert>
+#include <cstring>
+
+// Magic, header and DX10 header.
+static constexpr u64 kDataOffset = 4 + 124 + 20;
+
+DDSStreamWriter::DDSStreamWriter(const std::string& fileName, u32 width, u32 height, u32 channels, bool generateMipChain, DDSFileFormat::PixelFormat format)
+	: channels(channels)
+	, format(format)
+{
+	assert(width > 0 && height > 0);
+
+	// The same levels as an ImageData with the same dimensions.
+	u32 w = width;
+	u32 h = height;
+	bool first = true;
+	while ((first || generateMipChain) && (w > 1 || h > 1))
+	{
+		levels.emplace_back();
+		levels.back().width = w;
+		levels.back().height = h;
+		first = false;
+		w = w > 1 ? w >> 1 : 1;
+		h = h > 1 ? h >> 1 : 1;
+	}
+	if (generateMipChain || levels.empty())
+	{
+		levels.emplace_back();
+		levels.back().width = w;
+		levels.back().height = h;
+	}
+
+	const bool isCompressed = format == DDSFileFormat::PixelFormat::kBlockCompressed;
+	u64 fileOffset = kDataOffset;
+	for (Level& level : levels)
+	{
+		level.fileOffset = fileOffset;
+		u64 rows = isCompressed ? BlockCompressor::GetBlockCount(level.height) : level.height;
+		fileOffset += rows * DDSFileFormat::GetRowSize(level.width, channels, format);
+
+		u64 valuesPerRow = static_cast<u64>(level.width > 1 ? level.width : 2) * channels;
+		if (isCompressed)
+			level.pendingRows.resize(BlockCompressor::kBlockDimension * valuesPerRow);
+		level.carryRow.resize(valuesPerRow);
+	}
+
+	file.open(fileName.c_str(), std::ios::binary);
+	DDSFileFormat::WriteHeader(file, width, height, 0, channels, static_cast<u32>(levels.size()), format);
+}
+
+void DDSStreamWriter::Write(const f32* rows, u32 rowCount)
+{
+	PROFILE_SCOPE_BYTES("write dds strip", static_cast<u64>(levels[0].width) * rowCount * channels * sizeof(f32));
+	Push(0, rows, rowCount);
+
+	// Every level is complete once the top level is.
+	assert(levels[0].receivedRows < levels[0].height || levels.back().receivedRows == levels.back().height);
+}
+
+void DDSStreamWriter::Push(u32 levelIndex, const f32* rows, u32 rowCount)
+{
+	if (rowCount == 0)
+		return;
+
+	Level& level = levels[levelIndex];
+	assert(level.receivedRows + rowCount <= level.height);
+	level.receivedRows += rowCount;
+
+	Encode(level, rows, rowCount);
+	if (levelIndex + 1 < levels.size())
+		Reduce(levelIndex, rows, rowCount);
+}
+
+void DDSStreamWriter::Encode(Level& level, const f32* rows, u32 rowCount)
+{
+	const u64 valuesPerRow = static_cast<u64>(level.width) * channels;
+	const u64 rowSize = DDSFileFormat::GetRowSize(level.width, channels, format);
+	const bool isLastRow = level.receivedRows == level.height;
+
+	if (format != DDSFileFormat::PixelFormat::kBlockCompressed)
+	{
+		file.seekp(static_cast<std::streamoff>(level.fileOffset));
+		DDSFileFormat::WriteRows(file, rows, level.width, rowCount, channels, format);
+		level.fileOffset += rowCount * rowSize;
+		return;
+	}
+
+	// Blocks need 4 rows, the rows that are left over wait for the next call. The last row of blocks repeats the bottom row.
+	const u32 blockDimension = BlockCompressor::kBlockDimension;
+	if (level.pendingRowCount > 0)
+	{
+		u32 count = blockDimension - level.pendingRowCount;
+		count = count < rowCount ? count : rowCount;
+		memcpy(&level.pendingRows[level.pendingRowCount * valuesPerRow], rows, count * valuesPerRow * sizeof(f32));
+		level.pendingRowCount += count;
+		rows += count * valuesPerRow;
+		rowCount -= count;
+
+		if (level.pendingRowCount == blockDimension || (isLastRow && rowCount == 0))
+		{
+			file.seekp(static_cast<std::streamoff>(level.fileOffset));
+			DDSFileFormat::WriteRows(file, level.pendingRows.data(), level.width, level.pendingRowCount, channels, format);
+			level.fileOffset += rowSize;
+			level.pendingRowCount = 0;
+		}
+	}
+
+	u32 encodedRowCount = isLastRow ? rowCount : rowCount / blockDimension * blockDimension;
+	if (encodedRowCount > 0)
+	{
+		file.seekp(static_cast<std::streamoff>(level.fileOffset));
+		DDSFileFormat::WriteRows(file, rows, level.width, encodedRowCount, channels, format);
+		level.fileOffset += BlockCompressor::GetBlockCount(encodedRowCount) * rowSize;
+	}
+
+	u32 remainingRowCount = rowCount - encodedRowCount;
+	if (remainingRowCount > 0)
+	{
+		memcpy(level.pendingRows.data(), rows + encodedRowCount * valuesPerRow, remainingRowCount * valuesPerRow * sizeof(f32));
+		level.pendingRowCount = remainingRowCount;
+	}
+}
+
+void DDSStreamWriter::Reduce(u32 levelIndex, const f32* rows, u32 rowCount)
+{
+	Level& source = levels[levelIndex];
+	Level& destination = levels[levelIndex + 1];
+	const bool isLastRow = source.receivedRows == source.height;
+
+	// A column of single pixels is reduced as if every pixel was repeated.
+	u64 sourcePitch = static_cast<u64>(source.width) * channels;
+	std::vector<f32> widenedRows;
+	if (source.width == 1)
+	{
+		widenedRows.resize(rowCount * 2 * channels);
+		for (u32 y = 0; y < rowCount; ++y)
+		{
+			memcpy(&widenedRows[y * 2 * channels], rows + y * channels, channels * sizeof(f32));
+			memcpy(&widenedRows[(y * 2 + 1) * channels], rows + y * channels, channels * sizeof(f32));
+		}
+		rows = widenedRows.data();
+		sourcePitch = 2 * channels;
+	}
+
+	// Rows are paired from the carried row on, an odd row at the bottom is dropped unless it is the only one left for the
+	// last row of the next level.
+	const bool hasCarryRow = source.hasCarryRow;
+	const u32 totalRowCount = rowCount + (hasCarryRow ? 1 : 0);
+	const u32 remainingRowCount = destination.height - destination.receivedRows;
+	u32 pairCount = totalRowCount / 2;
+	pairCount = pairCount < remainingRowCount ? pairCount : remainingRowCount;
+	const bool reduceLastRow = isLastRow && (totalRowCount & 1) != 0 && pairCount < remainingRowCount;
+	const u32 reducedRowCount = pairCount + (reduceLastRow ? 1 : 0);
+
+	auto getRow = [&](u32 index) -> const f32*
+	{
+		if (hasCarryRow)
+			return index == 0 ? source.carryRow.data() : rows + (index - 1) * sourcePitch;
+		return rows + index * sourcePitch;
+	};
+
+	const u64 destinationPitch = static_cast<u64>(destination.width) * channels;
+	source.reducedRows.resize(reducedRowCount * destinationPitch);
+	f32* reducedRows = source.reducedRows.data();
+	ThreadPool::Instance().ParallelFor(pairCount, [&](u32 begin, u32 end)
+	{
+		for (u32 y = begin; y < end; ++y)
+			ImageData::ReduceRow(getRow(y * 2), getRow(y * 2 + 1), reducedRows + y * destinationPitch, destination.width, channels);
+	});
+	if (reduceLastRow)
+	{
+		const f32* lastRow = getRow(totalRowCount - 1);
+		ImageData::ReduceRow(lastRow, lastRow, reducedRows + pairCount * destinationPitch, destination.width, channels);
+	}
+
+	source.hasCarryRow = !isLastRow && (totalRowCount & 1) != 0;
+	if (source.hasCarryRow)
+		memcpy(source.carryRow.data(), getRow(totalRowCount - 1), sourcePitch * sizeof(f32));
+
+	Push(levelIndex + 1, reducedRows, reducedRowCount);
+}
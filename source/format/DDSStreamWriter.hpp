@@ -0,0 +1,51 @@
+#pragma once
+
+#include "DDSFileFormat.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Writes a DDS file from the rows of the top level as they are generated, so the image never has to be held in memory
+// as a whole. Each mip level is reduced from the rows of the level above as soon as a pair of them arrives, the same
+// way ImageData::GenerateMips reduces whole levels, and written at its place in the file.
+class DDSStreamWriter
+{
+public:
+	DDSStreamWriter() = delete;
+	DDSStreamWriter(const DDSStreamWriter&) = delete;
+	DDSStreamWriter(DDSStreamWriter&&) = delete;
+	DDSStreamWriter(const std::string& fileName, u32 width, u32 height, u32 channels, bool generateMipChain, DDSFileFormat::PixelFormat format);
+
+	DDSStreamWriter& operator =(const DDSStreamWriter&) = delete;
+	DDSStreamWriter& operator =(DDSStreamWriter&&) = delete;
+
+	// Appends rowCount rows of the top level, top to bottom. The file is complete once the last row has been written.
+	void Write(const f32* rows, u32 rowCount);
+
+private:
+	struct Level
+	{
+		u32 width = 0;
+		u32 height = 0;
+		u32 receivedRows = 0;
+		// Position of the next encoded row in the file.
+		u64 fileOffset = 0;
+		// Rows that do not fill a row of blocks yet.
+		std::vector<f32> pendingRows;
+		u32 pendingRowCount = 0;
+		// A row waiting for the row below it to be reduced into the next level.
+		std::vector<f32> carryRow;
+		bool hasCarryRow = false;
+		std::vector<f32> reducedRows;
+	};
+
+	void Push(u32 levelIndex, const f32* rows, u32 rowCount);
+	void Encode(Level& level, const f32* rows, u32 rowCount);
+	void Reduce(u32 levelIndex, const f32* rows, u32 rowCount);
+
+	std::ofstream file;
+	std::vector<Level> levels;
+	u32 channels;
+	DDSFileFormat::PixelFormat format;
+};
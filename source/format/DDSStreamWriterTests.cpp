@@ -0,0 +1,113 @@
+#include "DDSStreamWriter.hpp"
+
+#include "image/ImageData.hpp"
+#include "testing/TestFixture.hpp"
+#include "testing/TestRunner.hpp"
+#include "testing/TestSuite.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+// Category 1: Same file as a whole image
+// 1.1: 8 bit with mips, strips of 3 rows, mips match GenerateMips
+// 1.2: Block compressed with mips, strips of 5 rows
+// 1.3: 32 bit floats without mips, one row at a time
+// Category 2: Odd sizes
+// 2.1: Odd width and height with mips, every level is written
+
+static const char* const kStreamFileName = "dds_stream_writer_test.dds";
+static const char* const kWholeFileName = "dds_stream_writer_test_whole.dds";
+
+struct DDSStreamWriterFixture
+{
+	virtual ~DDSStreamWriterFixture()
+	{
+		delete image;
+		std::remove(kStreamFileName);
+		std::remove(kWholeFileName);
+	}
+
+	ImageData* image = nullptr;
+
+	void CreateImage(u32 width, u32 height, u32 channels, bool generateMipChain)
+	{
+		image = new ImageData(width, height, channels, generateMipChain);
+		u32 count = width * height * channels;
+		f32* pixels = image->GetPixels(0);
+		for (u32 i = 0; i < count; ++i)
+			pixels[i] = static_cast<f32>((i * 7919) % 1000) * 0.001f;
+		image->GenerateMips(0);
+	}
+
+	void Stream(DDSFileFormat::PixelFormat format, u32 stripHeight)
+	{
+		const u32 height = image->GetHeight();
+		const u64 pitch = static_cast<u64>(image->GetWidth()) * image->GetChannelCount();
+		DDSStreamWriter writer(kStreamFileName, image->GetWidth(), height, image->GetChannelCount(), image->GetMipLevelCount() > 1, format);
+		for (u32 y = 0; y < height; y += stripHeight)
+			writer.Write(image->GetPixels(0) + y * pitch, height - y < stripHeight ? height - y : stripHeight);
+	}
+
+	static std::vector<u8> Read(const char* fileName)
+	{
+		std::ifstream file(fileName, std::ios::binary);
+		return std::vector<u8>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	bool MatchesSave(DDSFileFormat::PixelFormat format)
+	{
+		DDSFileFormat::Save(*image, format, kWholeFileName);
+		return Read(kStreamFileName) == Read(kWholeFileName);
+	}
+};
+
+// Category 1: Same file as a whole image
+TEST_SUITE(DDSStreamWriter_MatchesSave)
+{
+	// 1.1: 8 bit with mips, strips of 3 rows, mips match GenerateMips
+	TEST_FIXTURE(DDSStreamWriterFixture, Unorm8WithMips_WriteStrips_MatchesSave)
+	{
+		CreateImage(32, 32, 4, true);
+
+		Stream(DDSFileFormat::PixelFormat::kUnorm8, 3);
+
+		Check(MatchesSave(DDSFileFormat::PixelFormat::kUnorm8));
+	}
+
+	// 1.2: Block compressed with mips, strips of 5 rows
+	TEST_FIXTURE(DDSStreamWriterFixture, BlockCompressedWithMips_WriteStrips_MatchesSave)
+	{
+		CreateImage(64, 64, 1, true);
+
+		Stream(DDSFileFormat::PixelFormat::kBlockCompressed, 5);
+
+		Check(MatchesSave(DDSFileFormat::PixelFormat::kBlockCompressed));
+	}
+
+	// 1.3: 32 bit floats without mips, one row at a time
+	TEST_FIXTURE(DDSStreamWriterFixture, Float32NoMips_WriteRows_MatchesSave)
+	{
+		CreateImage(20, 7, 2, false);
+
+		Stream(DDSFileFormat::PixelFormat::kFloat32, 1);
+
+		Check(MatchesSave(DDSFileFormat::PixelFormat::kFloat32));
+	}
+}
+
+// Category 2: Odd sizes
+TEST_SUITE(DDSStreamWriter_OddSizes)
+{
+	// 2.1: Odd width and height with mips, every level is written
+	TEST_FIXTURE(DDSStreamWriterFixture, OddSizeWithMips_WriteStrips_AllLevelsWritten)
+	{
+		CreateImage(13, 6, 1, true);
+
+		Stream(DDSFileFormat::PixelFormat::kFloat32, 4);
+
+		// 13x6, 6x3, 3x1 and 1x1 after the magic, header and DX10 header.
+		Check(Read(kStreamFileName).size() == 148 + (13 * 6 + 6 * 3 + 3 * 1 + 1) * sizeof(f32));
+	}
+}
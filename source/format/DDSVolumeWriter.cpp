@@ -0,0 +1,27 @@
+#include "DDSVolumeWriter.hpp"
+
+#include "utility/Profiler.hpp"
+
+#include <cassert>
+
+DDSVolumeWriter::DDSVolumeWriter(const std::string& fileName, u32 width, u32 height, u32 depth, u32 channels, DDSFileFormat::PixelFormat format)
+	: width(width)
+	, height(height)
+	, depth(depth)
+	, channels(channels)
+	, format(format)
+{
+	assert(width > 0 && height > 0 && depth > 0);
+
+	file.open(fileName.c_str(), std::ios::binary);
+	DDSFileFormat::WriteHeader(file, width, height, depth, channels, 1, format);
+}
+
+void DDSVolumeWriter::WriteSlice(const f32* pixels)
+{
+	assert(writtenSlices < depth);
+	++writtenSlices;
+	PROFILE_SCOPE_BYTES("write dds slice", static_cast<u64>(width) * height * channels * sizeof(f32));
+
+	DDSFileFormat::WriteRows(file, pixels, width, height, channels, format);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "DDSFileFormat.hpp"
+
+#include <fstream>
+#include <string>
+
+// Writes a DDS volume texture a slice at a time, front to back, so only one slice has to be held in memory. Volumes
+// have a single level. Block compressed volumes are compressed slice by slice, in blocks of 4x4 pixels of a slice.
+class DDSVolumeWriter
+{
+public:
+	DDSVolumeWriter() = delete;
+	DDSVolumeWriter(const DDSVolumeWriter&) = delete;
+	DDSVolumeWriter(DDSVolumeWriter&&) = delete;
+	DDSVolumeWriter(const std::string& fileName, u32 width, u32 height, u32 depth, u32 channels, DDSFileFormat::PixelFormat format);
+
+	DDSVolumeWriter& operator =(const DDSVolumeWriter&) = delete;
+	DDSVolumeWriter& operator =(DDSVolumeWriter&&) = delete;
+
+	// Appends the next width x height slice. The file is complete once depth slices have been written.
+	void WriteSlice(const f32* pixels);
+
+private:
+	std::ofstream file;
+	u32 width;
+	u32 height;
+	u32 depth;
+	u32 channels;
+	u32 writtenSlices = 0;
+	DDSFileFormat::PixelFormat format;
+};
@@ -0,0 +1,99 @@
+#include "DDSVolumeWriter.hpp"
+
+#include "testing/TestFixture.hpp"
+#include "testing/TestRunner.hpp"
+#include "testing/TestSuite.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+// Category 1: Layout
+// 1.1: Header describes a volume texture of the given depth without mips
+// 1.2: 8 bit slices follow the header front to back
+// Category 2: Block compression
+// 2.1: Every slice is compressed on its own, rows of blocks do not cross slices
+
+static const char* const kVolumeFileName = "dds_volume_writer_test.dds";
+// Magic, header and DX10 header.
+static constexpr u32 kVolumeDataOffset = 148;
+
+struct DDSVolumeWriterFixture
+{
+	virtual ~DDSVolumeWriterFixture()
+	{
+		std::remove(kVolumeFileName);
+	}
+
+	std::vector<u8> bytes;
+
+	void Write(u32 width, u32 height, u32 depth, u32 channels, DDSFileFormat::PixelFormat format)
+	{
+		{
+			DDSVolumeWriter writer(kVolumeFileName, width, height, depth, channels, format);
+			std::vector<f32> slice(width * height * channels);
+			for (u32 z = 0; z < depth; ++z)
+			{
+				for (u32 i = 0; i < slice.size(); ++i)
+					slice[i] = static_cast<f32>((z * 31 + i) % 256) / 255.0f;
+				writer.WriteSlice(slice.data());
+			}
+		}
+
+		std::ifstream file(kVolumeFileName, std::ios::binary);
+		bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	u32 ReadU32(u32 offset) const
+	{
+		u32 value = 0;
+		memcpy(&value, &bytes[offset], sizeof(value));
+		return value;
+	}
+};
+
+// Category 1: Layout
+TEST_SUITE(DDSVolumeWriter_Layout)
+{
+	// 1.1: Header describes a volume texture of the given depth without mips
+	TEST_FIXTURE(DDSVolumeWriterFixture, Volume_Write_HeaderDescribesVolume)
+	{
+		Write(4, 2, 3, 1, DDSFileFormat::PixelFormat::kFloat32);
+
+		Check((ReadU32(8) & 0x800000) != 0);
+		Check(ReadU32(24) == 3);
+		Check(ReadU32(28) == 1);
+		Check((ReadU32(112) & 0x200000) != 0);
+		Check(ReadU32(132) == 4);
+	}
+
+	// 1.2: 8 bit slices follow the header front to back
+	TEST_FIXTURE(DDSVolumeWriterFixture, Unorm8_Write_SlicesInOrder)
+	{
+		Write(3, 2, 4, 4, DDSFileFormat::PixelFormat::kUnorm8);
+
+		Check(bytes.size() == kVolumeDataOffset + 3 * 2 * 4 * 4);
+		bool matches = true;
+		for (u32 z = 0; z < 4; ++z)
+		{
+			for (u32 i = 0; i < 3 * 2 * 4; ++i)
+				matches = matches && bytes[kVolumeDataOffset + z * 3 * 2 * 4 + i] == (z * 31 + i) % 256;
+		}
+		Check(matches);
+	}
+}
+
+// Category 2: Block compression
+TEST_SUITE(DDSVolumeWriter_BlockCompression)
+{
+	// 2.1: Every slice is compressed on its own, rows of blocks do not cross slices
+	TEST_FIXTURE(DDSVolumeWriterFixture, OddHeight_Write_BlocksPerSlice)
+	{
+		Write(8, 6, 3, 1, DDSFileFormat::PixelFormat::kBlockCompressed);
+
+		// Each 8x6 slice takes 2 rows of 2 BC4 blocks of 8 bytes.
+		Check(bytes.size() == kVolumeDataOffset + 3 * 2 * 2 * 8);
+	}
+}
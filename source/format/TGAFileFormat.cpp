@@ -1,10 +1,29 @@
 #include "TGAFileFormat.hpp"
 
+#include "image/ImageData.hpp"
+#include "utility/MappedFile.hpp"
+#include "utility/Profiler.hpp"
+#include "utility/Simd.hpp"
+#include "utility/ThreadPool.hpp"
+#include "utility/Unorm8.hpp"
+
+#include <bit>
+#include <cassert>
 #include <cmath>
+#include <cstring>
 #include <fstream>
+#include <vector>
+
+static constexpr u64 kChunkSize = 4 * 1024 * 1024;
+// RLE packets hold up to 128 pixels.
+static constexpr u32 kMaxPacketLength = 128;
 
-void TGAFileFormat::Save(const f32* const pixels, u32 width, u32 height, u32 channels, const std::string& fileName)
+void TGAFileFormat::Save(const f32* const pixels, u32 width, u32 height, u32 channels, const std::string& fileName, bool compress)
 {
+	// The header stores 16 bit dimensions, larger images are streamed to DDS files instead.
+	assert(width <= 0xFFFF && height <= 0xFFFF);
+	PROFILE_SCOPE_BYTES("save tga", static_cast<u64>(width) * height * channels * sizeof(f32));
+
 	std::ofstream file;
 	file.open(fileName.c_str(), std::ios::binary);
 
@@ -14,7 +33,7 @@ void TGAFileFormat::Save(const f32* const pixels, u32 width, u32 height, u32 cha
 	header.colorMapLength = 0;
 	header.colorMapOrigin = 0;
 	header.colorMapType = 0;
-	header.dataType = 2;
+	header.dataType = (channels == 1 ? 3 : 2) + (compress ? 8 : 0);
 	header.height = static_cast<u16>(height);
 	header.imageDescriptor = header.bitsPerPixel == 32 ? 40 : 32;
 	header.length = 0;
@@ -24,87 +43,335 @@ void TGAFileFormat::Save(const f32* const pixels, u32 width, u32 height, u32 cha
 
 	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
 
-	u32 pixelCount = width * height;
-	char pixel[4];
+	// Rows are converted a chunk at a time, spread across threads, and each chunk is written at once.
+	const u64 rowSize = static_cast<u64>(width) * channels;
+	u64 rowsPerChunk = kChunkSize / rowSize;
+	rowsPerChunk = rowsPerChunk > 0 ? rowsPerChunk : 1;
+	rowsPerChunk = rowsPerChunk < height ? rowsPerChunk : height;
+	std::vector<u8> buffer(rowsPerChunk * rowSize);
 
-    const f32* data = pixels;
+	// Packets never cross rows, so every row is compressed on its own. A row of raw packets is the worst case.
+	const u64 maxPacketsSize = rowSize + (width + kMaxPacketLength - 1) / kMaxPacketLength;
+	std::vector<u8> packets(compress ? rowsPerChunk * maxPacketsSize : 0);
+	std::vector<u64> packetsSizes(compress ? rowsPerChunk : 0);
 
-	if (header.bitsPerPixel == 32)
+	for (u32 firstRow = 0; firstRow < height; firstRow += static_cast<u32>(rowsPerChunk))
 	{
-		for (u32 i = 0; i < pixelCount; ++i)
+		u32 rowCount = height - firstRow < rowsPerChunk ? height - firstRow : static_cast<u32>(rowsPerChunk);
+		ThreadPool::Instance().ParallelFor(rowCount, [&](u32 begin, u32 end)
 		{
-			pixel[0] = Convert(data[2]);
-			pixel[1] = Convert(data[1]);
-			pixel[2] = Convert(data[0]);
-			pixel[3] = Convert(data[3]);
-			file.write(pixel, channels);
-			data += channels;
+			for (u32 y = begin; y < end; ++y)
+			{
+				ConvertRow(pixels + (firstRow + y) * rowSize, width, channels, &buffer[y * rowSize]);
+				if (compress)
+					packetsSizes[y] = Compress(&buffer[y * rowSize], width, channels, &packets[y * maxPacketsSize]);
+			}
+		});
+
+		if (!compress)
+		{
+			file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(rowCount * rowSize));
+			continue;
 		}
+
+		// Rows are moved together so the chunk is still written at once.
+		u64 chunkSize = packetsSizes[0];
+		for (u32 y = 1; y < rowCount; ++y)
+		{
+			memmove(&packets[chunkSize], &packets[y * maxPacketsSize], packetsSizes[y]);
+			chunkSize += packetsSizes[y];
+		}
+		file.write(reinterpret_cast<const char*>(packets.data()), static_cast<std::streamsize>(chunkSize));
 	}
-	else
+}
+
+void TGAFileFormat::ConvertRow(const f32* pixels, u32 width, u32 channels, u8* destination)
+{
+	const u32 count = width * channels;
+	u32 i = 0;
+#if NOISE_SIMD_AVX2
+	if (channels == 4 || channels == 1)
 	{
-		for (u32 i = 0; i < pixelCount; ++i)
+		const __m256i rgbaToBgra = _mm256_setr_epi8(
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+		for (; i + 32 <= count; i += 32)
 		{
-			pixel[0] = Convert(data[2]);
-			pixel[1] = Convert(data[1]);
-			pixel[2] = Convert(data[0]);
-			file.write(pixel, channels);
-			data += channels;
+			__m256i bytes = ToUnorm8(pixels + i);
+			if (channels == 4)
+				bytes = _mm256_shuffle_epi8(bytes, rgbaToBgra);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), bytes);
 		}
 	}
+#endif
+
+	const f32* data = pixels + i;
+	u8* pixel = destination + i;
+	if (channels == 1)
+	{
+		for (; i < count; ++i)
+			*pixel++ = ToUnorm8(*data++);
+		return;
+	}
+
+	for (; i < count; i += channels)
+	{
+		pixel[0] = ToUnorm8(data[2]);
+		pixel[1] = ToUnorm8(data[1]);
+		pixel[2] = ToUnorm8(data[0]);
+		if (channels == 4)
+			pixel[3] = ToUnorm8(data[3]);
+		data += channels;
+		pixel += channels;
+	}
 }
 
-u8 TGAFileFormat::Convert(f32 value)
+u32 TGAFileFormat::FindRepeat(const u8* row, u32 begin, u32 end, u32 bytesPerPixel, bool isRepeated)
 {
-    f32 clamped = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
-    return static_cast<u8>(floor(clamped * 255.0f + 0.5f));
+	u32 x = begin;
+#if NOISE_SIMD_AVX2
+	// Every pixel is compared with the next one, a set mask bit means the two are equal.
+	const u32 flip = isRepeated ? 0u : ~0u;
+	if (bytesPerPixel == 4)
+	{
+		for (; x + 8 <= end; x += 8)
+		{
+			__m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x * 4));
+			__m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x * 4 + 4));
+			u32 mask = static_cast<u32>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(current, next))));
+			mask = (mask ^ flip) & 0xFF;
+			if (mask != 0)
+				return x + static_cast<u32>(std::countr_zero(mask));
+		}
+	}
+	else if (bytesPerPixel == 1)
+	{
+		for (; x + 32 <= end; x += 32)
+		{
+			__m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x));
+			__m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x + 1));
+			u32 mask = static_cast<u32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(current, next))) ^ flip;
+			if (mask != 0)
+				return x + static_cast<u32>(std::countr_zero(mask));
+		}
+	}
+#endif
+
+	for (; x < end; ++x)
+	{
+		const u8* pixel = row + x * bytesPerPixel;
+		if ((memcmp(pixel, pixel + bytesPerPixel, bytesPerPixel) == 0) == isRepeated)
+			return x;
+	}
+	return end;
 }
 
-f32 TGAFileFormat::Convert(char value)
+u64 TGAFileFormat::Compress(const u8* row, u32 width, u32 bytesPerPixel, u8* destination)
 {
-    return static_cast<f32>(static_cast<u8>(value)) / 255.0f;
+	// A run packet of two single byte pixels is no smaller than extending a raw packet.
+	const u32 minRunLength = bytesPerPixel == 1 ? 3 : 2;
+	u8* packet = destination;
+	u32 x = 0;
+	while (x < width)
+	{
+		// Pixels are compared with their successor, so the last pixel is never checked on its own.
+		u32 last = x + kMaxPacketLength < width ? x + kMaxPacketLength - 1 : width - 1;
+		u32 runEnd = FindRepeat(row, x, last, bytesPerPixel, false);
+		u32 runLength = runEnd - x + 1;
+		if (runLength >= minRunLength)
+		{
+			*packet++ = static_cast<u8>(0x80 | (runLength - 1));
+			memcpy(packet, row + x * bytesPerPixel, bytesPerPixel);
+			packet += bytesPerPixel;
+			x += runLength;
+			continue;
+		}
+
+		// Raw pixels continue up to the start of the next run worth its own packet.
+		u32 rawEnd = x;
+		while (true)
+		{
+			rawEnd = FindRepeat(row, rawEnd, last, bytesPerPixel, true);
+			if (rawEnd == last || minRunLength == 2 || FindRepeat(row, rawEnd, last, bytesPerPixel, false) >= rawEnd + minRunLength - 1)
+				break;
+			++rawEnd;
+		}
+		u32 rawLength = rawEnd == last ? last - x + 1 : rawEnd - x;
+		*packet++ = static_cast<u8>(rawLength - 1);
+		memcpy(packet, row + x * bytesPerPixel, static_cast<size_t>(rawLength) * bytesPerPixel);
+		packet += static_cast<size_t>(rawLength) * bytesPerPixel;
+		x += rawLength;
+	}
+	return static_cast<u64>(packet - destination);
 }
 
-void TGAFileFormat::Load(f32*& pixels, u32& width, u32& height, const std::string& fileName)
+void TGAFileFormat::ConvertRow(const u8* row, u32 width, u32 bytesPerPixel, f32* destination)
 {
-    std::ifstream file;
-	file.open(fileName.c_str(), std::ios::binary);
+	u32 x = 0;
+#if NOISE_SIMD_AVX2
+	const __m256 scale = _mm256_set1_ps(255.0f);
+	if (bytesPerPixel == 1)
+	{
+		for (; x + 8 <= width; x += 8)
+		{
+			__m256i values = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + x)));
+			_mm256_storeu_ps(destination + x, _mm256_div_ps(_mm256_cvtepi32_ps(values), scale));
+		}
+	}
+	else
+	{
+		const __m128i bgraToRgba = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		// Spreads four 3 byte pixels to 4 bytes, the missing alpha is set to 255.
+		const __m128i bgrToRgba = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+		const __m128i opaque = _mm_set1_epi32(static_cast<int>(0xFF000000));
+		// A 16 byte load of 3 byte pixels reads past the four pixels it converts.
+		const u32 vectorEnd = bytesPerPixel == 4 ? width : (width > 2 ? width - 2 : 0);
 
-	Header header;
-    file.read(reinterpret_cast<char*>(&header), sizeof(Header));
-    width = header.width;
-    height = header.height;
-    u32 channels = header.bitsPerPixel / 8;
+		for (; x + 4 <= vectorEnd; x += 4)
+		{
+			__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * bytesPerPixel));
+			if (bytesPerPixel == 4)
+				bytes = _mm_shuffle_epi8(bytes, bgraToRgba);
+			else
+				bytes = _mm_or_si128(_mm_shuffle_epi8(bytes, bgrToRgba), opaque);
 
-    u32 pixelCount = width * height;
-	char pixel[4];
-    u32 dataSize = pixelCount * 4;
-    pixels = new float[dataSize];
+			__m256 low = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+			__m256 high = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_unpackhi_epi64(bytes, bytes)));
+			_mm256_storeu_ps(destination + x * 4, _mm256_div_ps(low, scale));
+			_mm256_storeu_ps(destination + x * 4 + 8, _mm256_div_ps(high, scale));
+		}
+	}
+#endif
 
-    f32* data = pixels;
+	const u8* pixel = row + x * bytesPerPixel;
+	if (bytesPerPixel == 1)
+	{
+		for (; x < width; ++x)
+			destination[x] = Convert(*pixel++);
+		return;
+	}
 
-    if (channels == 3)
-    {
-        for (u32 i = 0; i < pixelCount; ++i)
+	f32* data = destination + x * 4;
+	for (; x < width; ++x)
+	{
+		data[0] = Convert(pixel[2]);
+		data[1] = Convert(pixel[1]);
+		data[2] = Convert(pixel[0]);
+		data[3] = bytesPerPixel == 4 ? Convert(pixel[3]) : 1.0f;
+		pixel += bytesPerPixel;
+		data += 4;
+	}
+}
+
+bool TGAFileFormat::Decompress(const u8* source, const u8* sourceEnd, u32 bytesPerPixel, u8* destination, u64 size)
+{
+	u8* const destinationEnd = destination + size;
+	while (destination < destinationEnd)
+	{
+		if (source >= sourceEnd)
+			return false;
+
+		// The low 7 bits hold the pixel count minus one, the high bit marks a run of one repeated pixel.
+		u8 packet = *source++;
+		u64 length = static_cast<u64>((packet & 0x7F) + 1) * bytesPerPixel;
+		u64 remaining = static_cast<u64>(destinationEnd - destination);
+		length = length < remaining ? length : remaining;
+
+		if ((packet & 0x80) != 0)
 		{
-            file.read(pixel, 3);
-            data[0] = Convert(pixel[2]);
-            data[1] = Convert(pixel[1]);
-            data[2] = Convert(pixel[0]);
-            data[3] = 1.0f;
-            data += 4;
+			if (static_cast<u64>(sourceEnd - source) < bytesPerPixel)
+				return false;
+
+			if (bytesPerPixel == 1)
+			{
+				memset(destination, *source, length);
+			}
+			else
+			{
+				for (u64 i = 0; i < length; i += bytesPerPixel)
+					memcpy(destination + i, source, bytesPerPixel);
+			}
+			source += bytesPerPixel;
+		}
+		else
+		{
+			if (static_cast<u64>(sourceEnd - source) < length)
+				return false;
+
+			memcpy(destination, source, length);
+			source += length;
 		}
-    }
-    else
-    {
-        for (u32 i = 0; i < pixelCount; ++i)
+		destination += length;
+	}
+	return true;
+}
+
+f32 TGAFileFormat::Convert(u8 value)
+{
+    return static_cast<f32>(value) / 255.0f;
+}
+
+ImageData* TGAFileFormat::Load(const std::string& fileName, bool generateMipChain)
+{
+	MappedFile file(fileName);
+	if (!file.IsOpen() || file.GetSize() < sizeof(Header))
+		return nullptr;
+
+	Header header;
+	memcpy(&header, file.GetData(), sizeof(Header));
+
+	const bool isCompressed = header.dataType == 10 || header.dataType == 11;
+	const bool isGrayscale = header.dataType == 3 || header.dataType == 11;
+	const bool isTrueColor = header.dataType == 2 || header.dataType == 10;
+	const u32 bytesPerPixel = header.bitsPerPixel / 8u;
+	const bool isSupported = (isGrayscale && header.bitsPerPixel == 8) ||
+		(isTrueColor && (header.bitsPerPixel == 24 || header.bitsPerPixel == 32));
+	if (!isSupported || header.width == 0 || header.height == 0)
+		return nullptr;
+
+	// The image ID and an unused color map sit between the header and the pixels.
+	u64 dataOffset = sizeof(Header) + header.length;
+	if (header.colorMapType != 0)
+		dataOffset += static_cast<u64>(header.colorMapLength) * ((header.colorMapDepth + 7u) / 8u);
+	if (dataOffset > file.GetSize())
+		return nullptr;
+
+	const u32 width = header.width;
+	const u32 height = header.height;
+	const u64 rowSize = static_cast<u64>(width) * bytesPerPixel;
+	const u8* source = file.GetData() + dataOffset;
+
+	std::vector<u8> decompressed;
+	if (isCompressed)
+	{
+		// Packets may cross rows, so they are expanded front to back before the rows are converted in parallel.
+		decompressed.resize(rowSize * height);
+		if (!Decompress(source, file.GetData() + file.GetSize(), bytesPerPixel, decompressed.data(), decompressed.size()))
+			return nullptr;
+		source = decompressed.data();
+	}
+	else if (file.GetSize() - dataOffset < rowSize * height)
+	{
+		return nullptr;
+	}
+
+	ImageData* image = new ImageData(width, height, isGrayscale ? 1 : 4, generateMipChain, false);
+	f32* pixels = image->GetPixels(0);
+	const u64 pitch = static_cast<u64>(width) * image->GetChannelCount();
+	// Bit 5 of the descriptor is set when the file starts with the top row, otherwise it starts with the bottom row.
+	const bool isTopDown = (header.imageDescriptor & 0x20) != 0;
+
+	ThreadPool::Instance().ParallelFor(height, [&](u32 begin, u32 end)
+	{
+		for (u32 y = begin; y < end; ++y)
 		{
-            file.read(pixel, 4);
-            data[0] = Convert(pixel[2]);
-            data[1] = Convert(pixel[1]);
-            data[2] = Convert(pixel[0]);
-            data[3] = Convert(pixel[3]);
-            data += 4;
+			u32 fileRow = isTopDown ? y : height - 1 - y;
+			ConvertRow(source + fileRow * rowSize, width, bytesPerPixel, pixels + y * pitch);
 		}
-    }
+	});
+	// The file holds only the top level, the lower levels were allocated without clearing.
+	if (generateMipChain)
+		image->GenerateMips(0);
+	return image;
 }
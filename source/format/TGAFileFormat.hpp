@@ -4,10 +4,12 @@
 
 #include <string>
 
+class ImageData;
+
 class TGAFileFormat
 {
 private:
-    __pragma (pack(push, 1))
+#pragma pack(push, 1)
 	struct Header
 	{
 		u8 length;
@@ -23,13 +25,25 @@ private:
 		u8 bitsPerPixel;
 		u8 imageDescriptor;
 	};
-	__pragma (pack(pop))
+#pragma pack(pop)
 
 public:
-	static void Save(const f32* const pixels, u32 width, u32 height, u32 channels, const std::string& fileName);
-    static void Load(f32*& pixels, u32& width, u32& height, const std::string& fileName);
+	// Writes 1 channel images as grayscale, 3 and 4 channel images as true color. Compressed images use RLE packets.
+	static void Save(const f32* const pixels, u32 width, u32 height, u32 channels, const std::string& fileName, bool compress = false);
+    // Reads uncompressed or RLE (types 2, 3, 10 and 11) true color and grayscale images into a 4 or 1 channel image.
+    // Returns nullptr when the file cannot be read or the format is not supported.
+    static ImageData* Load(const std::string& fileName, bool generateMipChain);
 
 private:
-    static u8 Convert(f32 value);
-    static f32 Convert(char value);
+    // Converts a row of pixels to the byte order of the file.
+    static void ConvertRow(const f32* pixels, u32 width, u32 channels, u8* destination);
+    // Converts a row of the file to RGBA or grayscale pixels.
+    static void ConvertRow(const u8* row, u32 width, u32 bytesPerPixel, f32* destination);
+    // Writes the RLE packets of a converted row and returns their size.
+    static u64 Compress(const u8* row, u32 width, u32 bytesPerPixel, u8* destination);
+    // Returns the first pixel in [begin; end) that is (or is not) equal to the next one, or end if there is none.
+    static u32 FindRepeat(const u8* row, u32 begin, u32 end, u32 bytesPerPixel, bool isRepeated);
+    // Returns false when the packets end before the destination is filled.
+    static bool Decompress(const u8* source, const u8* sourceEnd, u32 bytesPerPixel, u8* destination, u64 size);
+    static f32 Convert(u8 value);
 };
\ No newline at end of file
@@ -0,0 +1,241 @@
+#include "TGAFileFormat.hpp"
+
+#include "image/ImageData.hpp"
+#include "testing/TestFixture.hpp"
+#include "testing/TestRunner.hpp"
+#include "testing/TestSuite.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+// Category 1: Uncompressed images
+// 1.1: 32 bit, saved and loaded, pixels are unchanged
+// 1.2: 24 bit, bottom-left origin, rows are flipped and alpha is 1
+// 1.3: Grayscale, one channel image
+// 1.4: Loaded with a mip chain, the lower levels are averaged from the top level
+// Category 2: RLE images
+// 2.1: 32 bit, runs and raw packets crossing rows
+// 2.2: Grayscale, runs and raw packets
+// 2.3: 32 bit, compressed, saved and loaded, pixels are unchanged
+// 2.4: Grayscale, compressed with runs longer than a packet, saved and loaded, pixels are unchanged
+// Category 3: Invalid files
+// 3.1: Missing file, nothing is loaded
+// 3.2: Truncated RLE data, nothing is loaded
+
+static const char* const kFileName = "tga_file_format_test.tga";
+
+struct TGAFileFormatFixture
+{
+	virtual ~TGAFileFormatFixture()
+	{
+		delete image;
+		std::remove(kFileName);
+	}
+
+	ImageData* image = nullptr;
+	std::vector<u8> bytes;
+
+	void AddHeader(u8 dataType, u16 width, u16 height, u8 bitsPerPixel, u8 imageDescriptor)
+	{
+		const u8 header[] = {
+			0, 0, dataType, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+			static_cast<u8>(width), static_cast<u8>(width >> 8),
+			static_cast<u8>(height), static_cast<u8>(height >> 8),
+			bitsPerPixel, imageDescriptor
+		};
+		bytes.assign(header, header + sizeof(header));
+	}
+
+	void Add(std::initializer_list<u8> values)
+	{
+		bytes.insert(bytes.end(), values);
+	}
+
+	void Load()
+	{
+		std::ofstream file(kFileName, std::ios::binary);
+		file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+		file.close();
+		image = TGAFileFormat::Load(kFileName, false);
+	}
+
+	bool PixelsEqual(const f32* expected, u32 count) const
+	{
+		const f32* pixels = image->GetPixels(0);
+		for (u32 i = 0; i < count; ++i)
+		{
+			if (pixels[i] != expected[i])
+				return false;
+		}
+		return true;
+	}
+};
+
+// Category 1: Uncompressed images
+TEST_SUITE(TGAFileFormat_Uncompressed)
+{
+	// 1.1: 32 bit, saved and loaded, pixels are unchanged
+	TEST_FIXTURE(TGAFileFormatFixture, ThirtyTwoBit_SaveAndLoad_PixelsUnchanged)
+	{
+		const u32 width = 13;
+		const u32 height = 3;
+		std::vector<f32> expected(width * height * 4);
+		for (u32 i = 0; i < expected.size(); ++i)
+			expected[i] = static_cast<f32>((i * 37) % 256) / 255.0f;
+		TGAFileFormat::Save(expected.data(), width, height, 4, kFileName);
+
+		image = TGAFileFormat::Load(kFileName, false);
+
+		Check(image != nullptr);
+		Check(image->GetWidth() == width && image->GetHeight() == height && image->GetChannelCount() == 4);
+		Check(PixelsEqual(expected.data(), width * height * 4));
+	}
+
+	// 1.2: 24 bit, bottom-left origin, rows are flipped and alpha is 1
+	TEST_FIXTURE(TGAFileFormatFixture, TwentyFourBitBottomLeft_Load_RowsFlippedAndOpaque)
+	{
+		AddHeader(2, 1, 2, 24, 0);
+		Add({ 0, 0, 255 });
+		Add({ 255, 0, 0 });
+		const f32 expected[] = {
+			0.0f, 0.0f, 1.0f, 1.0f,
+			1.0f, 0.0f, 0.0f, 1.0f
+		};
+
+		Load();
+
+		Check(image != nullptr);
+		Check(image->GetChannelCount() == 4);
+		Check(PixelsEqual(expected, 8));
+	}
+
+	// 1.3: Grayscale, one channel image
+	TEST_FIXTURE(TGAFileFormatFixture, Grayscale_Load_OneChannel)
+	{
+		AddHeader(3, 3, 1, 8, 32);
+		Add({ 0, 51, 255 });
+		const f32 expected[] = { 0.0f, 0.2f, 1.0f };
+
+		Load();
+
+		Check(image != nullptr);
+		Check(image->GetChannelCount() == 1);
+		Check(PixelsEqual(expected, 3));
+	}
+
+	// 1.4: Loaded with a mip chain, the lower levels are averaged from the top level
+	TEST_FIXTURE(TGAFileFormatFixture, MipChain_Load_LowerLevelsAveraged)
+	{
+		const u32 width = 8;
+		const u32 height = 4;
+		std::vector<f32> expected(width * height);
+		for (u32 i = 0; i < expected.size(); ++i)
+			expected[i] = static_cast<f32>(i % 2 == 0 ? 100 : 200) / 255.0f;
+		TGAFileFormat::Save(expected.data(), width, height, 1, kFileName);
+
+		image = TGAFileFormat::Load(kFileName, true);
+
+		Check(image != nullptr);
+		Check(image->GetMipLevelCount() > 2);
+		const f32* mip = image->GetPixels(2);
+		const f32 average = (expected[0] + expected[1]) * 0.5f;
+		Check(mip[0] > average - 1e-6f && mip[0] < average + 1e-6f);
+		Check(mip[1] > average - 1e-6f && mip[1] < average + 1e-6f);
+	}
+}
+
+// Category 2: RLE images
+TEST_SUITE(TGAFileFormat_Rle)
+{
+	// 2.1: 32 bit, runs and raw packets crossing rows
+	TEST_FIXTURE(TGAFileFormatFixture, ThirtyTwoBit_Load_PacketsExpanded)
+	{
+		AddHeader(10, 2, 2, 32, 40);
+		Add({ 0x82, 255, 0, 0, 255 });
+		Add({ 0x00, 0, 255, 0, 0 });
+		const f32 expected[] = {
+			0.0f, 0.0f, 1.0f, 1.0f,
+			0.0f, 0.0f, 1.0f, 1.0f,
+			0.0f, 0.0f, 1.0f, 1.0f,
+			0.0f, 1.0f, 0.0f, 0.0f
+		};
+
+		Load();
+
+		Check(image != nullptr);
+		Check(PixelsEqual(expected, 16));
+	}
+
+	// 2.2: Grayscale, runs and raw packets
+	TEST_FIXTURE(TGAFileFormatFixture, Grayscale_Load_PacketsExpanded)
+	{
+		AddHeader(11, 5, 1, 8, 32);
+		Add({ 0x01, 0, 255 });
+		Add({ 0x82, 51 });
+		const f32 expected[] = { 0.0f, 1.0f, 0.2f, 0.2f, 0.2f };
+
+		Load();
+
+		Check(image != nullptr);
+		Check(image->GetChannelCount() == 1);
+		Check(PixelsEqual(expected, 5));
+	}
+
+	// 2.3: 32 bit, compressed, saved and loaded, pixels are unchanged
+	TEST_FIXTURE(TGAFileFormatFixture, ThirtyTwoBit_CompressAndLoad_PixelsUnchanged)
+	{
+		const u32 width = 45;
+		const u32 height = 4;
+		std::vector<f32> expected(width * height * 4);
+		for (u32 i = 0; i < expected.size(); ++i)
+			expected[i] = static_cast<f32>((i / 4 / 3) % 5 == 0 ? i % 256 : i % 4) / 255.0f;
+		TGAFileFormat::Save(expected.data(), width, height, 4, kFileName, true);
+
+		image = TGAFileFormat::Load(kFileName, false);
+
+		Check(image != nullptr);
+		Check(image->GetChannelCount() == 4);
+		Check(PixelsEqual(expected.data(), width * height * 4));
+	}
+
+	// 2.4: Grayscale, compressed with runs longer than a packet, saved and loaded, pixels are unchanged
+	TEST_FIXTURE(TGAFileFormatFixture, GrayscaleLongRuns_CompressAndLoad_PixelsUnchanged)
+	{
+		const u32 width = 300;
+		const u32 height = 3;
+		std::vector<f32> expected(width * height);
+		for (u32 i = 0; i < expected.size(); ++i)
+			expected[i] = static_cast<f32>(i % width < 200 ? (i / width) * 50 : (i * 31) % 7) / 255.0f;
+		TGAFileFormat::Save(expected.data(), width, height, 1, kFileName, true);
+
+		image = TGAFileFormat::Load(kFileName, false);
+
+		Check(image != nullptr);
+		Check(image->GetChannelCount() == 1);
+		Check(PixelsEqual(expected.data(), width * height));
+	}
+}
+
+// Category 3: Invalid files
+TEST_SUITE(TGAFileFormat_Invalid)
+{
+	// 3.1: Missing file, nothing is loaded
+	TEST_FIXTURE(TGAFileFormatFixture, MissingFile_Load_ReturnsNull)
+	{
+		image = TGAFileFormat::Load("missing_file_format_test.tga", false);
+
+		Check(image == nullptr);
+	}
+
+	// 3.2: Truncated RLE data, nothing is loaded
+	TEST_FIXTURE(TGAFileFormatFixture, TruncatedRle_Load_ReturnsNull)
+	{
+		AddHeader(11, 4, 4, 8, 32);
+		Add({ 0x83, 10 });
+
+		Load();
+
+		Check(image == nullptr);
+	}
+}
@@ -22,3 +22,31 @@ f32 bilerp(f32 tl, f32 tr, f32 bl, f32 br, f32 yWeight, f32 invYWeight, f32 xWei
     f32 b = fmaf(bl, invXWeight, br * xWeight);
     return fmaf(t, invYWeight, b * yWeight);
 }
+
+void locateLatticeCell(u32 position, u32 weightCount, u32 latticeStride, u32 maxLatticeIndex,
+    u32& outWeightIndex, u32& outFirstIndex, u32& outSecondIndex)
+{
+    // The walk advances to the next lattice cell after every weightCount positions, or after every position
+    // when a mip is smaller than the lattice.
+    u32 cellSize = weightCount > 0 ? weightCount : 1;
+    u32 cell = position / cellSize;
+    outWeightIndex = position - cell * cellSize;
+
+    u32 first = cell * latticeStride;
+    u32 second = first + latticeStride;
+    outFirstIndex = first > maxLatticeIndex ? maxLatticeIndex : first;
+    outSecondIndex = second > maxLatticeIndex ? maxLatticeIndex : second;
+}
+
+u32 wrapLatticeCell(i32 cell, u32 period)
+{
+    i64 index = static_cast<i64>(cell) % static_cast<i64>(period);
+    return static_cast<u32>(index < 0 ? index + period : index);
+}
+
+f32 wrapCoordinate(f32 x, f32 period)
+{
+    // fmodf is exact, so points inside the first period keep their coordinates and x + period wraps to x.
+    f32 wrapped = fmodf(x, period);
+    return wrapped < 0.0f ? wrapped + period : wrapped;
+}
@@ -6,3 +6,11 @@
 
 void generateWeights(u32 count, std::vector<f32>& outWeights);
 f32 bilerp(f32 tl, f32 tr, f32 bl, f32 br, f32 yWeight, f32 invYWeight, f32 xWeight);
+// Finds the weight index and the pair of clamped lattice indices that a lattice walk reaches at the given position.
+void locateLatticeCell(u32 position, u32 weightCount, u32 latticeStride, u32 maxLatticeIndex,
+    u32& outWeightIndex, u32& outFirstIndex, u32& outSecondIndex);
+// Index of a cell in a lattice that repeats every period cells, for cells on both sides of 0.
+u32 wrapLatticeCell(i32 cell, u32 period);
+// Moves x into [0; period] of a pattern that repeats every period units, so the cells around it fit in an i32 however
+// far from 0 x lies. NaN and infinities give NaN.
+f32 wrapCoordinate(f32 x, f32 period);
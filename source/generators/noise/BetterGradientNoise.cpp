@@ -4,15 +4,28 @@
 #include "generators/NoiseCommon.hpp"
 
 #include "image/ImageData.hpp"
+#include "utility/Profiler.hpp"
 #include "utility/Random.hpp"
+#include "utility/Simd.hpp"
+#include "utility/ThreadPool.hpp"
 
 #include <cassert>
+#include <cmath>
+#include <mutex>
 
 static std::vector<f32> sGradientsX;
 static std::vector<f32> sGradientsY;
+// Volumes only, images use the x and y components.
+static std::vector<f32> sGradientsZ;
 static std::vector<u32> sPermutationsX;
 static std::vector<u32> sPermutationsY;
 static std::vector<u32> sPermutationsZ;
+static std::once_flag sTablesBuilt;
+
+// Points are evaluated in blocks: the gradients of the 4x4 taps of a block are looked up first, then combined 8 points
+// at a time.
+static constexpr u32 kPointBlockSize = 32;
+static constexpr u32 kTapCount = 16;
 
 struct Hasher
 {
@@ -73,16 +86,14 @@ static void initialize(u32 count, Random& rng, std::vector<u32>& permutations, s
         permutations.push_back(permutations[i]);
 }
 
-template<class Interpolator>
-void BetterGradientNoise<Interpolator>::EnsureInitialized()
+// Batch jobs generate on several threads at once, whichever needs the tables first builds them.
+static void buildTables()
 {
-    if (!sGradientsX.empty())
-        return;
-
     static constexpr u32 kCount = 256;
 
     sGradientsX.reserve(kCount);
     sGradientsY.reserve(kCount);
+    sGradientsZ.reserve(kCount);
 
     Random rand(2);
 
@@ -94,6 +105,7 @@ void BetterGradientNoise<Interpolator>::EnsureInitialized()
         f32 n = x * x + y * y + z * z;
         sGradientsX.push_back(x / n);
         sGradientsY.push_back(y / n);
+        sGradientsZ.push_back(z / n);
     }
 
     sPermutationsX.reserve(kCount * 2);
@@ -105,13 +117,17 @@ void BetterGradientNoise<Interpolator>::EnsureInitialized()
     initialize(kCount, rand, sPermutationsZ, original);
 }
 
+template<class Interpolator>
+void BetterGradientNoise<Interpolator>::EnsureInitialized()
+{
+    std::call_once(sTablesBuilt, buildTables);
+}
+
 template<class Interpolator>
 void BetterGradientNoise<Interpolator>::Generate(const Parameters& parameters,
     const Lattice& latticeX, const Lattice& latticeY, ImageData& data)
 {
-    EnsureInitialized();
-
-    Hasher hasher;
+    PROFILE_SCOPE_BYTES("pixels", data.GetByteCount());
 
     const u32 maxLatticeY = static_cast<const u32>(latticeX.size());
     const u32 maxLatticeX = static_cast<const u32>(latticeX[0].size());
@@ -136,116 +152,264 @@ void BetterGradientNoise<Interpolator>::Generate(const Parameters& parameters,
         generateWeights(yWeightCount, yWeights);
 
         f32* pixels = data.GetPixels(mip);
-        u32 index = 0;
-        u32 topIndex0 = maxLatticeY - latticeYStride;
-        u32 topIndex1 = 0;
-        u32 topIndex2 = latticeYStride;
-        u32 topIndex3 = latticeYStride * 2;
-        u32 yWeightIndex = 0;
-        for (u32 y = 0; y < h; ++y)
+        u32 firstRow;
+        u32 rowCount;
+        data.GetRows(mip, firstRow, rowCount);
+        ThreadPool::Instance().ParallelFor(rowCount, [&](u32 begin, u32 end)
         {
-            const std::vector<u32>* xTops[] = {
-                &latticeX[topIndex0],
-                &latticeX[topIndex1],
-                &latticeX[topIndex2],
-                &latticeX[topIndex3]
-            };
-            const std::vector<u32>* yTops[] = {
-                &latticeY[topIndex0],
-                &latticeY[topIndex1],
-                &latticeY[topIndex2],
-                &latticeY[topIndex3]
-            };
-            u32 xWeightIndex = 0;
-            u32 leftIndex0 = maxLatticeX - latticeXStride;
-            u32 leftIndex1 = 0;
-            u32 leftIndex2 = latticeXStride;
-            u32 leftIndex3 = latticeXStride * 2;
-            f32 y0 = yWeights[yWeightIndex];
-            for (u32 x = 0; x < w; ++x)
+            u32 yBegin = firstRow + begin;
+            u32 yEnd = firstRow + end;
+            u64 index = static_cast<u64>(begin) * w;
+            u32 yCellSize = yWeightCount > 0 ? yWeightCount : 1;
+            u32 yCell = yBegin / yCellSize;
+            u32 yWeightIndex = yBegin - yCell * yCellSize;
+            u32 yOffset = yCell * latticeYStride;
+            u32 topIndex0 = (maxLatticeY - latticeYStride + yOffset) % maxLatticeY;
+            u32 topIndex1 = yOffset % maxLatticeY;
+            u32 topIndex2 = (latticeYStride + yOffset) % maxLatticeY;
+            u32 topIndex3 = (latticeYStride * 2 + yOffset) % maxLatticeY;
+            for (u32 y = yBegin; y < yEnd; ++y)
             {
-                f32 x0 = xWeights[xWeightIndex];
-                f32 value = 0.0f;
-
-                u32 topIndex = 0;
-                for (i32 j = -1; j < 3; ++j)
+                const u32 topIndices[] = {
+                    topIndex0,
+                    topIndex1,
+                    topIndex2,
+                    topIndex3
+                };
+                u32 leftIndices[] = {
+                    maxLatticeX - latticeXStride,
+                    0,
+                    latticeXStride % maxLatticeX,
+                    (latticeXStride * 2) % maxLatticeX
+                };
+                // Gradients of the 4x4 lattice points around the current cell, reloaded when the cell changes.
+                f32 tapsX[16];
+                f32 tapsY[16];
+                bool tapsLoaded = false;
+                u32 xWeightIndex = 0;
+                f32 y0 = yWeights[yWeightIndex];
+                for (u32 x = 0; x < w; ++x)
                 {
-                    f32 dy = y0 - static_cast<f32>(j);
-                    const std::vector<u32>& xTop = *xTops[topIndex];
-                    const std::vector<u32>& yTop = *yTops[topIndex];
-                    const u32* xRow[] = {
-                        &xTop[leftIndex0],
-                        &xTop[leftIndex1],
-                        &xTop[leftIndex2],
-                        &xTop[leftIndex3]
-                    };
-                    const u32* yRow[] = {
-                        &yTop[leftIndex0],
-                        &yTop[leftIndex1],
-                        &yTop[leftIndex2],
-                        &yTop[leftIndex3]
-                    };
-                    u32 rowIndex = 0;
-                    for (i32 i = -1; i < 3; ++i)
+                    if (!tapsLoaded)
                     {
-                        f32 dx = x0 - static_cast<f32>(i);
+                        for (u32 j = 0; j < 4; ++j)
+                        {
+                            const std::vector<f32>& rowX = latticeX[topIndices[j]];
+                            const std::vector<f32>& rowY = latticeY[topIndices[j]];
+                            for (u32 i = 0; i < 4; ++i)
+                            {
+                                tapsX[j * 4 + i] = rowX[leftIndices[i]];
+                                tapsY[j * 4 + i] = rowY[leftIndices[i]];
+                            }
+                        }
+                        tapsLoaded = true;
+                    }
 
-                        f32 dist = dx * dx + dy * dy;
-                        if (dist < 4.0f)
+                    f32 x0 = xWeights[xWeightIndex];
+                    f32 value = 0.0f;
+
+                    u32 tap = 0;
+                    for (i32 j = -1; j < 3; ++j)
+                    {
+                        f32 dy = y0 - static_cast<f32>(j);
+                        for (i32 i = -1; i < 3; ++i)
                         {
-                            u32 hash = hasher(*xRow[rowIndex], *yRow[rowIndex], 0);
-                            f32 t = fmaf(dist, -0.25f, 1.0f);
-                            f32 t2 = t * t;
-                            f32 t4 = t2 * t2;
-                            f32 poly = fmaf(t * t4, 4.0f, -t4 * 3.0f);
+                            f32 dx = x0 - static_cast<f32>(i);
+
+                            f32 dist = dx * dx + dy * dy;
+                            if (dist < 4.0f)
+                            {
+                                f32 t = fmaf(dist, -0.25f, 1.0f);
+                                f32 t2 = t * t;
+                                f32 t4 = t2 * t2;
+                                f32 poly = fmaf(t * t4, 4.0f, -t4 * 3.0f);
+
+                                value += fmaf(dx, tapsX[tap], dy * tapsY[tap]) * poly;
+                            }
+                            ++tap;
+                        }
+                    }
+                
+                    pixels[index] = fmaf(value, 0.5f, 0.5f);
 
-                            value += fmaf(dx, sGradientsX[hash], dy * sGradientsY[hash]) * poly;
+                    ++index;
+                    ++xWeightIndex;
+                    if (xWeightIndex >= xWeightCount)
+                    {
+                        xWeightIndex = 0;
+                        for (u32 i = 0; i < 4; ++i)
+                        {
+                            leftIndices[i] += latticeXStride;
+                            if (leftIndices[i] >= maxLatticeX)
+                                leftIndices[i] -= maxLatticeX;
                         }
-                        ++rowIndex;
+                        tapsLoaded = false;
                     }
-                    ++topIndex;
                 }
-                
-                pixels[index] = fmaf(value, 0.5f, 0.5f);
+                ++yWeightIndex;
+                if (yWeightIndex >= yWeightCount)
+                {
+                    yWeightIndex = 0;
+                    topIndex0 += latticeYStride;
+                    topIndex1 += latticeYStride;
+                    topIndex2 += latticeYStride;
+                    topIndex3 += latticeYStride;
+
+                    if (topIndex0 >= maxLatticeY)
+                        topIndex0 -= maxLatticeY;
+                    if (topIndex1 >= maxLatticeY)
+                        topIndex1 -= maxLatticeY;
+                    if (topIndex2 >= maxLatticeY)
+                        topIndex2 -= maxLatticeY;
+                    if (topIndex3 >= maxLatticeY)
+                        topIndex3 -= maxLatticeY;
+                }
+            }
+        });
+    }
+}
 
-                ++index;
-                ++xWeightIndex;
-                if (xWeightIndex >= xWeightCount)
+// Lattice row or column of a tap. Images walk a lattice that repeats the first column after the last one modulo
+// latticeWidth + 1, so taps past either edge read the gradients of column 0.
+static u32 tapIndex(i32 cell, u32 period)
+{
+    u32 index = wrapLatticeCell(cell, period + 1);
+    return index == period ? 0 : index;
+}
+
+// Sums the 16 taps around each point in the same order as the image loop, taps out of reach add nothing.
+static void evaluatePoints(const f32 tapsX[][kPointBlockSize], const f32 tapsY[][kPointBlockSize],
+    const f32* xOffsets, const f32* yOffsets, u32 count, f32* out)
+{
+    u32 k = 0;
+
+#if NOISE_SIMD_AVX2
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 four = _mm256_set1_ps(4.0f);
+    const __m256 three = _mm256_set1_ps(3.0f);
+    const __m256 minusQuarter = _mm256_set1_ps(-0.25f);
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    for (; k + 8 <= count; k += 8)
+    {
+        __m256 x0 = _mm256_loadu_ps(xOffsets + k);
+        __m256 y0 = _mm256_loadu_ps(yOffsets + k);
+        __m256 value = _mm256_setzero_ps();
+
+        u32 tap = 0;
+        for (i32 j = -1; j < 3; ++j)
+        {
+            __m256 dy = _mm256_sub_ps(y0, _mm256_set1_ps(static_cast<f32>(j)));
+            for (i32 i = -1; i < 3; ++i)
+            {
+                __m256 dx = _mm256_sub_ps(x0, _mm256_set1_ps(static_cast<f32>(i)));
+
+                __m256 dist = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+                __m256 isInRange = _mm256_cmp_ps(dist, four, _CMP_LT_OQ);
+                __m256 t = _mm256_fmadd_ps(dist, minusQuarter, one);
+                __m256 t2 = _mm256_mul_ps(t, t);
+                __m256 t4 = _mm256_mul_ps(t2, t2);
+                __m256 poly = _mm256_fmadd_ps(_mm256_mul_ps(t, t4), four, _mm256_mul_ps(_mm256_xor_ps(t4, sign), three));
+
+                __m256 gradient = _mm256_fmadd_ps(dx, _mm256_loadu_ps(tapsX[tap] + k), _mm256_mul_ps(dy, _mm256_loadu_ps(tapsY[tap] + k)));
+                value = _mm256_add_ps(value, _mm256_and_ps(_mm256_mul_ps(gradient, poly), isInRange));
+                ++tap;
+            }
+        }
+
+        _mm256_storeu_ps(out + k, _mm256_fmadd_ps(value, half, half));
+    }
+#endif
+
+    for (; k < count; ++k)
+    {
+        f32 value = 0.0f;
+
+        u32 tap = 0;
+        for (i32 j = -1; j < 3; ++j)
+        {
+            f32 dy = yOffsets[k] - static_cast<f32>(j);
+            for (i32 i = -1; i < 3; ++i)
+            {
+                f32 dx = xOffsets[k] - static_cast<f32>(i);
+
+                f32 dist = dx * dx + dy * dy;
+                if (dist < 4.0f)
                 {
-                    xWeightIndex = 0;
-                    leftIndex0 += latticeXStride;
-                    leftIndex1 += latticeXStride;
-                    leftIndex2 += latticeXStride;
-                    leftIndex3 += latticeXStride;
-
-                    if (leftIndex0 >= maxLatticeX)
-                        leftIndex0 -= maxLatticeX;
-                    if (leftIndex1 >= maxLatticeX)
-                        leftIndex1 -= maxLatticeX;
-                    if (leftIndex2 >= maxLatticeX)
-                        leftIndex2 -= maxLatticeX;
-                    if (leftIndex3 >= maxLatticeX)
-                        leftIndex3 -= maxLatticeX;
+                    f32 t = fmaf(dist, -0.25f, 1.0f);
+                    f32 t2 = t * t;
+                    f32 t4 = t2 * t2;
+                    f32 poly = fmaf(t * t4, 4.0f, -t4 * 3.0f);
+
+                    value += fmaf(dx, tapsX[tap][k], dy * tapsY[tap][k]) * poly;
                 }
+                ++tap;
             }
-            ++yWeightIndex;
-            if (yWeightIndex >= yWeightCount)
+        }
+
+        out[k] = fmaf(value, 0.5f, 0.5f);
+    }
+}
+
+template<class Interpolator>
+void BetterGradientNoise<Interpolator>::Evaluate(const Parameters& parameters, const f32* xs, const f32* ys, f32* out, size_t n)
+{
+    EnsureInitialized();
+
+    Hasher hasher;
+
+    f32 tapsX[kTapCount][kPointBlockSize];
+    f32 tapsY[kTapCount][kPointBlockSize];
+    f32 xOffsets[kPointBlockSize];
+    f32 yOffsets[kPointBlockSize];
+    for (size_t first = 0; first < n; first += kPointBlockSize)
+    {
+        u32 count = n - first < kPointBlockSize ? static_cast<u32>(n - first) : kPointBlockSize;
+        f32 previousCellX = NAN;
+        f32 previousCellY = NAN;
+        for (u32 k = 0; k < count; ++k)
+        {
+            // NaN takes the taps of cell 0, its result is replaced after the block.
+            f32 x = wrapCoordinate(xs[first + k], static_cast<f32>(parameters.latticeWidth));
+            f32 y = wrapCoordinate(ys[first + k], static_cast<f32>(parameters.latticeHeight));
+            f32 cellX = std::isnan(x) ? 0.0f : floorf(x);
+            f32 cellY = std::isnan(y) ? 0.0f : floorf(y);
+            xOffsets[k] = x - cellX;
+            yOffsets[k] = y - cellY;
+
+            // Neighbouring points mostly share a cell, its taps are only hashed again when the cell changes.
+            if (cellX == previousCellX && cellY == previousCellY)
             {
-                yWeightIndex = 0;
-                topIndex0 += latticeYStride;
-                topIndex1 += latticeYStride;
-                topIndex2 += latticeYStride;
-                topIndex3 += latticeYStride;
-
-                if (topIndex0 >= maxLatticeY)
-                    topIndex0 -= maxLatticeY;
-                if (topIndex1 >= maxLatticeY)
-                    topIndex1 -= maxLatticeY;
-                if (topIndex2 >= maxLatticeY)
-                    topIndex2 -= maxLatticeY;
-                if (topIndex3 >= maxLatticeY)
-                    topIndex3 -= maxLatticeY;
+                for (u32 tap = 0; tap < kTapCount; ++tap)
+                {
+                    tapsX[tap][k] = tapsX[tap][k - 1];
+                    tapsY[tap][k] = tapsY[tap][k - 1];
+                }
+                continue;
             }
+            previousCellX = cellX;
+            previousCellY = cellY;
+
+            i32 left = static_cast<i32>(wrapLatticeCell(static_cast<i32>(cellX), parameters.latticeWidth));
+            i32 top = static_cast<i32>(wrapLatticeCell(static_cast<i32>(cellY), parameters.latticeHeight));
+            for (i32 j = 0; j < 4; ++j)
+            {
+                u32 row = tapIndex(top + j - 1, parameters.latticeHeight);
+                for (i32 i = 0; i < 4; ++i)
+                {
+                    u32 hash = hasher(tapIndex(left + i - 1, parameters.latticeWidth), row, 0);
+                    tapsX[j * 4 + i][k] = sGradientsX[hash];
+                    tapsY[j * 4 + i][k] = sGradientsY[hash];
+                }
+            }
+        }
+
+        evaluatePoints(tapsX, tapsY, xOffsets, yOffsets, count, out + first);
+        // Taps out of range are masked by a comparison that NaN fails, which would leave 0.5.
+        for (u32 k = 0; k < count; ++k)
+        {
+            if (std::isnan(xOffsets[k]) || std::isnan(yOffsets[k]))
+                out[first + k] = NAN;
         }
     }
 }
@@ -258,26 +422,34 @@ void BetterGradientNoise<Interpolator>::GenerateSimple(const Parameters& paramet
     assert(w % parameters.latticeWidth == 0);
     assert(h % parameters.latticeHeight == 0);
     
+    EnsureInitialized();
+
+    Hasher hasher;
+
     u32 yPoints = parameters.latticeHeight + 1;
     u32 xPoints = parameters.latticeWidth + 1;
     Lattice latticeX(yPoints);
     Lattice latticeY(yPoints);
-    for (u32 i = 0; i < yPoints; ++i)
     {
-        latticeX[i].resize(xPoints);
-        latticeY[i].resize(xPoints);
-    }
+        PROFILE_SCOPE("lattice");
+        for (u32 i = 0; i < yPoints; ++i)
+        {
+            latticeX[i].resize(xPoints);
+            latticeY[i].resize(xPoints);
+        }
 
-    for (u32 y = 0; y < yPoints; ++y)
-    {
-        std::vector<u32>& rowX = latticeX[y];
-        std::vector<u32>& rowY = latticeY[y];
-        u32 j = y % parameters.latticeHeight;
-        for (u32 x = 0; x < xPoints; ++x)
+        for (u32 y = 0; y < yPoints; ++y)
         {
-            u32 i = x % parameters.latticeWidth;
-            rowX[x] = i;
-            rowY[x] = j;
+            std::vector<f32>& rowX = latticeX[y];
+            std::vector<f32>& rowY = latticeY[y];
+            u32 j = y % parameters.latticeHeight;
+            for (u32 x = 0; x < xPoints; ++x)
+            {
+                u32 i = x % parameters.latticeWidth;
+                u32 hash = hasher(i, j, 0);
+                rowX[x] = sGradientsX[hash];
+                rowY[x] = sGradientsY[hash];
+            }
         }
     }
 
@@ -298,34 +470,172 @@ void BetterGradientNoise<Interpolator>::GenerateWang(const Parameters& parameter
     u32 xPoints = parameters.latticeWidth + 1;
     Lattice latticeX(yPoints);
     Lattice latticeY(yPoints);
-    for (u32 i = 0; i < yPoints; ++i)
     {
-        latticeX[i].resize(xPoints);
-        latticeY[i].resize(xPoints);
+        PROFILE_SCOPE("lattice");
+        for (u32 i = 0; i < yPoints; ++i)
+        {
+            latticeX[i].resize(xPoints);
+            latticeY[i].resize(xPoints);
+        }
+
+        EnsureInitialized();
+
+        Hasher hasher;
+        WangWrap wrap;
+
+        u32 lw = parameters.latticeWidth;
+        u32 lh = parameters.latticeHeight;
+        u32 tw = parameters.latticeWidth / 4;
+        u32 th = parameters.latticeHeight / 4;
+
+        for (u32 y = 0; y < yPoints; ++y)
+        {
+            std::vector<f32>& rowX = latticeX[y];
+            std::vector<f32>& rowY = latticeY[y];
+            for (u32 x = 0; x < xPoints; ++x)
+            {
+                u32 i = x;
+                u32 j = y;
+                wrap(i, j, tw, th, lw, lh);
+                u32 hash = hasher(i, j, 0);
+                rowX[x] = sGradientsX[hash];
+                rowY[x] = sGradientsY[hash];
+            }
+        }
     }
 
-    WangWrap wrap;
+    Generate(parameters, latticeX, latticeY, data);
+}
 
-    u32 lw = parameters.latticeWidth;
-    u32 lh = parameters.latticeHeight;
-    u32 tw = parameters.latticeWidth / 4;
-    u32 th = parameters.latticeHeight / 4;
-    
-    for (u32 y = 0; y < yPoints; ++y)
+template<class Interpolator>
+void BetterGradientNoise<Interpolator>::GenerateSlice(const Parameters& parameters, u32 depth, u32 z, ImageData& data)
+{
+    PROFILE_SCOPE_BYTES("pixels", data.GetByteCount());
+
+    const u32 w = data.GetWidth();
+    const u32 h = data.GetHeight();
+    assert(w % parameters.latticeWidth == 0);
+    assert(h % parameters.latticeHeight == 0);
+    assert(depth % parameters.latticeDepth == 0);
+    assert(z < depth);
+    assert(data.GetMipLevelCount() == 1);
+
+    EnsureInitialized();
+
+    Hasher hasher;
+
+    std::vector<f32> zWeights;
+    u32 zWeightCount = depth / parameters.latticeDepth;
+    generateWeights(zWeightCount, zWeights);
+    i32 zCell = static_cast<i32>(z / zWeightCount);
+    f32 z0 = zWeights[z - static_cast<u32>(zCell) * zWeightCount];
+
+    // The taps reach two lattice planes in front of the slice and two behind it. Planes that are out of reach for the
+    // whole slice are skipped. Unlike images, the lattice wraps every latticeWidth x latticeHeight points.
+    const u32 planeSize = parameters.latticeWidth * parameters.latticeHeight;
+    std::vector<f32> planesX;
+    std::vector<f32> planesY;
+    std::vector<f32> planesZ;
+    std::vector<f32> planeOffsets;
+    for (i32 k = -1; k < 3; ++k)
     {
-        std::vector<u32>& rowX = latticeX[y];
-        std::vector<u32>& rowY = latticeY[y];
-        for (u32 x = 0; x < xPoints; ++x)
+        f32 dz = z0 - static_cast<f32>(k);
+        if (dz * dz >= 4.0f)
+            continue;
+
+        planeOffsets.push_back(dz);
+        u32 plane = wrapLatticeCell(zCell + k, parameters.latticeDepth);
+        for (u32 j = 0; j < parameters.latticeHeight; ++j)
         {
-            u32 i = x;
-            u32 j = y;
-            wrap(i, j, tw, th, lw, lh);
-            rowX[x] = i;
-            rowY[x] = j;
+            for (u32 i = 0; i < parameters.latticeWidth; ++i)
+            {
+                u32 hash = hasher(i, j, plane);
+                planesX.push_back(sGradientsX[hash]);
+                planesY.push_back(sGradientsY[hash]);
+                planesZ.push_back(sGradientsZ[hash]);
+            }
         }
     }
+    const u32 planeCount = static_cast<u32>(planeOffsets.size());
 
-    Generate(parameters, latticeX, latticeY, data);
+    std::vector<f32> xWeights;
+    std::vector<f32> yWeights;
+    u32 xWeightCount = w / parameters.latticeWidth;
+    u32 yWeightCount = h / parameters.latticeHeight;
+    generateWeights(xWeightCount, xWeights);
+    generateWeights(yWeightCount, yWeights);
+
+    f32* pixels = data.GetPixels(0);
+    ThreadPool::Instance().ParallelFor(h, [&](u32 begin, u32 end)
+    {
+        // Gradients of the 4x4 lattice points of every plane around the current cell, reloaded when the cell changes.
+        f32 tapsX[kTapCount * 4];
+        f32 tapsY[kTapCount * 4];
+        f32 tapsZ[kTapCount * 4];
+        u64 index = static_cast<u64>(begin) * w;
+        for (u32 y = begin; y < end; ++y)
+        {
+            i32 yCell = static_cast<i32>(y / yWeightCount);
+            f32 y0 = yWeights[y - static_cast<u32>(yCell) * yWeightCount];
+            u32 loadedCell = ~0u;
+            for (u32 x = 0; x < w; ++x)
+            {
+                u32 xCell = x / xWeightCount;
+                if (xCell != loadedCell)
+                {
+                    u32 tap = 0;
+                    for (u32 plane = 0; plane < planeCount; ++plane)
+                    {
+                        for (i32 j = -1; j < 3; ++j)
+                        {
+                            u32 row = plane * planeSize + wrapLatticeCell(yCell + j, parameters.latticeHeight) * parameters.latticeWidth;
+                            for (i32 i = -1; i < 3; ++i)
+                            {
+                                u32 point = row + wrapLatticeCell(static_cast<i32>(xCell) + i, parameters.latticeWidth);
+                                tapsX[tap] = planesX[point];
+                                tapsY[tap] = planesY[point];
+                                tapsZ[tap] = planesZ[point];
+                                ++tap;
+                            }
+                        }
+                    }
+                    loadedCell = xCell;
+                }
+
+                f32 x0 = xWeights[x - xCell * xWeightCount];
+                f32 value = 0.0f;
+
+                u32 tap = 0;
+                for (u32 plane = 0; plane < planeCount; ++plane)
+                {
+                    f32 dz = planeOffsets[plane];
+                    for (i32 j = -1; j < 3; ++j)
+                    {
+                        f32 dy = y0 - static_cast<f32>(j);
+                        for (i32 i = -1; i < 3; ++i)
+                        {
+                            f32 dx = x0 - static_cast<f32>(i);
+
+                            f32 dist = dx * dx + dy * dy + dz * dz;
+                            if (dist < 4.0f)
+                            {
+                                f32 t = fmaf(dist, -0.25f, 1.0f);
+                                f32 t2 = t * t;
+                                f32 t4 = t2 * t2;
+                                f32 poly = fmaf(t * t4, 4.0f, -t4 * 3.0f);
+
+                                value += fmaf(dx, tapsX[tap], fmaf(dy, tapsY[tap], dz * tapsZ[tap])) * poly;
+                            }
+                            ++tap;
+                        }
+                    }
+                }
+
+                pixels[index] = fmaf(value, 0.5f, 0.5f);
+                ++index;
+            }
+        }
+    });
 }
 
 template class BetterGradientNoise<FifthOrderInterpolator>;
@@ -0,0 +1,136 @@
+#include "FractalNoise.hpp"
+
+#include "BetterGradientNoise.hpp"
+#include "PerlinNoise.hpp"
+#include "ValueNoise.hpp"
+
+#include "generators/Interpolator.hpp"
+#include "image/ImageData.hpp"
+#include "utility/Profiler.hpp"
+#include "utility/ThreadPool.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+// Pixels of a row are summed in tiles, small enough for the coordinates, the octave and the sum to stay in L1.
+static constexpr u32 kTileSize = 256;
+
+// Every octave is shifted by this many cells more than the one before it, so that lattice points of different octaves
+// do not line up. A shift keeps the noise periodic, so it does not affect tiling.
+static constexpr f32 kOctaveShift = 0.618034f;
+
+template<class Noise>
+void FractalNoise<Noise>::GenerateSimple(const Parameters& parameters, ImageData& data)
+{
+    PROFILE_SCOPE_BYTES("pixels", data.GetByteCount());
+
+    assert(parameters.octaveCount > 0);
+
+    std::vector<typename Noise::Parameters> octaves(parameters.octaveCount, parameters.noise);
+    std::vector<f32> amplitudes(parameters.octaveCount);
+    f32 frequency = 1.0f;
+    f32 amplitude = 1.0f;
+    f32 amplitudeSum = 0.0f;
+    for (u32 octave = 0; octave < parameters.octaveCount; ++octave)
+    {
+        f32 latticeWidth = roundf(static_cast<f32>(parameters.noise.latticeWidth) * frequency);
+        f32 latticeHeight = roundf(static_cast<f32>(parameters.noise.latticeHeight) * frequency);
+        octaves[octave].latticeWidth = latticeWidth > 1.0f ? static_cast<u32>(latticeWidth) : 1;
+        octaves[octave].latticeHeight = latticeHeight > 1.0f ? static_cast<u32>(latticeHeight) : 1;
+        amplitudes[octave] = amplitude;
+        amplitudeSum += amplitude;
+        frequency *= parameters.lacunarity;
+        amplitude *= parameters.gain;
+    }
+    // Skipped octaves still count, so coarse levels keep the contrast of the top level.
+    const f32 normalization = 1.0f / amplitudeSum;
+
+    const u32 mips = data.GetMipLevelCount();
+    for (u32 mip = 0; mip < mips; ++mip)
+    {
+        u32 w;
+        u32 h;
+        data.GetDimensions(w, h, mip);
+
+        // The first octave is always kept, like the images of the noise itself.
+        u32 octaveCount = 1;
+        while (octaveCount < parameters.octaveCount && octaves[octaveCount].latticeWidth * 2 <= w &&
+            octaves[octaveCount].latticeHeight * 2 <= h)
+            ++octaveCount;
+
+        f32* pixels = data.GetPixels(mip);
+        u32 firstRow;
+        u32 rowCount;
+        data.GetRows(mip, firstRow, rowCount);
+        ThreadPool::Instance().ParallelFor(rowCount, [&](u32 begin, u32 end)
+        {
+            f32 xs[kTileSize];
+            f32 ys[kTileSize];
+            f32 values[kTileSize];
+            f32 sums[kTileSize];
+            u64 index = static_cast<u64>(begin) * w;
+            for (u32 y = firstRow + begin; y < firstRow + end; ++y)
+            {
+                for (u32 tile = 0; tile < w; tile += kTileSize)
+                {
+                    const u32 count = w - tile < kTileSize ? w - tile : kTileSize;
+                    for (u32 k = 0; k < count; ++k)
+                        sums[k] = 0.0f;
+
+                    for (u32 octave = 0; octave < octaveCount; ++octave)
+                    {
+                        const typename Noise::Parameters& noise = octaves[octave];
+                        const f32 xScale = static_cast<f32>(noise.latticeWidth) / static_cast<f32>(w);
+                        const f32 yScale = static_cast<f32>(noise.latticeHeight) / static_cast<f32>(h);
+                        const f32 shift = kOctaveShift * static_cast<f32>(octave);
+                        const f32 fy = fmaf(static_cast<f32>(y), yScale, shift);
+                        for (u32 k = 0; k < count; ++k)
+                        {
+                            xs[k] = fmaf(static_cast<f32>(tile + k), xScale, shift);
+                            ys[k] = fy;
+                        }
+
+                        Noise::Evaluate(noise, xs, ys, values, count);
+
+                        const f32 weight = amplitudes[octave];
+                        switch (parameters.mode)
+                        {
+                        case Mode::kFbm:
+                            for (u32 k = 0; k < count; ++k)
+                                sums[k] = fmaf(weight, fmaf(values[k], 2.0f, -1.0f), sums[k]);
+                            break;
+                        case Mode::kRidged:
+                            for (u32 k = 0; k < count; ++k)
+                            {
+                                f32 ridge = 1.0f - fabsf(fmaf(values[k], 2.0f, -1.0f));
+                                sums[k] = fmaf(weight, ridge * ridge, sums[k]);
+                            }
+                            break;
+                        case Mode::kTurbulence:
+                            for (u32 k = 0; k < count; ++k)
+                                sums[k] = fmaf(weight, fabsf(fmaf(values[k], 2.0f, -1.0f)), sums[k]);
+                            break;
+                        }
+                    }
+
+                    // Sums of signed octaves are centered on 0.5, the others already lie in [0; 1].
+                    const f32 offset = parameters.mode == Mode::kFbm ? 0.5f : 0.0f;
+                    const f32 scale = parameters.mode == Mode::kFbm ? 0.5f * normalization : normalization;
+                    for (u32 k = 0; k < count; ++k)
+                    {
+                        f32 value = fmaf(sums[k], scale, offset);
+                        value = value > 1.0f ? 1.0f : value;
+                        value = value < 0.0f ? 0.0f : value;
+                        pixels[index + tile + k] = value;
+                    }
+                }
+                index += w;
+            }
+        });
+    }
+}
+
+template class FractalNoise<ValueNoise<LinearInterpolator>>;
+template class FractalNoise<PerlinNoise<FifthOrderInterpolator>>;
+template class FractalNoise<BetterGradientNoise<FifthOrderInterpolator>>;
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "utility/Types.hpp"
+
+class ImageData;
+
+// Sums octaves of a lattice noise in a single pass over the image. Every octave is sampled through the Evaluate of the
+// noise, a tile of pixels at a time, so no image is made per octave and nothing is quantized between octaves.
+template<class Noise>
+class FractalNoise
+{
+public:
+    enum class Mode
+    {
+        // Octaves are summed as they are.
+        kFbm,
+        // Sharp crests where the noise crosses its midpoint: (1 - |n|)^2 is summed.
+        kRidged,
+        // Creases where the noise crosses its midpoint: |n| is summed.
+        kTurbulence,
+    };
+
+    struct Parameters
+    {
+        // Parameters of the first octave.
+        typename Noise::Parameters noise;
+        Mode mode;
+        u32 octaveCount;
+        // Factor between the lattice sizes of consecutive octaves.
+        f32 lacunarity;
+        // Factor between the amplitudes of consecutive octaves.
+        f32 gain;
+    };
+
+    // The lattice of every octave is rounded to whole cells, so the sum tiles like its first octave. Octaves with
+    // cells smaller than 2 pixels of a mip level are above its Nyquist limit and skipped there.
+    static void GenerateSimple(const Parameters& parameters, ImageData& data);
+};
@@ -0,0 +1,96 @@
+#include "FractalNoise.hpp"
+
+#include "PerlinNoise.hpp"
+#include "ValueNoise.hpp"
+
+#include "generators/Interpolator.hpp"
+#include "image/ImageData.hpp"
+
+#include "testing/TestFixture.hpp"
+#include "testing/TestRunner.hpp"
+#include "testing/TestSuite.hpp"
+
+#include <cmath>
+
+// Category 1: Octaves
+// 1.1: One octave of fbm is the noise itself, for value and Perlin noise
+// 1.2: Mip levels skip the octaves above their Nyquist limit but keep the first one
+
+struct FractalNoiseFixture
+{
+	static constexpr u32 kSize = 64;
+
+	virtual ~FractalNoiseFixture() = default;
+
+	// Largest difference between the pixels of mip level mip of two images.
+	static f32 GetMaxDifference(const ImageData& a, const ImageData& b, u32 mip)
+	{
+		u32 w;
+		u32 h;
+		a.GetDimensions(w, h, mip);
+		f32 difference = 0.0f;
+		for (u32 i = 0; i < w * h; ++i)
+			difference = fmaxf(difference, fabsf(a.GetPixels(mip)[i] - b.GetPixels(mip)[i]));
+		return difference;
+	}
+
+	template<class Noise>
+	static f32 GetOneOctaveDifference(const typename Noise::Parameters& noise)
+	{
+		ImageData plain(kSize, kSize, 1, false);
+		Noise::GenerateSimple(noise, plain);
+		ImageData fractal(kSize, kSize, 1, false);
+		FractalNoise<Noise>::GenerateSimple({ noise, FractalNoise<Noise>::Mode::kFbm, 1, 2.0f, 0.5f }, fractal);
+		return GetMaxDifference(plain, fractal, 0);
+	}
+};
+
+// Category 1: Octaves
+TEST_SUITE(FractalNoise_Octaves)
+{
+	// 1.1: One octave of fbm is the noise itself, for value and Perlin noise
+	TEST_FIXTURE(FractalNoiseFixture, OneOctaveFbm_GenerateSimple_MatchesNoise)
+	{
+		// Mapping the noise to [-1; 1] and back rounds once.
+		Check(GetOneOctaveDifference<ValueNoise<LinearInterpolator>>({ 8, 8, 1, 0.0f, 1.0f }) < 1e-6f);
+		Check(GetOneOctaveDifference<PerlinNoise<FifthOrderInterpolator>>({ 8, 8, 1 }) < 1e-6f);
+	}
+
+	// 1.2: Mip levels skip the octaves above their Nyquist limit but keep the first one
+	TEST_FIXTURE(FractalNoiseFixture, SmallMips_GenerateSimple_SkipOctaves)
+	{
+		typedef FractalNoise<ValueNoise<LinearInterpolator>> Fractal;
+
+		// Octaves of 8, 16 and 32 cells: mip 0 sums all three, mip 1 the first two and mip 2 only the first.
+		Fractal::Parameters parameters = { { 8, 8, 1, 0.0f, 1.0f }, Fractal::Mode::kFbm, 3, 2.0f, 0.5f };
+		ImageData octaves(kSize, kSize, 1, true);
+		Fractal::GenerateSimple(parameters, octaves);
+		parameters.octaveCount = 1;
+		ImageData firstOctave(kSize, kSize, 1, true);
+		Fractal::GenerateSimple(parameters, firstOctave);
+
+		// Skipped octaves still count in the normalization, so the first octave is scaled by its share of 1.75.
+		for (u32 mip = 0; mip < octaves.GetMipLevelCount(); ++mip)
+		{
+			u32 w;
+			u32 h;
+			octaves.GetDimensions(w, h, mip);
+			f32 difference = 0.0f;
+			for (u32 i = 0; i < w * h; ++i)
+			{
+				const f32 expected = (firstOctave.GetPixels(mip)[i] - 0.5f) / 1.75f + 0.5f;
+				difference = fmaxf(difference, fabsf(octaves.GetPixels(mip)[i] - expected));
+			}
+			if (mip < 2)
+				Check(difference > 0.01f);
+			else
+				Check(difference < 1e-5f);
+		}
+
+		// Even the 1 x 1 level, far below the limit of the first octave, holds its value at the origin.
+		const f32 origin = 0.0f;
+		f32 value;
+		ValueNoise<LinearInterpolator>::Evaluate(parameters.noise, &origin, &origin, &value, 1);
+		Check(fabsf(firstOctave.GetPixels(firstOctave.GetMipLevelCount() - 1)[0] - value) < 1e-6f);
+	}
+}
@@ -2,48 +2,340 @@
 
 #include "IndexProviders.hpp"
 
+#include "generators/NoiseCommon.hpp"
 #include "image/ImageData.hpp"
+#include "utility/FastMath.hpp"
+#include "utility/Profiler.hpp"
 #include "utility/Random.hpp"
+#include "utility/Simd.hpp"
+#include "utility/ThreadPool.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+// Impulses that add less than this to a pixel are skipped.
+// It is 1/16 of an 8 bit channel step, small enough for the skipped impulses to stay invisible.
+static constexpr f32 kCullingThreshold = 1.0f / 4096.0f;
 
 struct GaborKernel
 {
-    f32 operator ()(f32 width, f32 x, f32 y, f32 f0, f32 w0)
+    f32 operator ()(f32 width, f32 x, f32 y, f32 f0, f32 directionX, f32 directionY)
+    {
+        return expf(-width * fmaf(x, x, y * y)) * cosf(f0 * (fmaf(x, directionX, y * directionY)));
+    }
+};
+
+// Impulses of one row of cells, stored as separate arrays so that vector code can load 8 at a time.
+// Every cell is generated once and then shared by all pixels that see it.
+// The arrays are padded with zero-weight impulses, so a vector load never runs past the end.
+struct ImpulseRow
+{
+    static constexpr u32 kPadding = 8;
+
+    // Bounding box of the impulse centers of a cell. Empty cells get an inverted box.
+    struct Extents
+    {
+        f32 minX = FLT_MAX;
+        f32 maxX = -FLT_MAX;
+        f32 minY = FLT_MAX;
+        f32 maxY = -FLT_MAX;
+
+        void Add(f32 x, f32 y)
+        {
+            minX = x < minX ? x : minX;
+            maxX = x > maxX ? x : maxX;
+            minY = y < minY ? y : minY;
+            maxY = y > maxY ? y : maxY;
+        }
+    };
+
+    i32 cellY = 0;
+    bool isValid = false;
+    std::vector<u32> firstImpulses;
+    std::vector<Extents> extents;
+    std::vector<f32> x;
+    std::vector<f32> y;
+    std::vector<f32> centerX;
+    std::vector<f32> centerY;
+    std::vector<f32> weight;
+    std::vector<f32> frequency;
+    std::vector<f32> directionX;
+    std::vector<f32> directionY;
+};
+
+// Draws the impulses of a cell from its seed. The image cache and point evaluation both use it, so they see the same impulses.
+struct ImpulseGenerator
+{
+    // The values an impulse takes from the generator, before its orientation is turned into a direction.
+    struct Impulse
+    {
+        f32 x;
+        f32 y;
+        f32 weight;
+        f32 orientation;
+        f32 frequency;
+    };
+
+    ImpulseGenerator(const GaborNoise::Parameters& noiseParameters, u32 index, i32 x, i32 y)
+        : parameters(noiseParameters)
+        , generator(index)
+        , cellX(static_cast<f32>(x))
+        , cellY(static_cast<f32>(y))
+    {
+        count = generator.Poisson(static_cast<f32>(parameters.numberOfImpulsesPerCell));
+        count = count > parameters.numberOfImpulsesPerCellCap ? parameters.numberOfImpulsesPerCellCap : count;
+    }
+
+    u32 GetCount() const { return count; }
+
+    void Next(Impulse& outImpulse)
     {
-        return expf(-width * fmaf(x, x, y * y)) * cosf(f0 * (fmaf(x, cosf(w0), y * sinf(w0))));
+        outImpulse.x = generator.Uniform();
+        outImpulse.y = generator.Uniform();
+        outImpulse.weight = generator.Uniform(-1.0f, 1.0f);
+        outImpulse.orientation = generator.Uniform(parameters.frequencyOrientationMin, parameters.frequencyOrientationMax);
+        outImpulse.frequency = generator.Uniform(parameters.frequencyMagnitudeMin, parameters.frequencyMagnitudeMax);
     }
+
+    void Next(f32& outX, f32& outY, f32& outWeight, f32& outFrequency, f32& outDirectionX, f32& outDirectionY)
+    {
+        Impulse impulse;
+        Next(impulse);
+        outX = impulse.x;
+        outY = impulse.y;
+        outWeight = impulse.weight;
+        outFrequency = impulse.frequency;
+        outDirectionX = cosf(impulse.orientation);
+        outDirectionY = sinf(impulse.orientation);
+    }
+
+    f32 GetCenterX(f32 x) const { return (cellX + x) * parameters.cellSize; }
+    f32 GetCenterY(f32 y) const { return (cellY + y) * parameters.cellSize; }
+
+private:
+    const GaborNoise::Parameters& parameters;
+    Random generator;
+    f32 cellX;
+    f32 cellY;
+    u32 count;
 };
 
+// Rolling cache of the three cell rows that the pixels of a row sample.
 template<class IndexProvider>
+struct ImpulseCache
+{
+    ImpulseCache(const IndexProvider& provider, const GaborNoise::Parameters& noiseParameters, i32 lastCellX)
+        : indexProvider(provider)
+        , parameters(noiseParameters)
+        , columnCount(static_cast<u32>(lastCellX) + 3)
+    {
+    }
+
+    const ImpulseRow& Get(i32 cellY)
+    {
+        // Rows start at -1, so the slot index is never negative.
+        ImpulseRow& row = rows[static_cast<u32>(cellY + 3) % 3];
+        if (!row.isValid || row.cellY != cellY)
+            Build(row, cellY);
+        return row;
+    }
+
+private:
+    void Build(ImpulseRow& row, i32 cellY)
+    {
+        row.cellY = cellY;
+        row.isValid = true;
+        row.firstImpulses.clear();
+        row.extents.clear();
+        row.x.clear();
+        row.y.clear();
+        row.centerX.clear();
+        row.centerY.clear();
+        row.weight.clear();
+        row.frequency.clear();
+        row.directionX.clear();
+        row.directionY.clear();
+
+        for (u32 column = 0; column < columnCount; ++column)
+        {
+            i32 cellX = static_cast<i32>(column) - 1;
+            u32 index = parameters.cellOffset + indexProvider(cellX, cellY);
+            ImpulseGenerator impulses(parameters, index, cellX, cellY);
+
+            row.firstImpulses.push_back(static_cast<u32>(row.x.size()));
+            ImpulseRow::Extents extents;
+            for (u32 k = 0; k < impulses.GetCount(); ++k)
+            {
+                f32 xi;
+                f32 yi;
+                f32 w;
+                f32 f;
+                f32 directionX;
+                f32 directionY;
+                impulses.Next(xi, yi, w, f, directionX, directionY);
+
+                row.x.push_back(xi);
+                row.y.push_back(yi);
+                row.centerX.push_back(impulses.GetCenterX(xi));
+                row.centerY.push_back(impulses.GetCenterY(yi));
+                row.weight.push_back(w);
+                row.frequency.push_back(f);
+                row.directionX.push_back(directionX);
+                row.directionY.push_back(directionY);
+
+                extents.Add(row.centerX.back(), row.centerY.back());
+            }
+            row.extents.push_back(extents);
+        }
+        row.firstImpulses.push_back(static_cast<u32>(row.x.size()));
+
+        u32 paddedCount = static_cast<u32>(row.x.size()) + ImpulseRow::kPadding;
+        row.x.resize(paddedCount, 0.0f);
+        row.y.resize(paddedCount, 0.0f);
+        row.centerX.resize(paddedCount, 0.0f);
+        row.centerY.resize(paddedCount, 0.0f);
+        row.weight.resize(paddedCount, 0.0f);
+        row.frequency.resize(paddedCount, 0.0f);
+        row.directionX.resize(paddedCount, 0.0f);
+        row.directionY.resize(paddedCount, 0.0f);
+    }
+
+    const IndexProvider& indexProvider;
+    const GaborNoise::Parameters& parameters;
+    u32 columnCount;
+    ImpulseRow rows[3];
+};
+
 struct NoiseSampler
 {
-    f32 SampleCell(const IndexProvider& indexProvider, const GaborNoise::Parameters& parameters, i32 i, i32 j, f32 x, f32 y)
+    static constexpr u32 kLaneCount = 8;
+
+    // The kernel is gaussianMagnitude * 0.5 * exp(-gaussianWidth * r^2) at most, which falls below
+    // the culling threshold at the truncation radius.
+    explicit NoiseSampler(const GaborNoise::Parameters& parameters)
+    {
+        f32 peak = 0.5f * parameters.gaussianMagnitude;
+        cullingRadiusSquared = peak > kCullingThreshold ? logf(peak / kCullingThreshold) / parameters.gaussianWidth : 0.0f;
+    }
+
+    // Checks the distance from a pixel to the bounding box of the impulses of a cell.
+    bool IsCulled(const ImpulseRow::Extents& extents, f32 x, f32 y) const
+    {
+        f32 dx = extents.minX - x > x - extents.maxX ? extents.minX - x : x - extents.maxX;
+        f32 dy = extents.minY - y > y - extents.maxY ? extents.minY - y : y - extents.maxY;
+        dx = dx > 0.0f ? dx : 0.0f;
+        dy = dy > 0.0f ? dy : 0.0f;
+        return dx * dx + dy * dy > cullingRadiusSquared;
+    }
+
+    f32 SampleCell(const ImpulseRow& row, const GaborNoise::Parameters& parameters, i32 i, f32 x, f32 y)
     {
-        u32 index = parameters.cellOffset + indexProvider(i, j);
-        Random generator(index);
-        GaborKernel kernel;
-        u32 impulseCount = generator.Poisson(static_cast<f32>(parameters.numberOfImpulsesPerCell));
-        impulseCount = impulseCount > parameters.numberOfImpulsesPerCellCap ? parameters.numberOfImpulsesPerCellCap : impulseCount;
         f32 result = 0.0f;
 
         f32 kernelX = x * parameters.cellSize;
         f32 kernelY = y * parameters.cellSize;
-        for (u32 k = 0; k < impulseCount; ++k)
+        u32 column = static_cast<u32>(i + 1);
+        u32 end = row.firstImpulses[column + 1];
+        for (u32 k = row.firstImpulses[column]; k < end; ++k)
+            result = AddImpulse(result, parameters, kernelX, kernelY, row.x[k], row.y[k], row.weight[k], row.frequency[k], row.directionX[k], row.directionY[k]);
+
+        return result;
+    }
+
+    f32 AddImpulse(f32 sum, const GaborNoise::Parameters& parameters, f32 kernelX, f32 kernelY,
+        f32 x, f32 y, f32 weight, f32 frequency, f32 directionX, f32 directionY) const
+    {
+        GaborKernel kernel;
+        f32 dx = fmaf(-x, parameters.cellSize, kernelX);
+        f32 dy = fmaf(-y, parameters.cellSize, kernelY);
+        if (fmaf(dx, dx, dy * dy) > cullingRadiusSquared)
+            return sum;
+
+        f32 value = kernel(parameters.gaussianWidth, dx, dy, frequency, directionX, directionY);
+
+        return fmaf(weight, value, sum);
+    }
+
+    // Impulse k of the three cells goes to sums[k % 8], the same way SampleCellsFast sums them without vectors.
+    void AddImpulseFast(f32* sums, u32 k, const GaborNoise::Parameters& parameters, f32 x, f32 y,
+        f32 centerX, f32 centerY, f32 weight, f32 frequency, f32 directionX, f32 directionY) const
+    {
+        FastExp exp;
+        FastCos cos;
+        f32 dx = x - centerX;
+        f32 dy = y - centerY;
+        f32 distanceSquared = fmaf(dx, dx, dy * dy);
+        if (distanceSquared > cullingRadiusSquared)
+            return;
+
+        f32 gaussian = exp(-parameters.gaussianWidth * distanceSquared);
+        f32 harmonic = cos(frequency * fmaf(dx, directionX, dy * directionY));
+
+        u32 lane = k % kLaneCount;
+        sums[lane] = fmaf(weight, gaussian * harmonic, sums[lane]);
+    }
+
+    // Sums the impulses of cells ix - 1 to ix + 1 in one pass, using approximated exp and cos.
+    // Culled impulses get no weight, and groups of 8 that are all culled are skipped.
+    // Impulse k goes to accumulator k % 8 in both code paths, so they return the same value.
+    f32 SampleCellsFast(const ImpulseRow& row, const GaborNoise::Parameters& parameters, i32 ix, f32 x, f32 y)
+    {
+        u32 begin = row.firstImpulses[static_cast<u32>(ix)];
+        u32 end = row.firstImpulses[static_cast<u32>(ix) + 3];
+        f32 sums[kLaneCount];
+
+#if NOISE_SIMD_AVX2
+        FastExp exp;
+        FastCos cos;
+        const __m256 pixelX = _mm256_set1_ps(x);
+        const __m256 pixelY = _mm256_set1_ps(y);
+        const __m256 width = _mm256_set1_ps(-parameters.gaussianWidth);
+        const __m256 radiusSquared = _mm256_set1_ps(cullingRadiusSquared);
+        const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256 sum = _mm256_setzero_ps();
+        for (u32 k = begin; k < end; k += kLaneCount)
         {
-            f32 xi = generator.Uniform();
-            f32 yi = generator.Uniform();
-            f32 w = generator.Uniform(-1.0f, 1.0f);
-            f32 o = generator.Uniform(parameters.frequencyOrientationMin, parameters.frequencyOrientationMax);
-            f32 f = generator.Uniform(parameters.frequencyMagnitudeMin, parameters.frequencyMagnitudeMax);
+            __m256 dx = _mm256_sub_ps(pixelX, _mm256_loadu_ps(&row.centerX[k]));
+            __m256 dy = _mm256_sub_ps(pixelY, _mm256_loadu_ps(&row.centerY[k]));
+            __m256 distanceSquared = _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy));
 
-            f32 value = kernel(parameters.gaussianWidth, fmaf(-xi, parameters.cellSize, kernelX), fmaf(-yi, parameters.cellSize, kernelY), f, o);
+            // Lanes past the last impulse belong to the next cell or to the padding.
+            __m256i isInRange = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<i32>(end - k)), lanes);
+            __m256 isActive = _mm256_and_ps(_mm256_castsi256_ps(isInRange), _mm256_cmp_ps(distanceSquared, radiusSquared, _CMP_LE_OQ));
+            if (_mm256_movemask_ps(isActive) == 0)
+                continue;
 
-            result = fmaf(w, value, result);
+            __m256 gaussian = exp(_mm256_mul_ps(width, distanceSquared));
+            __m256 phase = _mm256_fmadd_ps(dx, _mm256_loadu_ps(&row.directionX[k]), _mm256_mul_ps(dy, _mm256_loadu_ps(&row.directionY[k])));
+            __m256 harmonic = cos(_mm256_mul_ps(_mm256_loadu_ps(&row.frequency[k]), phase));
+            __m256 weight = _mm256_and_ps(_mm256_loadu_ps(&row.weight[k]), isActive);
+            sum = _mm256_fmadd_ps(weight, _mm256_mul_ps(gaussian, harmonic), sum);
+        }
+        _mm256_storeu_ps(sums, sum);
+#else
+        for (u32 lane = 0; lane < kLaneCount; ++lane)
+            sums[lane] = 0.0f;
+        for (u32 k = begin; k < end; ++k)
+        {
+            AddImpulseFast(sums, k - begin, parameters, x, y, row.centerX[k], row.centerY[k],
+                row.weight[k], row.frequency[k], row.directionX[k], row.directionY[k]);
         }
+#endif
 
+        return SumLanes(sums);
+    }
+
+    static f32 SumLanes(const f32* sums)
+    {
+        f32 result = 0.0f;
+        for (u32 lane = 0; lane < kLaneCount; ++lane)
+            result += sums[lane];
         return result;
     }
 
-    f32 operator ()(const IndexProvider& indexProvider, const GaborNoise::Parameters& parameters, f32 x, f32 y)
+    template<class IndexProvider>
+    f32 operator ()(ImpulseCache<IndexProvider>& cache, const GaborNoise::Parameters& parameters, f32 x, f32 y)
     {
         f32 scaledX = x / parameters.cellSize;
         f32 scaledY = y / parameters.cellSize;
@@ -56,21 +348,115 @@ struct NoiseSampler
 
         for (i32 j = -1; j < 2; ++j)
         {
+            const ImpulseRow& row = cache.Get(iy + j);
+            if (parameters.precision == GaborNoise::Precision::kFast)
+            {
+                result += SampleCellsFast(row, parameters, ix, x, y);
+                continue;
+            }
+
             for (i32 i = -1; i < 2; ++i)
-                result += SampleCell(indexProvider, parameters, ix + i, iy + j, fx - static_cast<f32>(i), fy - static_cast<f32>(j));
+            {
+                if (IsCulled(row.extents[static_cast<u32>(ix + i + 1)], x, y))
+                    continue;
+
+                result += SampleCell(row, parameters, ix + i, fx - static_cast<f32>(i), fy - static_cast<f32>(j));
+            }
         }
 
+        return Normalize(result, parameters);
+    }
+
+    // Generates the impulses of every cell on the spot, in the order ImpulseCache stores them, so no cache is needed.
+    // The exact path culls a cell by the extents of its impulses, the same way the cached extents do.
+    template<class IndexProvider>
+    f32 operator ()(const IndexProvider& indexProvider, const GaborNoise::Parameters& parameters, f32 x, f32 y)
+    {
+        f32 scaledX = x / parameters.cellSize;
+        f32 scaledY = y / parameters.cellSize;
+        f32 fx = scaledX - floorf(scaledX);
+        f32 fy = scaledY - floorf(scaledY);
+        i32 ix = static_cast<i32>(floorf(scaledX));
+        i32 iy = static_cast<i32>(floorf(scaledY));
+
+        f32 result = 0.0f;
+
+        for (i32 j = -1; j < 2; ++j)
+        {
+            i32 cellY = iy + j;
+            f32 sums[kLaneCount] = {};
+            u32 k = 0;
+            for (i32 i = -1; i < 2; ++i)
+            {
+                i32 cellX = ix + i;
+                u32 index = parameters.cellOffset + indexProvider(cellX, cellY);
+                if (parameters.precision == GaborNoise::Precision::kFast)
+                {
+                    ImpulseGenerator impulses(parameters, index, cellX, cellY);
+                    for (u32 impulse = 0; impulse < impulses.GetCount(); ++impulse, ++k)
+                    {
+                        f32 xi;
+                        f32 yi;
+                        f32 w;
+                        f32 f;
+                        f32 directionX;
+                        f32 directionY;
+                        impulses.Next(xi, yi, w, f, directionX, directionY);
+                        AddImpulseFast(sums, k, parameters, x, y, impulses.GetCenterX(xi), impulses.GetCenterY(yi), w, f, directionX, directionY);
+                    }
+                    continue;
+                }
+
+                // The impulses are kept from the culling pass, and only the ones of cells that are not culled get their
+                // direction.
+                ImpulseGenerator impulses(parameters, index, cellX, cellY);
+                cellImpulses.resize(impulses.GetCount());
+                ImpulseRow::Extents extents;
+                for (ImpulseGenerator::Impulse& impulse : cellImpulses)
+                {
+                    impulses.Next(impulse);
+                    extents.Add(impulses.GetCenterX(impulse.x), impulses.GetCenterY(impulse.y));
+                }
+                if (IsCulled(extents, x, y))
+                    continue;
+
+                f32 kernelX = (fx - static_cast<f32>(i)) * parameters.cellSize;
+                f32 kernelY = (fy - static_cast<f32>(j)) * parameters.cellSize;
+                f32 cellResult = 0.0f;
+                for (const ImpulseGenerator::Impulse& impulse : cellImpulses)
+                {
+                    cellResult = AddImpulse(cellResult, parameters, kernelX, kernelY, impulse.x, impulse.y, impulse.weight,
+                        impulse.frequency, cosf(impulse.orientation), sinf(impulse.orientation));
+                }
+                result += cellResult;
+            }
+
+            if (parameters.precision == GaborNoise::Precision::kFast)
+                result += SumLanes(sums);
+        }
+
+        return Normalize(result, parameters);
+    }
+
+    static f32 Normalize(f32 result, const GaborNoise::Parameters& parameters)
+    {
         f32 value = fmaf(parameters.gaussianMagnitude * result, 0.5f, 0.5f);
         value = value > 1.0f ? 1.0f : value;
         value = value < 0.0f ? 0.0f : value;
         return value;
     }
+
+    f32 cullingRadiusSquared;
+    // Impulses of the cell that point evaluation samples, reused from cell to cell so that it does not allocate.
+    std::vector<ImpulseGenerator::Impulse> cellImpulses;
 };
 
 template<class IndexProvider>
 void GaborNoise::Generate(const Parameters& parameters, const IndexProvider& indexProvider, ImageData& data)
 {
-    NoiseSampler<IndexProvider> sampler;
+    PROFILE_SCOPE_BYTES("pixels", data.GetByteCount());
+
+    NoiseSampler sampler(parameters);
     u32 mips = data.GetMipLevelCount();
     u32 width = data.GetWidth();
     u32 height = data.GetHeight();
@@ -85,16 +471,28 @@ void GaborNoise::Generate(const Parameters& parameters, const IndexProvider& ind
 
         f32* pixels = data.GetPixels(mip);
 
-        u32 index = 0;
-        for (u32 y = 0; y < h; ++y)
+        // Pixel positions grow with x, so the last column finds the rightmost cell.
+        i32 lastCellX = static_cast<i32>(static_cast<f32>(w - 1) * xScale / parameters.cellSize);
+
+        u32 firstRow;
+        u32 rowCount;
+        data.GetRows(mip, firstRow, rowCount);
+        ThreadPool::Instance().ParallelFor(rowCount, [&](u32 begin, u32 end)
         {
-            f32 fy = static_cast<f32>(y) * yScale;
-            for (u32 x = 0; x < w; ++x)
+            u32 yBegin = firstRow + begin;
+            u32 yEnd = firstRow + end;
+            ImpulseCache<IndexProvider> cache(indexProvider, parameters, lastCellX);
+            u64 index = static_cast<u64>(begin) * w;
+            for (u32 y = yBegin; y < yEnd; ++y)
             {
-                pixels[index] = sampler(indexProvider, parameters, static_cast<f32>(x) * xScale, fy);
-                ++index;
+                f32 fy = static_cast<f32>(y) * yScale;
+                for (u32 x = 0; x < w; ++x)
+                {
+                    pixels[index] = sampler(cache, parameters, static_cast<f32>(x) * xScale, fy);
+                    ++index;
+                }
             }
-        }
+        });
     }
 }
 
@@ -111,3 +509,17 @@ void GaborNoise::GenerateWang(const Parameters& parameters, ImageData& data)
     WangTilingIndexProvider indexProvider(width / static_cast<u32>(parameters.cellSize));
     Generate(parameters, indexProvider, data);
 }
+
+void GaborNoise::Evaluate(const Parameters& parameters, const f32* xs, const f32* ys, f32* out, size_t n)
+{
+    SimpleTilingIndexProvider indexProvider(parameters.cellsPerRow);
+    NoiseSampler sampler(parameters);
+    const f32 period = static_cast<f32>(parameters.cellsPerRow) * parameters.cellSize;
+    for (size_t k = 0; k < n; ++k)
+    {
+        f32 x = wrapCoordinate(xs[k], period);
+        f32 y = wrapCoordinate(ys[k], period);
+        // Culling would drop every impulse around a NaN point and return 0.
+        out[k] = std::isnan(x) || std::isnan(y) ? NAN : sampler(indexProvider, parameters, x, y);
+    }
+}
@@ -2,6 +2,7 @@
 
 #include "utility/Types.hpp"
 
+#include <cstddef>
 #include <vector>
 
 class ImageData;
@@ -9,22 +10,35 @@ class ImageData;
 class GaborNoise
 {
 public:
+    enum class Precision
+    {
+        kExact,
+        kFast,
+    };
+
     struct Parameters
     {
         f32 cellSize;
         u32 numberOfImpulsesPerCell;
         u32 numberOfImpulsesPerCellCap;
         u32 cellOffset;
+        // Cells per row of the pattern sampled by Evaluate, a power of 2. Images repeat after their width instead.
+        u32 cellsPerRow;
         f32 gaussianMagnitude;
         f32 gaussianWidth;
         f32 frequencyMagnitudeMin;
         f32 frequencyMagnitudeMax;
         f32 frequencyOrientationMin;
         f32 frequencyOrientationMax;
+        Precision precision;
     };
     
     static void GenerateSimple(const Parameters& parameters, ImageData& data);
     static void GenerateWang(const Parameters& parameters, ImageData& data);
+    // Samples the noise of GenerateSimple at n points given in pixels of the top mip level, so that it repeats every
+    // cellsPerRow cells. Points are wrapped into the first period, so any finite coordinate is valid. A NaN coordinate
+    // gives NaN.
+    static void Evaluate(const Parameters& parameters, const f32* xs, const f32* ys, f32* out, size_t n);
 
 private:
     template<class IndexProvider>
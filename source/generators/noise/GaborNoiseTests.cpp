@@ -0,0 +1,80 @@
+#include "GaborNoise.hpp"
+
+#include "image/ImageData.hpp"
+
+#include "testing/NoiseFixture.hpp"
+#include "testing/TestFixture.hpp"
+#include "testing/TestRunner.hpp"
+#include "testing/TestSuite.hpp"
+
+#include <cmath>
+#include <vector>
+
+// Category 1: Evaluate
+// 1.1: Points at the pixels of the top mip level evaluate to the pixels of GenerateSimple, at both precisions
+// 1.2: Points a period apart evaluate to the same value
+// 1.3: Far points evaluate to values of the pattern, NaN points to NaN
+
+struct GaborNoiseFixture
+	: public NoiseFixture
+{
+	static constexpr u32 kSize = 64;
+
+	// kSize / cellSize cells per row, so images repeat like Evaluate.
+	GaborNoise::Parameters parameters = { 16.0f, 16, 64, 1, 4, 0.1f, 3.14159265f / 256.0f, 0.05f * 3.14159265f,
+		0.05f * 3.14159265f, 0.0f, 6.2831853f, GaborNoise::Precision::kExact };
+	std::vector<f32> xs;
+	std::vector<f32> ys;
+
+	std::vector<f32> Evaluate() const
+	{
+		std::vector<f32> values(xs.size());
+		GaborNoise::Evaluate(parameters, xs.data(), ys.data(), values.data(), xs.size());
+		return values;
+	}
+};
+
+// Category 1: Evaluate
+TEST_SUITE(GaborNoise_Evaluate)
+{
+	// 1.1: Points at the pixels of the top mip level evaluate to the pixels of GenerateSimple, at both precisions
+	TEST_FIXTURE(GaborNoiseFixture, PixelPoints_Evaluate_MatchesGenerateSimple)
+	{
+		AddPixels(kSize, kSize, 1.0f, 1.0f, xs, ys);
+		for (GaborNoise::Precision precision : { GaborNoise::Precision::kExact, GaborNoise::Precision::kFast })
+		{
+			parameters.precision = precision;
+			ImageData image(kSize, kSize, 1, false);
+			GaborNoise::GenerateSimple(parameters, image);
+
+			CheckEqual(CountMismatches(Evaluate(), image.GetPixels(0)), 0u);
+		}
+	}
+
+	// 1.2: Points a period apart evaluate to the same value
+	TEST_FIXTURE(GaborNoiseFixture, ShiftedByPeriod_Evaluate_SameValues)
+	{
+		AddPixels(kSize, kSize, 1.0f, 1.0f, xs, ys);
+		const std::vector<f32> expected = Evaluate();
+		ShiftByPeriods(static_cast<f32>(kSize), static_cast<f32>(kSize), xs, ys);
+
+		CheckEqual(CountMismatches(Evaluate(), expected.data()), 0u);
+	}
+
+	// 1.3: Far points evaluate to values of the pattern, NaN points to NaN
+	TEST_FIXTURE(GaborNoiseFixture, FarAndNaNPoints_Evaluate_WrappedOrNaN)
+	{
+		xs = { 1e30f, -1e30f, NAN, 20.0f };
+		ys = { 20.0f, 20.0f, 20.0f, NAN };
+		const std::vector<f32> values = Evaluate();
+
+		// 1e30 is a multiple of the period, so the far points land on their counterpart at 0.
+		xs = { 0.0f };
+		ys = { 20.0f };
+		const std::vector<f32> expected = Evaluate();
+		CheckEqual(values[0], expected[0]);
+		CheckEqual(values[1], expected[0]);
+		Check(std::isnan(values[2]));
+		Check(std::isnan(values[3]));
+	}
+}
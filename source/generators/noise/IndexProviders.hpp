@@ -20,6 +20,27 @@ private:
     u32 mask;
 };
 
+// Cells of a volume that repeats every cellsPerRow cells along x and y and every cellLayers cells along z.
+struct VolumeTilingIndexProvider
+{
+    VolumeTilingIndexProvider(u32 cellsPerRow, u32 cellLayers) :
+        multiplier(cellsPerRow),
+        mask(multiplier - 1),
+        layerMask(cellLayers - 1)
+    {
+    }
+
+    inline u32 operator ()(i32 i, i32 j, i32 k) const
+    {
+        return (static_cast<u32>(i) & mask) + ((static_cast<u32>(j) & mask) + (static_cast<u32>(k) & layerMask) * multiplier) * multiplier;
+    }
+
+private:
+    u32 multiplier;
+    u32 mask;
+    u32 layerMask;
+};
+
 struct WangTilingIndexProvider
 {
     WangTilingIndexProvider(u32 cellsPerRow) :
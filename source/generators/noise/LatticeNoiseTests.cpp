@@ -0,0 +1,159 @@
+#include "BetterGradientNoise.hpp"
+#include "PerlinNoise.hpp"
+#include "ValueNoise.hpp"
+
+#include "generators/Interpolator.hpp"
+#include "image/ImageData.hpp"
+
+#include "testing/NoiseFixture.hpp"
+#include "testing/TestFixture.hpp"
+#include "testing/TestRunner.hpp"
+#include "testing/TestSuite.hpp"
+
+#include <cmath>
+#include <vector>
+
+// Category 1: Evaluate, for value, Perlin and better gradient noise
+// 1.1: Points at the pixels of the top mip level evaluate to the pixels of GenerateSimple
+// 1.2: Points a period apart evaluate to the same value
+// 1.3: Far points evaluate to values of the pattern, NaN points to NaN
+// Category 2: GenerateSlice, for value, Perlin and better gradient noise
+// 2.1: The last slice of a volume continues into slice 0 as smoothly as slices continue into the next one
+// 2.2: A slice continues from its last column into its first and from its last row into its first
+
+struct LatticeNoiseFixture
+	: public NoiseFixture
+{
+	typedef ValueNoise<LinearInterpolator> Value;
+	typedef PerlinNoise<FifthOrderInterpolator> Perlin;
+	typedef BetterGradientNoise<FifthOrderInterpolator> BetterGradient;
+
+	static constexpr u32 kWidth = 64;
+	static constexpr u32 kHeight = 32;
+	static constexpr u32 kDepth = 48;
+	// Lattice cells across the kDepth slices of a volume, a divisor of kDepth.
+	static constexpr u32 kLatticeDepth = 6;
+
+	Value::Parameters valueParameters = { 8, 4, kLatticeDepth, 0.0f, 1.0f };
+	Perlin::Parameters perlinParameters = { 8, 4, kLatticeDepth };
+	BetterGradient::Parameters betterGradientParameters = { 8, 4, kLatticeDepth };
+
+	template<class Noise>
+	static std::vector<f32> Evaluate(const typename Noise::Parameters& parameters, const std::vector<f32>& xs, const std::vector<f32>& ys)
+	{
+		std::vector<f32> values(xs.size());
+		Noise::Evaluate(parameters, xs.data(), ys.data(), values.data(), xs.size());
+		return values;
+	}
+
+	// Lattice coordinates of every pixel of a kWidth x kHeight image.
+	template<class Noise>
+	static void AddLatticePixels(const typename Noise::Parameters& parameters, std::vector<f32>& xs, std::vector<f32>& ys)
+	{
+		AddPixels(kWidth, kHeight, static_cast<f32>(parameters.latticeWidth) / static_cast<f32>(kWidth),
+			static_cast<f32>(parameters.latticeHeight) / static_cast<f32>(kHeight), xs, ys);
+	}
+
+	template<class Noise>
+	static std::vector<f32> GenerateSlice(const typename Noise::Parameters& parameters, u32 z)
+	{
+		ImageData image(kWidth, kHeight, 1, false);
+		Noise::GenerateSlice(parameters, kDepth, z, image);
+		return std::vector<f32>(image.GetPixels(0), image.GetPixels(0) + kWidth * kHeight);
+	}
+
+	template<class Noise>
+	static u32 CountGenerateSimpleMismatches(const typename Noise::Parameters& parameters)
+	{
+		ImageData image(kWidth, kHeight, 1, false);
+		Noise::GenerateSimple(parameters, image);
+		std::vector<f32> xs;
+		std::vector<f32> ys;
+		AddLatticePixels<Noise>(parameters, xs, ys);
+		return CountMismatches(Evaluate<Noise>(parameters, xs, ys), image.GetPixels(0));
+	}
+
+	template<class Noise>
+	static u32 CountShiftedMismatches(const typename Noise::Parameters& parameters)
+	{
+		std::vector<f32> xs;
+		std::vector<f32> ys;
+		AddLatticePixels<Noise>(parameters, xs, ys);
+		const std::vector<f32> expected = Evaluate<Noise>(parameters, xs, ys);
+		ShiftByPeriods(static_cast<f32>(parameters.latticeWidth), static_cast<f32>(parameters.latticeHeight), xs, ys);
+		return CountMismatches(Evaluate<Noise>(parameters, xs, ys), expected.data());
+	}
+
+	template<class Noise>
+	static bool IsWrappedOrNaN(const typename Noise::Parameters& parameters)
+	{
+		const std::vector<f32> values = Evaluate<Noise>(parameters, { 1e30f, -1e30f, 0.5f, NAN, 0.5f }, { 0.75f, 0.75f, 1e30f, 0.5f, NAN });
+		// 1e30 is a multiple of both periods, so the far points land on their counterparts near 0.
+		const std::vector<f32> expected = Evaluate<Noise>(parameters, { 0.0f, 0.0f, 0.5f }, { 0.75f, 0.75f, 0.0f });
+		return values[0] == expected[0] && values[1] == expected[1] && values[2] == expected[2] &&
+			std::isnan(values[3]) && std::isnan(values[4]);
+	}
+
+	template<class Noise>
+	static bool WrapsInZ(const typename Noise::Parameters& parameters)
+	{
+		return IsSeamless(GetSliceSteps(kDepth, [&](u32 z) { return GenerateSlice<Noise>(parameters, z); }));
+	}
+
+	template<class Noise>
+	static bool TilesInXAndY(const typename Noise::Parameters& parameters)
+	{
+		std::vector<f64> columnSteps;
+		std::vector<f64> rowSteps;
+		GetColumnAndRowSteps(GenerateSlice<Noise>(parameters, kDepth / 2 + 3), kWidth, kHeight, 1, 1, columnSteps, rowSteps);
+		return IsSeamless(columnSteps) && IsSeamless(rowSteps);
+	}
+};
+
+// Category 1: Evaluate, for value, Perlin and better gradient noise
+TEST_SUITE(LatticeNoise_Evaluate)
+{
+	// 1.1: Points at the pixels of the top mip level evaluate to the pixels of GenerateSimple
+	TEST_FIXTURE(LatticeNoiseFixture, PixelPoints_Evaluate_MatchesGenerateSimple)
+	{
+		CheckEqual(CountGenerateSimpleMismatches<Value>(valueParameters), 0u);
+		CheckEqual(CountGenerateSimpleMismatches<Perlin>(perlinParameters), 0u);
+		CheckEqual(CountGenerateSimpleMismatches<BetterGradient>(betterGradientParameters), 0u);
+	}
+
+	// 1.2: Points a period apart evaluate to the same value
+	TEST_FIXTURE(LatticeNoiseFixture, ShiftedByPeriod_Evaluate_SameValues)
+	{
+		CheckEqual(CountShiftedMismatches<Value>(valueParameters), 0u);
+		CheckEqual(CountShiftedMismatches<Perlin>(perlinParameters), 0u);
+		CheckEqual(CountShiftedMismatches<BetterGradient>(betterGradientParameters), 0u);
+	}
+
+	// 1.3: Far points evaluate to values of the pattern, NaN points to NaN
+	TEST_FIXTURE(LatticeNoiseFixture, FarAndNaNPoints_Evaluate_WrappedOrNaN)
+	{
+		Check(IsWrappedOrNaN<Value>(valueParameters));
+		Check(IsWrappedOrNaN<Perlin>(perlinParameters));
+		Check(IsWrappedOrNaN<BetterGradient>(betterGradientParameters));
+	}
+}
+
+// Category 2: GenerateSlice, for value, Perlin and better gradient noise
+TEST_SUITE(LatticeNoise_GenerateSlice)
+{
+	// 2.1: The last slice of a volume continues into slice 0 as smoothly as slices continue into the next one
+	TEST_FIXTURE(LatticeNoiseFixture, LastSlice_GenerateSlice_ContinuesIntoFirst)
+	{
+		Check(WrapsInZ<Value>(valueParameters));
+		Check(WrapsInZ<Perlin>(perlinParameters));
+		Check(WrapsInZ<BetterGradient>(betterGradientParameters));
+	}
+
+	// 2.2: A slice continues from its last column into its first and from its last row into its first
+	TEST_FIXTURE(LatticeNoiseFixture, Slice_GenerateSlice_TilesInXAndY)
+	{
+		Check(TilesInXAndY<Value>(valueParameters));
+		Check(TilesInXAndY<Perlin>(perlinParameters));
+		Check(TilesInXAndY<BetterGradient>(betterGradientParameters));
+	}
+}
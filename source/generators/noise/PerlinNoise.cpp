@@ -3,22 +3,46 @@
 #include "generators/Interpolator.hpp"
 #include "generators/NoiseCommon.hpp"
 #include "image/ImageData.hpp"
+#include "utility/Profiler.hpp"
 #include "utility/Random.hpp"
+#include "utility/Simd.hpp"
+#include "utility/ThreadPool.hpp"
 
 #include <cassert>
+#include <cmath>
+#include <mutex>
 
 static std::vector<f32> sGradientsX;
 static std::vector<f32> sGradientsY;
+// Volumes only. Together with x and y these are the 12 edge directions of a cube, padded to 16.
+static std::vector<f32> sGradientsZ;
 static std::vector<u32> sPermutations;
+static std::once_flag sTablesBuilt;
 
-template<class Interpolator>
-void PerlinNoise<Interpolator>::EnsureInitialized()
+// Points are evaluated in blocks: the corner gradients of a block are looked up first, then combined 8 points at a time.
+static constexpr u32 kPointBlockSize = 64;
+
+// Lattices wider than the permutation table repeat its gradients every 256 cells.
+static constexpr u32 kPermutationMask = 0xFF;
+
+static u32 gradientIndex(u32 x, u32 y)
+{
+    return sPermutations[sPermutations[sPermutations[x & kPermutationMask] + (y & kPermutationMask)]] & 0xF;
+}
+
+// Plane 0 of the volume lattice holds the gradients of the image lattice.
+static u32 gradientIndex(u32 x, u32 y, u32 z)
 {
-    if (!sPermutations.empty())
-        return;
+    return sPermutations[sPermutations[sPermutations[x & kPermutationMask] + (y & kPermutationMask)] +
+        (z & kPermutationMask)] & 0xF;
+}
 
+// Batch jobs generate on several threads at once, whichever needs the tables first builds them.
+static void buildTables()
+{
     sGradientsX.reserve(16);
     sGradientsY.reserve(16);
+    sGradientsZ.assign({ 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 0.0f, 1.0f, 0.0f, -1.0f });
 
     sGradientsX.push_back( 1.0f); sGradientsY.push_back( 1.0f);
     sGradientsX.push_back(-1.0f); sGradientsY.push_back( 1.0f);
@@ -40,7 +64,7 @@ void PerlinNoise<Interpolator>::EnsureInitialized()
     sGradientsX.push_back(-1.0f); sGradientsY.push_back( 1.0f);
     sGradientsX.push_back( 0.0f); sGradientsY.push_back(-1.0f);
     
-    const u32 kCount = 256;
+    const u32 kCount = kPermutationMask + 1;
     sPermutations.resize(kCount * 2);
     std::vector<u32> original(kCount);
     for (u32 i = 0; i < kCount; ++i)
@@ -59,13 +83,200 @@ void PerlinNoise<Interpolator>::EnsureInitialized()
     }
 }
 
+template<class Interpolator>
+void PerlinNoise<Interpolator>::EnsureInitialized()
+{
+    std::call_once(sTablesBuilt, buildTables);
+}
+
+// Gradients of the four lattice corners expanded to every pixel of a row.
+// Refreshed only when the row moves to another pair of lattice rows.
+struct CornerRows
+{
+    enum Corner
+    {
+        kTopLeftX,
+        kTopLeftY,
+        kTopRightX,
+        kTopRightY,
+        kBottomLeftX,
+        kBottomLeftY,
+        kBottomRightX,
+        kBottomRightY,
+        kCornerCount
+    };
+
+    void Resize(u32 width)
+    {
+        stride = width;
+        values.resize(static_cast<size_t>(width) * kCornerCount);
+        topIndex = ~0u;
+        bottomIndex = ~0u;
+    }
+
+    void Update(const std::vector<f32>& topX, const std::vector<f32>& topY, const std::vector<f32>& bottomX, const std::vector<f32>& bottomY,
+        const std::vector<u32>& leftIndices, const std::vector<u32>& rightIndices, u32 top, u32 bottom)
+    {
+        if (top == topIndex && bottom == bottomIndex)
+            return;
+
+        topIndex = top;
+        bottomIndex = bottom;
+        for (u32 x = 0; x < stride; ++x)
+        {
+            u32 left = leftIndices[x];
+            u32 right = rightIndices[x];
+            Get(kTopLeftX)[x] = topX[left];
+            Get(kTopLeftY)[x] = topY[left];
+            Get(kTopRightX)[x] = topX[right];
+            Get(kTopRightY)[x] = topY[right];
+            Get(kBottomLeftX)[x] = bottomX[left];
+            Get(kBottomLeftY)[x] = bottomY[left];
+            Get(kBottomRightX)[x] = bottomX[right];
+            Get(kBottomRightY)[x] = bottomY[right];
+        }
+    }
+
+    f32* Get(Corner corner) { return &values[static_cast<size_t>(corner) * stride]; }
+    const f32* Get(Corner corner) const { return &values[static_cast<size_t>(corner) * stride]; }
+
+private:
+    std::vector<f32> values;
+    u32 stride = 0;
+    u32 topIndex = ~0u;
+    u32 bottomIndex = ~0u;
+};
+
+static void evaluateRow(const CornerRows& corners, const f32* xOffsets, const f32* xFades,
+    f32 y0, f32 yWeight, u32 begin, u32 end, f32* pixels)
+{
+    const f32* tlX = corners.Get(CornerRows::kTopLeftX);
+    const f32* tlY = corners.Get(CornerRows::kTopLeftY);
+    const f32* trX = corners.Get(CornerRows::kTopRightX);
+    const f32* trY = corners.Get(CornerRows::kTopRightY);
+    const f32* blX = corners.Get(CornerRows::kBottomLeftX);
+    const f32* blY = corners.Get(CornerRows::kBottomLeftY);
+    const f32* brX = corners.Get(CornerRows::kBottomRightX);
+    const f32* brY = corners.Get(CornerRows::kBottomRightY);
+
+    f32 y1 = y0 - 1.0f;
+    f32 invYWeight = 1.0f - yWeight;
+    u32 x = begin;
+
+#if NOISE_SIMD_AVX2
+    // Same operation order as the scalar loop below, so both paths produce identical pixels.
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 vy0 = _mm256_set1_ps(y0);
+    const __m256 vy1 = _mm256_set1_ps(y1);
+    const __m256 vYWeight = _mm256_set1_ps(yWeight);
+    const __m256 vInvYWeight = _mm256_set1_ps(invYWeight);
+    for (; x + 8 <= end; x += 8)
+    {
+        __m256 x0 = _mm256_loadu_ps(xOffsets + x);
+        __m256 x1 = _mm256_sub_ps(x0, one);
+        __m256 xWeight = _mm256_loadu_ps(xFades + x);
+        __m256 invXWeight = _mm256_sub_ps(one, xWeight);
+
+        __m256 g0 = _mm256_fmadd_ps(_mm256_loadu_ps(tlX + x), x0, _mm256_mul_ps(_mm256_loadu_ps(tlY + x), vy0));
+        __m256 g1 = _mm256_fmadd_ps(_mm256_loadu_ps(trX + x), x1, _mm256_mul_ps(_mm256_loadu_ps(trY + x), vy0));
+        __m256 g2 = _mm256_fmadd_ps(_mm256_loadu_ps(blX + x), x0, _mm256_mul_ps(_mm256_loadu_ps(blY + x), vy1));
+        __m256 g3 = _mm256_fmadd_ps(_mm256_loadu_ps(brX + x), x1, _mm256_mul_ps(_mm256_loadu_ps(brY + x), vy1));
+
+        __m256 t = _mm256_fmadd_ps(g0, invXWeight, _mm256_mul_ps(g1, xWeight));
+        __m256 b = _mm256_fmadd_ps(g2, invXWeight, _mm256_mul_ps(g3, xWeight));
+        __m256 value = _mm256_fmadd_ps(t, vInvYWeight, _mm256_mul_ps(b, vYWeight));
+        _mm256_storeu_ps(pixels + x, _mm256_fmadd_ps(value, half, half));
+    }
+#endif
+
+    for (; x < end; ++x)
+    {
+        f32 x0 = xOffsets[x];
+        f32 x1 = x0 - 1.0f;
+
+        f32 g0 = fmaf(tlX[x], x0, tlY[x] * y0);
+        f32 g1 = fmaf(trX[x], x1, trY[x] * y0);
+        f32 g2 = fmaf(blX[x], x0, blY[x] * y1);
+        f32 g3 = fmaf(brX[x], x1, brY[x] * y1);
+
+        f32 value = bilerp(g0, g1, g2, g3, yWeight, invYWeight, xFades[x]);
+        pixels[x] = fmaf(value, 0.5f, 0.5f);
+    }
+}
+
+// Same as evaluateRow, with the vertical offsets and weights of every point.
+static void evaluatePoints(const f32 corners[][kPointBlockSize], const f32* xOffsets, const f32* yOffsets,
+    const f32* xFades, const f32* yFades, u32 count, f32* out)
+{
+    const f32* tlX = corners[CornerRows::kTopLeftX];
+    const f32* tlY = corners[CornerRows::kTopLeftY];
+    const f32* trX = corners[CornerRows::kTopRightX];
+    const f32* trY = corners[CornerRows::kTopRightY];
+    const f32* blX = corners[CornerRows::kBottomLeftX];
+    const f32* blY = corners[CornerRows::kBottomLeftY];
+    const f32* brX = corners[CornerRows::kBottomRightX];
+    const f32* brY = corners[CornerRows::kBottomRightY];
+
+    u32 k = 0;
+
+#if NOISE_SIMD_AVX2
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    for (; k + 8 <= count; k += 8)
+    {
+        __m256 x0 = _mm256_loadu_ps(xOffsets + k);
+        __m256 x1 = _mm256_sub_ps(x0, one);
+        __m256 y0 = _mm256_loadu_ps(yOffsets + k);
+        __m256 y1 = _mm256_sub_ps(y0, one);
+        __m256 xWeight = _mm256_loadu_ps(xFades + k);
+        __m256 invXWeight = _mm256_sub_ps(one, xWeight);
+        __m256 yWeight = _mm256_loadu_ps(yFades + k);
+        __m256 invYWeight = _mm256_sub_ps(one, yWeight);
+
+        __m256 g0 = _mm256_fmadd_ps(_mm256_loadu_ps(tlX + k), x0, _mm256_mul_ps(_mm256_loadu_ps(tlY + k), y0));
+        __m256 g1 = _mm256_fmadd_ps(_mm256_loadu_ps(trX + k), x1, _mm256_mul_ps(_mm256_loadu_ps(trY + k), y0));
+        __m256 g2 = _mm256_fmadd_ps(_mm256_loadu_ps(blX + k), x0, _mm256_mul_ps(_mm256_loadu_ps(blY + k), y1));
+        __m256 g3 = _mm256_fmadd_ps(_mm256_loadu_ps(brX + k), x1, _mm256_mul_ps(_mm256_loadu_ps(brY + k), y1));
+
+        __m256 t = _mm256_fmadd_ps(g0, invXWeight, _mm256_mul_ps(g1, xWeight));
+        __m256 b = _mm256_fmadd_ps(g2, invXWeight, _mm256_mul_ps(g3, xWeight));
+        __m256 value = _mm256_fmadd_ps(t, invYWeight, _mm256_mul_ps(b, yWeight));
+        _mm256_storeu_ps(out + k, _mm256_fmadd_ps(value, half, half));
+    }
+#endif
+
+    for (; k < count; ++k)
+    {
+        f32 x0 = xOffsets[k];
+        f32 x1 = x0 - 1.0f;
+        f32 y0 = yOffsets[k];
+        f32 y1 = y0 - 1.0f;
+
+        f32 g0 = fmaf(tlX[k], x0, tlY[k] * y0);
+        f32 g1 = fmaf(trX[k], x1, trY[k] * y0);
+        f32 g2 = fmaf(blX[k], x0, blY[k] * y1);
+        f32 g3 = fmaf(brX[k], x1, brY[k] * y1);
+
+        f32 value = bilerp(g0, g1, g2, g3, yFades[k], 1.0f - yFades[k], xFades[k]);
+        out[k] = fmaf(value, 0.5f, 0.5f);
+    }
+}
+
 template<class Interpolator>
 void PerlinNoise<Interpolator>::Generate(const Lattice& latticeX, const Lattice& latticeY, const Parameters& parameters, ImageData& data)
 {
-    const u32 maxLatticeY = static_cast<const u32>(latticeX.size());
-    const u32 maxLatticeX = static_cast<const u32>(latticeX[0].size());
+    PROFILE_SCOPE_BYTES("pixels", data.GetByteCount());
+
+    // Indices past the last lattice point are clamped to it.
+    const u32 maxLatticeY = static_cast<const u32>(latticeX.size()) - 1;
+    const u32 maxLatticeX = static_cast<const u32>(latticeX[0].size()) - 1;
     std::vector<f32> xWeights;
     std::vector<f32> yWeights;
+    std::vector<f32> xOffsets;
+    std::vector<f32> xFades;
+    std::vector<u32> leftIndices;
+    std::vector<u32> rightIndices;
 
     const u32 mips = data.GetMipLevelCount();
     for (u32 mip = 0; mip < mips; ++mip)
@@ -84,66 +295,66 @@ void PerlinNoise<Interpolator>::Generate(const Lattice& latticeX, const Lattice&
         generateWeights(xWeightCount, xWeights);
         generateWeights(yWeightCount, yWeights);
 
+        // Column terms do not depend on the row, so they are computed once per mip.
+        xOffsets.resize(w);
+        xFades.resize(w);
+        leftIndices.resize(w);
+        rightIndices.resize(w);
+        u32 xWeightIndex = 0;
+        u32 leftIndex = 0;
+        u32 rightIndex = latticeXStride;
+        for (u32 x = 0; x < w; ++x)
+        {
+            xOffsets[x] = xWeights[xWeightIndex];
+            xFades[x] = Interpolator()(xWeights[xWeightIndex]);
+            leftIndices[x] = leftIndex;
+            rightIndices[x] = rightIndex;
+
+            ++xWeightIndex;
+            if (xWeightIndex >= xWeightCount)
+            {
+                xWeightIndex = 0;
+                leftIndex = rightIndex;
+                rightIndex += latticeXStride;
+                rightIndex = (rightIndex > maxLatticeX) ? maxLatticeX : rightIndex;
+            }
+        }
+
         f32* pixels = data.GetPixels(mip);
-        u32 index = 0;
-        u32 topIndex = 0;
-        u32 bottomIndex = latticeYStride;
-        u32 yWeightIndex = 0;
-        for (u32 y = 0; y < h; ++y)
+        u32 firstRow;
+        u32 rowCount;
+        data.GetRows(mip, firstRow, rowCount);
+        ThreadPool::Instance().ParallelFor(rowCount, [&](u32 begin, u32 end)
         {
-            const std::vector<f32>& topX = latticeX[topIndex];
-            const std::vector<f32>& topY = latticeY[topIndex];
-            const std::vector<f32>& bottomX = latticeX[bottomIndex];
-            const std::vector<f32>& bottomY = latticeY[bottomIndex];
-            u32 xWeightIndex = 0;
-            u32 leftIndex = 0;
-            u32 rightIndex = latticeXStride;
-            f32 y0 = yWeights[yWeightIndex];
-            f32 y1 = y0 - 1.0f;
-            f32 yWeight = Interpolator()(y0);
-            f32 invYWeight = 1.0f - yWeight;
-            for (u32 x = 0; x < w; ++x)
+            u32 yBegin = firstRow + begin;
+            u32 yEnd = firstRow + end;
+            CornerRows corners;
+            corners.Resize(w);
+
+            u64 index = static_cast<u64>(begin) * w;
+            u32 yWeightIndex;
+            u32 topIndex;
+            u32 bottomIndex;
+            locateLatticeCell(yBegin, yWeightCount, latticeYStride, maxLatticeY, yWeightIndex, topIndex, bottomIndex);
+            for (u32 y = yBegin; y < yEnd; ++y)
             {
-                f32 tlX = topX[leftIndex];
-                f32 tlY = topY[leftIndex];
-                f32 trX = topX[rightIndex];
-                f32 trY = topY[rightIndex];
-                f32 blX = bottomX[leftIndex];
-                f32 blY = bottomY[leftIndex];
-                f32 brX = bottomX[rightIndex];
-                f32 brY = bottomY[rightIndex];
-                
-                f32 x0 = xWeights[xWeightIndex];
-                f32 x1 = x0 - 1.0f;
-                f32 xWeight = Interpolator()(x0);
-
-                f32 g0 = fmaf(tlX, x0, tlY * y0);
-                f32 g1 = fmaf(trX, x1, trY * y0);
-                f32 g2 = fmaf(blX, x0, blY * y1);
-                f32 g3 = fmaf(brX, x1, brY * y1);
-
-                f32 value = bilerp(g0, g1, g2, g3, yWeight, invYWeight, xWeight);
-                pixels[index] = fmaf(value, 0.5f, 0.5f);
-
-                ++index;
-                ++xWeightIndex;
-                if (xWeightIndex >= xWeightCount)
+                corners.Update(latticeX[topIndex], latticeY[topIndex], latticeX[bottomIndex], latticeY[bottomIndex],
+                    leftIndices, rightIndices, topIndex, bottomIndex);
+
+                f32 y0 = yWeights[yWeightIndex];
+                evaluateRow(corners, &xOffsets[0], &xFades[0], y0, Interpolator()(y0), 0, w, pixels + index);
+                index += w;
+
+                ++yWeightIndex;
+                if (yWeightIndex >= yWeightCount)
                 {
-                    xWeightIndex = 0;
-                    leftIndex = rightIndex;
-                    rightIndex += latticeXStride;
-                    rightIndex = (rightIndex > maxLatticeX) ? maxLatticeX : rightIndex;
+                    yWeightIndex = 0;
+                    topIndex = bottomIndex;
+                    bottomIndex += latticeYStride;
+                    bottomIndex = (bottomIndex > maxLatticeY) ? maxLatticeY : bottomIndex;
                 }
             }
-            ++yWeightIndex;
-            if (yWeightIndex >= yWeightCount)
-            {
-                yWeightIndex = 0;
-                topIndex = bottomIndex;
-                bottomIndex += latticeYStride;
-                bottomIndex = (bottomIndex > maxLatticeY) ? maxLatticeY : bottomIndex;
-            }
-        }
+        });
     }
 }
 
@@ -161,23 +372,26 @@ void PerlinNoise<Interpolator>::GenerateSimple(const Parameters& parameters, Ima
     u32 xPoints = parameters.latticeWidth + 1;
     Lattice latticeX(yPoints);
     Lattice latticeY(yPoints);
-    for (u32 i = 0; i < yPoints; ++i)
     {
-        latticeX[i].resize(xPoints);
-        latticeY[i].resize(xPoints);
-    }
+        PROFILE_SCOPE("lattice");
+        for (u32 i = 0; i < yPoints; ++i)
+        {
+            latticeX[i].resize(xPoints);
+            latticeY[i].resize(xPoints);
+        }
 
-    for (u32 y = 0; y < yPoints; ++y)
-    {
-        std::vector<f32>& rowX = latticeX[y];
-        std::vector<f32>& rowY = latticeY[y];
-        u32 j = y % parameters.latticeHeight;
-        for (u32 x = 0; x < xPoints; ++x)
+        for (u32 y = 0; y < yPoints; ++y)
         {
-            u32 i = x % parameters.latticeWidth;
-            u32 index = sPermutations[sPermutations[sPermutations[i] + j]] & 0xF;
-            rowX[x] = sGradientsX[index];
-            rowY[x] = sGradientsY[index];
+            std::vector<f32>& rowX = latticeX[y];
+            std::vector<f32>& rowY = latticeY[y];
+            u32 j = y % parameters.latticeHeight;
+            for (u32 x = 0; x < xPoints; ++x)
+            {
+                u32 i = x % parameters.latticeWidth;
+                u32 index = gradientIndex(i, j);
+                rowX[x] = sGradientsX[index];
+                rowY[x] = sGradientsY[index];
+            }
         }
     }
 
@@ -209,111 +423,325 @@ void PerlinNoise<Interpolator>::GenerateWang(const Parameters& parameters, Image
 {
     EnsureInitialized();
 
-    std::vector<f32> xWeights;
-    std::vector<f32> yWeights;
-
     u32 tileWidth = parameters.latticeWidth >> 2;
     u32 tileHeight = parameters.latticeHeight >> 2;
 
-    u32 maxLatticeY = parameters.latticeHeight + 1;
-    u32 maxLatticeX = parameters.latticeWidth + 1;
+    // Sizes that are not a multiple of the lattice reach one point further, up to index latticeWidth + 1 and
+    // latticeHeight + 1, where Generate clamps them.
+    u32 yPoints = parameters.latticeHeight + 2;
+    u32 xPoints = parameters.latticeWidth + 2;
+    Lattice latticeX(yPoints);
+    Lattice latticeY(yPoints);
+    {
+        PROFILE_SCOPE("lattice");
+        for (u32 i = 0; i < yPoints; ++i)
+        {
+            latticeX[i].resize(xPoints);
+            latticeY[i].resize(xPoints);
+        }
 
-    TransformCoord transformer;
+        // Remap every lattice point once, so that pixels share the loop used for simple tiling.
+        TransformCoord transformer;
+        for (u32 y = 0; y < yPoints; ++y)
+        {
+            std::vector<f32>& rowX = latticeX[y];
+            std::vector<f32>& rowY = latticeY[y];
+            for (u32 x = 0; x < xPoints; ++x)
+            {
+                u32 i = x;
+                u32 j = y;
+                transformer(i, j, tileWidth, tileHeight);
+                u32 index = gradientIndex(i, j);
+                rowX[x] = sGradientsX[index];
+                rowY[x] = sGradientsY[index];
+            }
+        }
+    }
 
-    const u32 mips = data.GetMipLevelCount();
-    for (u32 mip = 0; mip < mips; ++mip)
+    Generate(latticeX, latticeY, parameters, data);
+}
+
+template<class Interpolator>
+void PerlinNoise<Interpolator>::Evaluate(const Parameters& parameters, const f32* xs, const f32* ys, f32* out, size_t n)
+{
+    EnsureInitialized();
+
+    f32 corners[CornerRows::kCornerCount][kPointBlockSize];
+    f32 xOffsets[kPointBlockSize];
+    f32 yOffsets[kPointBlockSize];
+    f32 xFades[kPointBlockSize];
+    f32 yFades[kPointBlockSize];
+    for (size_t first = 0; first < n; first += kPointBlockSize)
     {
-        u32 w;
-        u32 h;
-        data.GetDimensions(w, h, mip);
+        u32 count = n - first < kPointBlockSize ? static_cast<u32>(n - first) : kPointBlockSize;
+        for (u32 k = 0; k < count; ++k)
+        {
+            // NaN takes the corners of cell 0, its offset makes the result NaN.
+            f32 x = wrapCoordinate(xs[first + k], static_cast<f32>(parameters.latticeWidth));
+            f32 y = wrapCoordinate(ys[first + k], static_cast<f32>(parameters.latticeHeight));
+            f32 cellX = std::isnan(x) ? 0.0f : floorf(x);
+            f32 cellY = std::isnan(y) ? 0.0f : floorf(y);
+            xOffsets[k] = x - cellX;
+            yOffsets[k] = y - cellY;
+            xFades[k] = Interpolator()(xOffsets[k]);
+            yFades[k] = Interpolator()(yOffsets[k]);
+
+            u32 left = wrapLatticeCell(static_cast<i32>(cellX), parameters.latticeWidth);
+            u32 top = wrapLatticeCell(static_cast<i32>(cellY), parameters.latticeHeight);
+            u32 right = left + 1 < parameters.latticeWidth ? left + 1 : 0;
+            u32 bottom = top + 1 < parameters.latticeHeight ? top + 1 : 0;
+
+            u32 index = gradientIndex(left, top);
+            corners[CornerRows::kTopLeftX][k] = sGradientsX[index];
+            corners[CornerRows::kTopLeftY][k] = sGradientsY[index];
+            index = gradientIndex(right, top);
+            corners[CornerRows::kTopRightX][k] = sGradientsX[index];
+            corners[CornerRows::kTopRightY][k] = sGradientsY[index];
+            index = gradientIndex(left, bottom);
+            corners[CornerRows::kBottomLeftX][k] = sGradientsX[index];
+            corners[CornerRows::kBottomLeftY][k] = sGradientsY[index];
+            index = gradientIndex(right, bottom);
+            corners[CornerRows::kBottomRightX][k] = sGradientsX[index];
+            corners[CornerRows::kBottomRightY][k] = sGradientsY[index];
+        }
 
-        u32 latticeXStride = parameters.latticeWidth / w;
-        u32 latticeYStride = parameters.latticeHeight / h;
-        latticeXStride = (latticeXStride >= 1) ? latticeXStride : 1;    
-        latticeYStride = (latticeYStride >= 1) ? latticeYStride : 1;
+        evaluatePoints(corners, xOffsets, yOffsets, xFades, yFades, count, out + first);
+    }
+}
 
-        u32 xWeightCount = w / parameters.latticeWidth;
-        u32 yWeightCount = h / parameters.latticeHeight;
-        generateWeights(xWeightCount, xWeights);
-        generateWeights(yWeightCount, yWeights);
-        
-        f32* pixels = data.GetPixels(mip);
-        u32 index = 0;
-        u32 topIndex = 0;
-        u32 bottomIndex = latticeYStride;
-        u32 yWeightIndex = 0;
-        for (u32 y = 0; y < h; ++y)
+// Gradients of one plane of the volume lattice, in rows of latticeWidth points.
+struct LatticePlane
+{
+    std::vector<f32> x;
+    std::vector<f32> y;
+    std::vector<f32> z;
+};
+
+// Gradients of the eight lattice corners around a row of a volume slice, expanded to every pixel of the row. The z
+// components are stored multiplied by the distance to their plane, which is the same for the whole slice.
+struct VolumeCornerRows
+{
+    // Corners of the front plane, then of the back plane.
+    enum Corner
+    {
+        kTopLeft,
+        kTopRight,
+        kBottomLeft,
+        kBottomRight,
+        kBackTopLeft,
+        kBackTopRight,
+        kBackBottomLeft,
+        kBackBottomRight,
+        kCornerCount
+    };
+
+    enum Component
+    {
+        kX,
+        kY,
+        kZ,
+        kComponentCount
+    };
+
+    void Resize(u32 width)
+    {
+        stride = width;
+        values.resize(static_cast<size_t>(width) * kCornerCount * kComponentCount);
+    }
+
+    void Update(const LatticePlane& front, const LatticePlane& back, f32 frontOffset, f32 backOffset, u32 latticeWidth,
+        const std::vector<u32>& leftIndices, const std::vector<u32>& rightIndices, u32 top, u32 bottom)
+    {
+        const LatticePlane* planes[] = { &front, &back };
+        const f32 offsets[] = { frontOffset, backOffset };
+        const u32 rows[] = { top * latticeWidth, bottom * latticeWidth };
+        for (u32 corner = 0; corner < kCornerCount; ++corner)
         {
-            u32 xWeightIndex = 0;
-            u32 leftIndex = 0;
-            u32 rightIndex = latticeXStride;
-            f32 y0 = yWeights[yWeightIndex];
-            f32 y1 = y0 - 1.0f;
-            f32 yWeight = Interpolator()(y0);
-            f32 invYWeight = 1.0f - yWeight;
-            for (u32 x = 0; x < w; ++x)
+            const LatticePlane& plane = *planes[corner >> 2];
+            const f32 offset = offsets[corner >> 2];
+            const u32 row = rows[(corner >> 1) & 1];
+            const std::vector<u32>& columns = (corner & 1) != 0 ? rightIndices : leftIndices;
+            f32* x = Get(static_cast<Corner>(corner), kX);
+            f32* y = Get(static_cast<Corner>(corner), kY);
+            f32* z = Get(static_cast<Corner>(corner), kZ);
+            for (u32 i = 0; i < stride; ++i)
             {
-                u32 xtl = leftIndex;
-                u32 ytl = topIndex;
-                transformer(xtl, ytl, tileWidth, tileHeight);
-                u32 gradientIndex = sPermutations[sPermutations[sPermutations[xtl] + ytl]] & 0xF;
-                f32 tlX = sGradientsX[gradientIndex];
-                f32 tlY = sGradientsY[gradientIndex];
-                u32 xtr = rightIndex;
-                u32 ytr = topIndex;
-                transformer(xtr, ytr, tileWidth, tileHeight);
-                gradientIndex = sPermutations[sPermutations[sPermutations[xtr] + ytr]] & 0xF;
-                f32 trX = sGradientsX[gradientIndex];
-                f32 trY = sGradientsY[gradientIndex];
-
-                u32 xbl = leftIndex;
-                u32 ybl = bottomIndex;
-                transformer(xbl, ybl, tileWidth, tileHeight);
-                gradientIndex = sPermutations[sPermutations[sPermutations[xbl] + ybl]] & 0xF;
-                f32 blX = sGradientsX[gradientIndex];
-                f32 blY = sGradientsY[gradientIndex];
-                u32 xbr = rightIndex;
-                u32 ybr = bottomIndex;
-                transformer(xbr, ybr, tileWidth, tileHeight);
-                gradientIndex = sPermutations[sPermutations[sPermutations[xbr] + ybr]] & 0xF;
-                f32 brX = sGradientsX[gradientIndex];
-                f32 brY = sGradientsY[gradientIndex];
-                
-                f32 x0 = xWeights[xWeightIndex];
-                f32 x1 = x0 - 1.0f;
-                f32 xWeight = Interpolator()(x0);
-                f32 invXWeight = 1.0f - xWeight;
-
-                f32 g0 = fmaf(tlX, x0, tlY * y0);
-                f32 g1 = fmaf(trX, x1, trY * y0);
-                f32 g2 = fmaf(blX, x0, blY * y1);
-                f32 g3 = fmaf(brX, x1, brY * y1);
-
-                f32 t = fmaf(g0, invXWeight, g1 * xWeight);
-                f32 b = fmaf(g2, invXWeight, g3 * xWeight);
-                f32 value = fmaf(t, invYWeight, b * yWeight);
-                pixels[index] = fmaf(value, 0.5f, 0.5f);
-
-                ++index;
-                ++xWeightIndex;
-                if (xWeightIndex >= xWeightCount)
-                {
-                    xWeightIndex = 0;
-                    leftIndex = rightIndex;
-                    rightIndex += latticeXStride;
-                    rightIndex = (rightIndex > maxLatticeX) ? maxLatticeX : rightIndex;
-                }
+                u32 index = row + columns[i];
+                x[i] = plane.x[index];
+                y[i] = plane.y[index];
+                z[i] = plane.z[index] * offset;
             }
-            ++yWeightIndex;
-            if (yWeightIndex >= yWeightCount)
+        }
+    }
+
+    f32* Get(Corner corner, Component component) { return &values[(static_cast<size_t>(corner) * kComponentCount + component) * stride]; }
+    const f32* Get(Corner corner, Component component) const { return &values[(static_cast<size_t>(corner) * kComponentCount + component) * stride]; }
+
+private:
+    std::vector<f32> values;
+    u32 stride = 0;
+};
+
+// Same as evaluateRow, blending the front and back plane by zWeight.
+static void evaluateVolumeRow(const VolumeCornerRows& corners, const f32* xOffsets, const f32* xFades,
+    f32 y0, f32 yWeight, f32 zWeight, u32 width, f32* pixels)
+{
+    const f32* x[VolumeCornerRows::kCornerCount];
+    const f32* y[VolumeCornerRows::kCornerCount];
+    const f32* z[VolumeCornerRows::kCornerCount];
+    for (u32 corner = 0; corner < VolumeCornerRows::kCornerCount; ++corner)
+    {
+        x[corner] = corners.Get(static_cast<VolumeCornerRows::Corner>(corner), VolumeCornerRows::kX);
+        y[corner] = corners.Get(static_cast<VolumeCornerRows::Corner>(corner), VolumeCornerRows::kY);
+        z[corner] = corners.Get(static_cast<VolumeCornerRows::Corner>(corner), VolumeCornerRows::kZ);
+    }
+
+    f32 y1 = y0 - 1.0f;
+    f32 invYWeight = 1.0f - yWeight;
+    f32 invZWeight = 1.0f - zWeight;
+    u32 i = 0;
+
+#if NOISE_SIMD_AVX2
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 vy0 = _mm256_set1_ps(y0);
+    const __m256 vy1 = _mm256_set1_ps(y1);
+    const __m256 vYWeight = _mm256_set1_ps(yWeight);
+    const __m256 vInvYWeight = _mm256_set1_ps(invYWeight);
+    const __m256 vZWeight = _mm256_set1_ps(zWeight);
+    const __m256 vInvZWeight = _mm256_set1_ps(invZWeight);
+    for (; i + 8 <= width; i += 8)
+    {
+        __m256 x0 = _mm256_loadu_ps(xOffsets + i);
+        __m256 x1 = _mm256_sub_ps(x0, one);
+        __m256 xWeight = _mm256_loadu_ps(xFades + i);
+        __m256 invXWeight = _mm256_sub_ps(one, xWeight);
+
+        __m256 planes[2];
+        for (u32 plane = 0; plane < 2; ++plane)
+        {
+            u32 c = plane * 4;
+            __m256 g0 = _mm256_fmadd_ps(_mm256_loadu_ps(x[c] + i), x0, _mm256_fmadd_ps(_mm256_loadu_ps(y[c] + i), vy0, _mm256_loadu_ps(z[c] + i)));
+            __m256 g1 = _mm256_fmadd_ps(_mm256_loadu_ps(x[c + 1] + i), x1, _mm256_fmadd_ps(_mm256_loadu_ps(y[c + 1] + i), vy0, _mm256_loadu_ps(z[c + 1] + i)));
+            __m256 g2 = _mm256_fmadd_ps(_mm256_loadu_ps(x[c + 2] + i), x0, _mm256_fmadd_ps(_mm256_loadu_ps(y[c + 2] + i), vy1, _mm256_loadu_ps(z[c + 2] + i)));
+            __m256 g3 = _mm256_fmadd_ps(_mm256_loadu_ps(x[c + 3] + i), x1, _mm256_fmadd_ps(_mm256_loadu_ps(y[c + 3] + i), vy1, _mm256_loadu_ps(z[c + 3] + i)));
+
+            __m256 t = _mm256_fmadd_ps(g0, invXWeight, _mm256_mul_ps(g1, xWeight));
+            __m256 b = _mm256_fmadd_ps(g2, invXWeight, _mm256_mul_ps(g3, xWeight));
+            planes[plane] = _mm256_fmadd_ps(t, vInvYWeight, _mm256_mul_ps(b, vYWeight));
+        }
+        __m256 value = _mm256_fmadd_ps(planes[0], vInvZWeight, _mm256_mul_ps(planes[1], vZWeight));
+        _mm256_storeu_ps(pixels + i, _mm256_fmadd_ps(value, half, half));
+    }
+#endif
+
+    for (; i < width; ++i)
+    {
+        f32 x0 = xOffsets[i];
+        f32 x1 = x0 - 1.0f;
+
+        f32 planes[2];
+        for (u32 plane = 0; plane < 2; ++plane)
+        {
+            u32 c = plane * 4;
+            f32 g0 = fmaf(x[c][i], x0, fmaf(y[c][i], y0, z[c][i]));
+            f32 g1 = fmaf(x[c + 1][i], x1, fmaf(y[c + 1][i], y0, z[c + 1][i]));
+            f32 g2 = fmaf(x[c + 2][i], x0, fmaf(y[c + 2][i], y1, z[c + 2][i]));
+            f32 g3 = fmaf(x[c + 3][i], x1, fmaf(y[c + 3][i], y1, z[c + 3][i]));
+            planes[plane] = bilerp(g0, g1, g2, g3, yWeight, invYWeight, xFades[i]);
+        }
+        f32 value = fmaf(planes[0], invZWeight, planes[1] * zWeight);
+        pixels[i] = fmaf(value, 0.5f, 0.5f);
+    }
+}
+
+template<class Interpolator>
+void PerlinNoise<Interpolator>::GenerateSlice(const Parameters& parameters, u32 depth, u32 z, ImageData& data)
+{
+    PROFILE_SCOPE_BYTES("pixels", data.GetByteCount());
+
+    const u32 w = data.GetWidth();
+    const u32 h = data.GetHeight();
+    assert(w % parameters.latticeWidth == 0);
+    assert(h % parameters.latticeHeight == 0);
+    assert(depth % parameters.latticeDepth == 0);
+    assert(z < depth);
+    assert(data.GetMipLevelCount() == 1);
+
+    EnsureInitialized();
+
+    // The slice lies between two planes of the lattice, only their gradients are looked up.
+    std::vector<f32> zWeights;
+    u32 zWeightCount = depth / parameters.latticeDepth;
+    generateWeights(zWeightCount, zWeights);
+    u32 frontIndex = z / zWeightCount;
+    u32 backIndex = frontIndex + 1 < parameters.latticeDepth ? frontIndex + 1 : 0;
+    f32 z0 = zWeights[z - frontIndex * zWeightCount];
+
+    LatticePlane planes[2];
+    const u32 planeIndices[] = { frontIndex, backIndex };
+    for (u32 plane = 0; plane < 2; ++plane)
+    {
+        LatticePlane& lattice = planes[plane];
+        size_t count = static_cast<size_t>(parameters.latticeWidth) * parameters.latticeHeight;
+        lattice.x.resize(count);
+        lattice.y.resize(count);
+        lattice.z.resize(count);
+        size_t point = 0;
+        for (u32 j = 0; j < parameters.latticeHeight; ++j)
+        {
+            for (u32 i = 0; i < parameters.latticeWidth; ++i)
             {
-                yWeightIndex = 0;
-                topIndex = bottomIndex;
-                bottomIndex += latticeYStride;
-                bottomIndex = (bottomIndex > maxLatticeY) ? maxLatticeY : bottomIndex;
+                u32 index = gradientIndex(i, j, planeIndices[plane]);
+                lattice.x[point] = sGradientsX[index];
+                lattice.y[point] = sGradientsY[index];
+                lattice.z[point] = sGradientsZ[index];
+                ++point;
             }
         }
     }
+
+    std::vector<f32> xWeights;
+    std::vector<f32> yWeights;
+    u32 xWeightCount = w / parameters.latticeWidth;
+    u32 yWeightCount = h / parameters.latticeHeight;
+    generateWeights(xWeightCount, xWeights);
+    generateWeights(yWeightCount, yWeights);
+
+    std::vector<f32> xOffsets(w);
+    std::vector<f32> xFades(w);
+    std::vector<u32> leftIndices(w);
+    std::vector<u32> rightIndices(w);
+    for (u32 x = 0; x < w; ++x)
+    {
+        u32 cell = x / xWeightCount;
+        xOffsets[x] = xWeights[x - cell * xWeightCount];
+        xFades[x] = Interpolator()(xOffsets[x]);
+        leftIndices[x] = cell;
+        rightIndices[x] = cell + 1 < parameters.latticeWidth ? cell + 1 : 0;
+    }
+
+    const f32 zWeight = Interpolator()(z0);
+    f32* pixels = data.GetPixels(0);
+    ThreadPool::Instance().ParallelFor(h, [&](u32 begin, u32 end)
+    {
+        VolumeCornerRows corners;
+        corners.Resize(w);
+        u32 loadedTop = ~0u;
+        for (u32 y = begin; y < end; ++y)
+        {
+            u32 top = y / yWeightCount;
+            if (top != loadedTop)
+            {
+                u32 bottom = top + 1 < parameters.latticeHeight ? top + 1 : 0;
+                corners.Update(planes[0], planes[1], z0, z0 - 1.0f, parameters.latticeWidth, leftIndices, rightIndices, top, bottom);
+                loadedTop = top;
+            }
+
+            f32 y0 = yWeights[y - top * yWeightCount];
+            evaluateVolumeRow(corners, &xOffsets[0], &xFades[0], y0, Interpolator()(y0), zWeight, w, pixels + static_cast<u64>(y) * w);
+        }
+    });
 }
 
 template class PerlinNoise<FifthOrderInterpolator>;
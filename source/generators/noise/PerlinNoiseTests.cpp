@@ -0,0 +1,54 @@
+#include "PerlinNoise.hpp"
+
+#include "generators/Interpolator.hpp"
+#include "image/ImageData.hpp"
+
+#include "testing/TestFixture.hpp"
+#include "testing/TestRunner.hpp"
+#include "testing/TestSuite.hpp"
+
+// Category 1: Wang tiling
+// 1.1: An image whose size is not a multiple of the lattice keeps the pixels of earlier versions, up to its last row and column
+
+struct PerlinNoiseFixture
+{
+	typedef PerlinNoise<FifthOrderInterpolator> Noise;
+
+	virtual ~PerlinNoiseFixture() = default;
+};
+
+// Category 1: Wang tiling
+TEST_SUITE(PerlinNoise_Wang)
+{
+	// 1.1: An image whose size is not a multiple of the lattice keeps the pixels of earlier versions, up to its last row and column
+	TEST_FIXTURE(PerlinNoiseFixture, NonMultipleSize_GenerateWang_MatchesEarlierVersions)
+	{
+		static constexpr u32 kWidth = 100;
+		static constexpr u32 kHeight = 60;
+		// Pixels written by the generator before the lattice was precomputed. The last cells of a row and a column
+		// sample lattice points past latticeWidth and latticeHeight.
+		struct KnownPixel
+		{
+			u32 x;
+			u32 y;
+			f32 value;
+		};
+		const KnownPixel knownPixels[] = {
+			{ 0, 0, 0.25f },
+			{ 50, 20, 0.596707821f },
+			{ 31, 57, 0.430041164f },
+			{ 40, 59, 0.561728418f },
+			{ 98, 10, 0.317901254f },
+			{ 97, 58, 0.70164609f },
+			{ 99, 30, 0.25f },
+			{ 99, 59, 0.5f },
+		};
+
+		ImageData image(kWidth, kHeight, 1, false);
+		Noise::GenerateWang({ 32, 32, 1 }, image);
+
+		const f32* pixels = image.GetPixels(0);
+		for (const KnownPixel& known : knownPixels)
+			CheckEqual(pixels[known.y * kWidth + known.x], known.value);
+	}
+}
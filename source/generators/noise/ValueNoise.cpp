@@ -3,13 +3,19 @@
 #include "generators/Interpolator.hpp"
 #include "generators/NoiseCommon.hpp"
 #include "image/ImageData.hpp"
+#include "utility/Profiler.hpp"
 #include "utility/Random.hpp"
+#include "utility/ThreadPool.hpp"
 
 #include <cassert>
+#include <cmath>
+#include <cstring>
 
 template<class Interpolator>
 void ValueNoise<Interpolator>::Generate(const std::vector<std::vector<f32>>& lattice, const Parameters& parameters, ImageData& data)
 {
+    PROFILE_SCOPE_BYTES("pixels", data.GetByteCount());
+
     const u32 maxLatticeY = static_cast<const u32>(lattice.size());
     const u32 maxLatticeX = static_cast<const u32>(lattice[0].size());
     std::vector<f32> xWeights;
@@ -33,49 +39,58 @@ void ValueNoise<Interpolator>::Generate(const std::vector<std::vector<f32>>& lat
         generateWeights(yWeightCount, yWeights);
 
         f32* pixels = data.GetPixels(mip);
-        u32 index = 0;
-        u32 topIndex = 0;
-        u32 bottomIndex = latticeYStride;
-        u32 yWeightIndex = 0;
-        for (u32 y = 0; y < h; ++y)
+        u32 firstRow;
+        u32 rowCount;
+        data.GetRows(mip, firstRow, rowCount);
+        ThreadPool::Instance().ParallelFor(rowCount, [&](u32 begin, u32 end)
         {
-            const std::vector<f32>& top = lattice[topIndex];
-            const std::vector<f32>& bottom = lattice[bottomIndex];
-            u32 xWeightIndex = 0;
-            u32 leftIndex = 0;
-            u32 rightIndex = latticeXStride;
-            f32 yWeight = Interpolator()(yWeights[yWeightIndex]);
-            f32 invYWeight = 1.0f - yWeight;
-            for (u32 x = 0; x < w; ++x)
+            u32 yBegin = firstRow + begin;
+            u32 yEnd = firstRow + end;
+            u64 index = static_cast<u64>(begin) * w;
+            u32 yWeightIndex;
+            u32 topIndex;
+            u32 bottomIndex;
+            locateLatticeCell(yBegin, yWeightCount, latticeYStride, maxLatticeY, yWeightIndex, topIndex, bottomIndex);
+            for (u32 y = yBegin; y < yEnd; ++y)
             {
-                f32 tl = top[leftIndex];
-                f32 tr = top[rightIndex];
-                f32 bl = bottom[leftIndex];
-                f32 br = bottom[rightIndex];
+                const std::vector<f32>& top = lattice[topIndex];
+                const std::vector<f32>& bottom = lattice[bottomIndex];
+                u32 xWeightIndex = 0;
+                u32 leftIndex = 0;
+                u32 rightIndex = latticeXStride;
+                f32 yWeight = Interpolator()(yWeights[yWeightIndex]);
+                f32 invYWeight = 1.0f - yWeight;
+                for (u32 x = 0; x < w; ++x)
+                {
+                    f32 tl = top[leftIndex];
+                    f32 tr = top[rightIndex];
+                    f32 bl = bottom[leftIndex];
+                    f32 br = bottom[rightIndex];
 
-                f32 xWeight = Interpolator()(xWeights[xWeightIndex]);
+                    f32 xWeight = Interpolator()(xWeights[xWeightIndex]);
                 
-                pixels[index] = bilerp(tl, tr, bl, br, yWeight, invYWeight, xWeight);
+                    pixels[index] = bilerp(tl, tr, bl, br, yWeight, invYWeight, xWeight);
 
-                ++index;
-                ++xWeightIndex;
-                if (xWeightIndex >= xWeightCount)
+                    ++index;
+                    ++xWeightIndex;
+                    if (xWeightIndex >= xWeightCount)
+                    {
+                        xWeightIndex = 0;
+                        leftIndex = rightIndex;
+                        rightIndex += latticeXStride;
+                        rightIndex = (rightIndex > maxLatticeX) ? maxLatticeX : rightIndex;
+                    }
+                }
+                ++yWeightIndex;
+                if (yWeightIndex >= yWeightCount)
                 {
-                    xWeightIndex = 0;
-                    leftIndex = rightIndex;
-                    rightIndex += latticeXStride;
-                    rightIndex = (rightIndex > maxLatticeX) ? maxLatticeX : rightIndex;
+                    yWeightIndex = 0;
+                    topIndex = bottomIndex;
+                    bottomIndex += latticeYStride;
+                    bottomIndex = (bottomIndex > maxLatticeY) ? maxLatticeY : bottomIndex;
                 }
             }
-            ++yWeightIndex;
-            if (yWeightIndex >= yWeightCount)
-            {
-                yWeightIndex = 0;
-                topIndex = bottomIndex;
-                bottomIndex += latticeYStride;
-                bottomIndex = (bottomIndex > maxLatticeY) ? maxLatticeY : bottomIndex;
-            }
-        }
+        });
     }
 }
 
@@ -90,42 +105,45 @@ void ValueNoise<Interpolator>::GenerateSimple(const Parameters& parameters, Imag
     u32 yPoints = parameters.latticeHeight + 1;
     u32 xPoints = parameters.latticeWidth + 1;
     std::vector<std::vector<f32>> lattice(yPoints);
-    for (u32 i = 0; i < yPoints; ++i)
-        lattice[i].resize(xPoints);
-
-    Random rand(1);
+    {
+        PROFILE_SCOPE("lattice");
+        for (u32 i = 0; i < yPoints; ++i)
+            lattice[i].resize(xPoints);
 
-    f32 corner = rand.Uniform(parameters.rangeMin, parameters.rangeMax);
-    u32 yUnique = yPoints - 2;
-    u32 xUnique = xPoints - 2;
+        Random rand(1);
 
-    std::vector<f32>& top = lattice[0];
-    std::vector<f32>& bottom = lattice[parameters.latticeHeight];
-    top[0] = corner;
-    bottom[0] = corner;
-    u32 index = 1;
-    for (u32 x = 0; x < xUnique; ++x)
-    {
-        f32 value = rand.Uniform(parameters.rangeMin, parameters.rangeMax);
-        top[index] = value;
-        bottom[index] = value;
-        ++index;
-    }
-    top[index] = corner;
-    bottom[index] = corner;
+        f32 corner = rand.Uniform(parameters.rangeMin, parameters.rangeMax);
+        u32 yUnique = yPoints - 2;
+        u32 xUnique = xPoints - 2;
 
-    for (u32 y = 0; y < yUnique; ++y)
-    {
-        std::vector<f32>& row = lattice[y + 1];
-        float border = rand.Uniform(parameters.rangeMin, parameters.rangeMax);
-        row[0] = border;
-        index = 1;
+        std::vector<f32>& top = lattice[0];
+        std::vector<f32>& bottom = lattice[parameters.latticeHeight];
+        top[0] = corner;
+        bottom[0] = corner;
+        u32 index = 1;
         for (u32 x = 0; x < xUnique; ++x)
         {
-            row[index] = rand.Uniform(parameters.rangeMin, parameters.rangeMax);
+            f32 value = rand.Uniform(parameters.rangeMin, parameters.rangeMax);
+            top[index] = value;
+            bottom[index] = value;
             ++index;
         }
-        row[index] = border;
+        top[index] = corner;
+        bottom[index] = corner;
+
+        for (u32 y = 0; y < yUnique; ++y)
+        {
+            std::vector<f32>& row = lattice[y + 1];
+            float border = rand.Uniform(parameters.rangeMin, parameters.rangeMax);
+            row[0] = border;
+            index = 1;
+            for (u32 x = 0; x < xUnique; ++x)
+            {
+                row[index] = rand.Uniform(parameters.rangeMin, parameters.rangeMax);
+                ++index;
+            }
+            row[index] = border;
+        }
     }
 
     Generate(lattice, parameters, data);
@@ -144,79 +162,82 @@ void ValueNoise<Interpolator>::GenerateWang(const Parameters& parameters, ImageD
     u32 yPoints = parameters.latticeHeight + 1;
     u32 xPoints = parameters.latticeWidth + 1;
     std::vector<std::vector<f32>> lattice(yPoints);
-    for (u32 i = 0; i < yPoints; ++i)
-        lattice[i].resize(xPoints);
+    {
+        PROFILE_SCOPE("lattice");
+        for (u32 i = 0; i < yPoints; ++i)
+            lattice[i].resize(xPoints);
 
-    Random rand(1);
+        Random rand(1);
 
-    f32 corner = rand.Uniform(parameters.rangeMin, parameters.rangeMax);
-    u32 latticeTileWidth = parameters.latticeWidth >> 2;
-    u32 latticeTileHeight = parameters.latticeHeight >> 2;
-    u32 xTileUnique = latticeTileWidth - 1;
-    u32 yTileUnique = latticeTileHeight - 1;
+        f32 corner = rand.Uniform(parameters.rangeMin, parameters.rangeMax);
+        u32 latticeTileWidth = parameters.latticeWidth >> 2;
+        u32 latticeTileHeight = parameters.latticeHeight >> 2;
+        u32 xTileUnique = latticeTileWidth - 1;
+        u32 yTileUnique = latticeTileHeight - 1;
 
-    // Fill in horizontal tile edges (red, green)
-    u32 indices[] = {0, latticeTileHeight};
-    const u32 tileCopyBytes = latticeTileWidth * sizeof(f32);
-    for (u32 j = 0; j < 2; ++j)
-    {
-        std::vector<f32>& toFill = lattice[indices[j]];
-        toFill[0] = corner;
-        u32 index = 1;
-        for (u32 i = 0; i < xTileUnique; ++i)
+        // Fill in horizontal tile edges (red, green)
+        u32 indices[] = {0, latticeTileHeight};
+        const u32 tileCopyBytes = latticeTileWidth * sizeof(f32);
+        for (u32 j = 0; j < 2; ++j)
         {
-            toFill[index++] = rand.Uniform(parameters.rangeMin, parameters.rangeMax);
+            std::vector<f32>& toFill = lattice[indices[j]];
+            toFill[0] = corner;
+            u32 index = 1;
+            for (u32 i = 0; i < xTileUnique; ++i)
+            {
+                toFill[index++] = rand.Uniform(parameters.rangeMin, parameters.rangeMax);
+            }
+            toFill[index] = corner;
+            f32* source = &toFill[1];
+            f32* destination = source;
+            // Copy the generated edge to all 4 tiles
+            for (u32 i = 0; i < 3; ++i)
+            {
+                destination += latticeTileWidth;
+                memcpy(destination, source, tileCopyBytes);
+            }
         }
-        toFill[index] = corner;
-        f32* source = &toFill[1];
-        f32* destination = source;
-        // Copy the generated edge to all 4 tiles
-        for (u32 i = 0; i < 3; ++i)
+
+        // Copy generated rows to other rows that have same colors
+        const u32 rowCopyBytes = xPoints * sizeof(f32);
+        f32* source = &lattice[0][0];
+        f32* destination = &lattice[latticeTileHeight * 3][0];
+        memcpy(destination, source, rowCopyBytes);
+        destination = &lattice[latticeTileHeight * 4][0];
+        memcpy(destination, source, rowCopyBytes);
+
+        source = &lattice[latticeTileHeight][0];
+        destination = &lattice[latticeTileHeight * 2][0];
+        memcpy(destination, source, rowCopyBytes);
+
+        // Generate vertical tile edges
+        std::vector<f32> vertical0(yTileUnique);
+        std::vector<f32> vertical1(yTileUnique);
+        for (u32 i = 0; i < yTileUnique; ++i)
         {
-            destination += latticeTileWidth;
-            memcpy(destination, source, tileCopyBytes);
+            vertical0[i] = rand.Uniform(parameters.rangeMin, parameters.rangeMax);
+            vertical1[i] = rand.Uniform(parameters.rangeMin, parameters.rangeMax);
         }
-    }
-    
-    // Copy generated rows to other rows that have same colors
-    const u32 rowCopyBytes = xPoints * sizeof(f32);
-    f32* source = &lattice[0][0];
-    f32* destination = &lattice[latticeTileHeight * 3][0];
-    memcpy(destination, source, rowCopyBytes);
-    destination = &lattice[latticeTileHeight * 4][0];
-    memcpy(destination, source, rowCopyBytes);
-    
-    source = &lattice[latticeTileHeight][0];
-    destination = &lattice[latticeTileHeight * 2][0];
-    memcpy(destination, source, rowCopyBytes);
-
-    // Generate vertical tile edges
-    std::vector<f32> vertical0(yTileUnique);
-    std::vector<f32> vertical1(yTileUnique);
-    for (u32 i = 0; i < yTileUnique; ++i)
-    {
-        vertical0[i] = rand.Uniform(parameters.rangeMin, parameters.rangeMax);
-        vertical1[i] = rand.Uniform(parameters.rangeMin, parameters.rangeMax);
-    }
 
-    for (u32 verticalTileIndex = 0; verticalTileIndex < 4; ++verticalTileIndex)
-    {
-        u32 rowIndex = latticeTileHeight * verticalTileIndex + 1;
-        for (u32 i = 0; i < yTileUnique; ++i)
+        for (u32 verticalTileIndex = 0; verticalTileIndex < 4; ++verticalTileIndex)
         {
-            std::vector<f32>& row = lattice[rowIndex++];
-            row[0] = vertical0[i];
-            row[latticeTileWidth] = vertical0[i];
-            row[latticeTileWidth * 2] = vertical1[i];
-            row[latticeTileWidth * 3] = vertical1[i];
-            row[latticeTileWidth * 4] = vertical0[i];
-
-            for (u32 horizontalTileIndex = 0; horizontalTileIndex < 4; ++horizontalTileIndex)
+            u32 rowIndex = latticeTileHeight * verticalTileIndex + 1;
+            for (u32 i = 0; i < yTileUnique; ++i)
             {
-                u32 index = horizontalTileIndex * latticeTileWidth + 1;
-                for (u32 j = 0; j < xTileUnique; ++j)
+                std::vector<f32>& row = lattice[rowIndex++];
+                row[0] = vertical0[i];
+                row[latticeTileWidth] = vertical0[i];
+                row[latticeTileWidth * 2] = vertical1[i];
+                row[latticeTileWidth * 3] = vertical1[i];
+                row[latticeTileWidth * 4] = vertical0[i];
+
+                for (u32 horizontalTileIndex = 0; horizontalTileIndex < 4; ++horizontalTileIndex)
                 {
-                    row[index++] = rand.Uniform(parameters.rangeMin, parameters.rangeMax);
+                    u32 index = horizontalTileIndex * latticeTileWidth + 1;
+                    for (u32 j = 0; j < xTileUnique; ++j)
+                    {
+                        row[index++] = rand.Uniform(parameters.rangeMin, parameters.rangeMax);
+                    }
                 }
             }
         }
@@ -225,4 +246,132 @@ void ValueNoise<Interpolator>::GenerateWang(const Parameters& parameters, ImageD
     Generate(lattice, parameters, data);
 }
 
+// Lattice point (x, y) of GenerateSimple is the (y * latticeWidth + x)th value drawn, the last row and column repeat
+// the first ones.
+template<class Interpolator>
+static f32 latticeValue(const typename ValueNoise<Interpolator>::Parameters& parameters, u32 x, u32 y)
+{
+    Random rand(1);
+    rand.Skip(y * parameters.latticeWidth + x);
+    return rand.Uniform(parameters.rangeMin, parameters.rangeMax);
+}
+
+template<class Interpolator>
+void ValueNoise<Interpolator>::Evaluate(const Parameters& parameters, const f32* xs, const f32* ys, f32* out, size_t n)
+{
+    // Neighbouring points mostly share a cell, its corners are only drawn again when the cell changes.
+    f32 cachedCellX = NAN;
+    f32 cachedCellY = NAN;
+    f32 tl = 0.0f;
+    f32 tr = 0.0f;
+    f32 bl = 0.0f;
+    f32 br = 0.0f;
+    for (size_t k = 0; k < n; ++k)
+    {
+        // NaN takes the corners of cell 0, its weight makes the result NaN.
+        f32 x = wrapCoordinate(xs[k], static_cast<f32>(parameters.latticeWidth));
+        f32 y = wrapCoordinate(ys[k], static_cast<f32>(parameters.latticeHeight));
+        f32 cellX = std::isnan(x) ? 0.0f : floorf(x);
+        f32 cellY = std::isnan(y) ? 0.0f : floorf(y);
+        if (cellX != cachedCellX || cellY != cachedCellY)
+        {
+            u32 left = wrapLatticeCell(static_cast<i32>(cellX), parameters.latticeWidth);
+            u32 top = wrapLatticeCell(static_cast<i32>(cellY), parameters.latticeHeight);
+            u32 right = left + 1 < parameters.latticeWidth ? left + 1 : 0;
+            u32 bottom = top + 1 < parameters.latticeHeight ? top + 1 : 0;
+
+            // Stepping one cell to the right keeps the right corners as the new left ones.
+            if (cellY == cachedCellY && cellX == cachedCellX + 1.0f)
+            {
+                tl = tr;
+                bl = br;
+            }
+            else
+            {
+                tl = latticeValue<Interpolator>(parameters, left, top);
+                bl = latticeValue<Interpolator>(parameters, left, bottom);
+            }
+            tr = latticeValue<Interpolator>(parameters, right, top);
+            br = latticeValue<Interpolator>(parameters, right, bottom);
+            cachedCellX = cellX;
+            cachedCellY = cellY;
+        }
+
+        f32 xWeight = Interpolator()(x - cellX);
+        f32 yWeight = Interpolator()(y - cellY);
+        out[k] = bilerp(tl, tr, bl, br, yWeight, 1.0f - yWeight, xWeight);
+    }
+}
+
+template<class Interpolator>
+void ValueNoise<Interpolator>::GenerateSlice(const Parameters& parameters, u32 depth, u32 z, ImageData& data)
+{
+    PROFILE_SCOPE_BYTES("pixels", data.GetByteCount());
+
+    const u32 w = data.GetWidth();
+    const u32 h = data.GetHeight();
+    assert(w % parameters.latticeWidth == 0);
+    assert(h % parameters.latticeHeight == 0);
+    assert(depth % parameters.latticeDepth == 0);
+    assert(z < depth);
+    assert(data.GetMipLevelCount() == 1);
+
+    std::vector<f32> zWeights;
+    u32 zWeightCount = depth / parameters.latticeDepth;
+    generateWeights(zWeightCount, zWeights);
+    u32 frontIndex = z / zWeightCount;
+    u32 backIndex = frontIndex + 1 < parameters.latticeDepth ? frontIndex + 1 : 0;
+    f32 zWeight = Interpolator()(zWeights[z - frontIndex * zWeightCount]);
+    f32 invZWeight = 1.0f - zWeight;
+
+    // Lattice point (x, y, z) is the ((z * latticeHeight + y) * latticeWidth + x)th value drawn, so plane 0 is the image
+    // lattice. Only the two planes around the slice are drawn.
+    const u32 planeSize = parameters.latticeWidth * parameters.latticeHeight;
+    std::vector<f32> planes[2];
+    const u32 planeIndices[] = { frontIndex, backIndex };
+    for (u32 plane = 0; plane < 2; ++plane)
+    {
+        Random rand(1);
+        rand.Skip(planeIndices[plane] * planeSize);
+        planes[plane].resize(planeSize);
+        for (u32 i = 0; i < planeSize; ++i)
+            planes[plane][i] = rand.Uniform(parameters.rangeMin, parameters.rangeMax);
+    }
+
+    std::vector<f32> xWeights;
+    std::vector<f32> yWeights;
+    u32 xWeightCount = w / parameters.latticeWidth;
+    u32 yWeightCount = h / parameters.latticeHeight;
+    generateWeights(xWeightCount, xWeights);
+    generateWeights(yWeightCount, yWeights);
+
+    f32* pixels = data.GetPixels(0);
+    ThreadPool::Instance().ParallelFor(h, [&](u32 begin, u32 end)
+    {
+        u64 index = static_cast<u64>(begin) * w;
+        for (u32 y = begin; y < end; ++y)
+        {
+            u32 top = y / yWeightCount;
+            u32 bottom = top + 1 < parameters.latticeHeight ? top + 1 : 0;
+            f32 yWeight = Interpolator()(yWeights[y - top * yWeightCount]);
+            f32 invYWeight = 1.0f - yWeight;
+            const f32* frontTop = &planes[0][top * parameters.latticeWidth];
+            const f32* frontBottom = &planes[0][bottom * parameters.latticeWidth];
+            const f32* backTop = &planes[1][top * parameters.latticeWidth];
+            const f32* backBottom = &planes[1][bottom * parameters.latticeWidth];
+            for (u32 x = 0; x < w; ++x)
+            {
+                u32 left = x / xWeightCount;
+                u32 right = left + 1 < parameters.latticeWidth ? left + 1 : 0;
+                f32 xWeight = Interpolator()(xWeights[x - left * xWeightCount]);
+
+                f32 front = bilerp(frontTop[left], frontTop[right], frontBottom[left], frontBottom[right], yWeight, invYWeight, xWeight);
+                f32 back = bilerp(backTop[left], backTop[right], backBottom[left], backBottom[right], yWeight, invYWeight, xWeight);
+                pixels[index] = fmaf(front, invZWeight, back * zWeight);
+                ++index;
+            }
+        }
+    });
+}
+
 template class ValueNoise<LinearInterpolator>;
@@ -3,6 +3,7 @@
 #include "generators/TilingMode.hpp"
 #include "utility/Types.hpp"
 
+#include <cstddef>
 #include <vector>
 
 class ImageData;
@@ -15,12 +16,22 @@ public:
     {
         u32 latticeWidth;
         u32 latticeHeight;
+        // Only used by volumes.
+        u32 latticeDepth;
         f32 rangeMin;
         f32 rangeMax;
     };
 
     static void GenerateSimple(const Parameters& parameters, ImageData& data);
     static void GenerateWang(const Parameters& parameters, ImageData& data);
+    // Samples the noise of GenerateSimple at n points given in lattice cells, so that it repeats every latticeWidth x
+    // latticeHeight cells. Pixel (x, y) of a w x h image lies at (x * latticeWidth / w, y * latticeHeight / h).
+    // Points are wrapped into the first period, so any finite coordinate is valid. A NaN coordinate gives NaN.
+    static void Evaluate(const Parameters& parameters, const f32* xs, const f32* ys, f32* out, size_t n);
+    // Fills data with slice z of a volume that is depth slices deep and repeats every latticeWidth x latticeHeight x
+    // latticeDepth cells. Only the lattice planes around the slice are built, so a volume can be generated and written a
+    // slice at a time.
+    static void GenerateSlice(const Parameters& parameters, u32 depth, u32 z, ImageData& data);
 
 private:
     static void Generate(const std::vector<std::vector<f32>>& lattice, const Parameters& parameters, ImageData& data);
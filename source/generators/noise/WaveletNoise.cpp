@@ -5,6 +5,8 @@
 #include "generators/Interpolator.hpp"
 #include "generators/NoiseCommon.hpp"
 #include "image/ImageData.hpp"
+#include "utility/Profiler.hpp"
+#include "utility/ThreadPool.hpp"
 
 static constexpr u32 kRadius = 16;
 
@@ -59,6 +61,8 @@ static void Upsample(const f32* const source, f32* destination, u32 size, u32 st
 template<class Interpolator>
 void WaveletNoise<Interpolator>::Generate(const Parameters& parameters, ImageData& data, ImageData& baseNoise)
 {
+    PROFILE_SCOPE_BYTES("pixels", data.GetByteCount());
+
     u32 mipCount = data.GetMipLevelCount();
 
     std::vector<f32> downsampleBuffer;
@@ -134,52 +138,68 @@ void WaveletNoise<Interpolator>::Generate(const Parameters& parameters, ImageDat
         generateWeights(xWeightCount, xWeights);
         generateWeights(yWeightCount, yWeights);
 
-        u32 index = 0;
-        u32 topIndex = 0;
-        u32 bottomIndex = latticeYStride;
-        u32 yWeightIndex = 0;
-        for (u32 j = 0; j < height; ++j)
+        u32 firstRow;
+        u32 rowCount;
+        data.GetRows(mip, firstRow, rowCount);
+        ThreadPool::Instance().ParallelFor(rowCount, [&](u32 begin, u32 end)
         {
-            const f32* top = &baseSource[topIndex * parameters.latticeWidth];
-            const f32* bottom = &baseSource[bottomIndex * parameters.latticeWidth];
-
-            u32 xWeightIndex = 0;
-            u32 leftIndex = 0;
-            u32 rightIndex = latticeXStride;
-            f32 yWeight = Interpolator()(yWeights[yWeightIndex]);
-            f32 invYWeight = 1.0f - yWeight;
-            for (u32 i = 0; i < width; ++i)
+            u32 yBegin = firstRow + begin;
+            u32 yEnd = firstRow + end;
+            u64 index = static_cast<u64>(begin) * width;
+            u32 yCellSize = yWeightCount > 0 ? yWeightCount : 1;
+            u32 yCell = yBegin / yCellSize;
+            u32 yWeightIndex = yBegin - yCell * yCellSize;
+            u32 topIndex = 0;
+            u32 bottomIndex = latticeYStride;
+            for (u32 i = 0; i < yCell; ++i)
             {
-                f32 xWeight = Interpolator()(xWeights[xWeightIndex]);
-
-                f32 tl = top[leftIndex];
-                f32 tr = top[rightIndex];
-                f32 bl = bottom[leftIndex];
-                f32 br = bottom[rightIndex];
-
-                f32 value = bilerp(tl, tr, bl, br, yWeight, invYWeight, xWeight);
-                pixels[index] = fmaf(value, 0.5f, 0.5f);
-
-                ++index;
-                ++xWeightIndex;
-                if (xWeightIndex >= xWeightCount)
-                {
-                    xWeightIndex = 0;
-                    leftIndex = rightIndex;
-                    rightIndex += latticeXStride;
-                    rightIndex = (rightIndex >= maxLatticeX) ? 0 : rightIndex;
-                }
-            }
-
-            ++yWeightIndex;
-            if (yWeightIndex >= yWeightCount)
-            {
-                yWeightIndex = 0;
                 topIndex = bottomIndex;
                 bottomIndex += latticeYStride;
                 bottomIndex = (bottomIndex >= maxLatticeY) ? 0 : bottomIndex;
             }
-        }
+            for (u32 j = yBegin; j < yEnd; ++j)
+            {
+                const f32* top = &baseSource[topIndex * parameters.latticeWidth];
+                const f32* bottom = &baseSource[bottomIndex * parameters.latticeWidth];
+
+                u32 xWeightIndex = 0;
+                u32 leftIndex = 0;
+                u32 rightIndex = latticeXStride;
+                f32 yWeight = Interpolator()(yWeights[yWeightIndex]);
+                f32 invYWeight = 1.0f - yWeight;
+                for (u32 i = 0; i < width; ++i)
+                {
+                    f32 xWeight = Interpolator()(xWeights[xWeightIndex]);
+
+                    f32 tl = top[leftIndex];
+                    f32 tr = top[rightIndex];
+                    f32 bl = bottom[leftIndex];
+                    f32 br = bottom[rightIndex];
+
+                    f32 value = bilerp(tl, tr, bl, br, yWeight, invYWeight, xWeight);
+                    pixels[index] = fmaf(value, 0.5f, 0.5f);
+
+                    ++index;
+                    ++xWeightIndex;
+                    if (xWeightIndex >= xWeightCount)
+                    {
+                        xWeightIndex = 0;
+                        leftIndex = rightIndex;
+                        rightIndex += latticeXStride;
+                        rightIndex = (rightIndex >= maxLatticeX) ? 0 : rightIndex;
+                    }
+                }
+
+                ++yWeightIndex;
+                if (yWeightIndex >= yWeightCount)
+                {
+                    yWeightIndex = 0;
+                    topIndex = bottomIndex;
+                    bottomIndex += latticeYStride;
+                    bottomIndex = (bottomIndex >= maxLatticeY) ? 0 : bottomIndex;
+                }
+            }
+        });
     }
 }
 
@@ -193,7 +213,11 @@ void WaveletNoise<Interpolator>::GenerateSimple(const Parameters& parameters, Im
     p.rangeMax = 1.0f;
     p.latticeWidth = parameters.latticeWidth;
     p.latticeHeight = parameters.latticeHeight;
-    ValueNoise<LinearInterpolator>::GenerateSimple(p, baseNoise);
+    {
+        // Its lattice and pixels show up nested in this scope, apart from the wavelet pixels.
+        PROFILE_SCOPE("base noise");
+        ValueNoise<LinearInterpolator>::GenerateSimple(p, baseNoise);
+    }
 
     Generate(parameters, data, baseNoise);
 }
@@ -208,7 +232,10 @@ void WaveletNoise<Interpolator>::GenerateWang(const Parameters& parameters, Imag
     p.rangeMax = 1.0f;
     p.latticeWidth = parameters.latticeWidth;
     p.latticeHeight = parameters.latticeHeight;
-    ValueNoise<LinearInterpolator>::GenerateWang(p, baseNoise);
+    {
+        PROFILE_SCOPE("base noise");
+        ValueNoise<LinearInterpolator>::GenerateWang(p, baseNoise);
+    }
 
     Generate(parameters, data, baseNoise);
 }
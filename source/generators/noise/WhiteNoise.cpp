@@ -1,125 +1,389 @@
 #include "WhiteNoise.hpp"
 
 #include "image/ImageData.hpp"
+#include "utility/Profiler.hpp"
+#include "utility/Simd.hpp"
+#include "utility/ThreadPool.hpp"
 
-#include <vector>
+#include <cassert>
+#include <cstdint>
+#include <utility>
 
-static std::vector<u32> S;
-static std::vector<u32> K;
+// MD5 per-round shift amounts.
+static constexpr u32 kShifts[64] = {
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
 
-void Initialize()
+// MD5 per-round constants, floor(2^32 * abs(sin(i + 1))).
+static constexpr u32 kConstants[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+// A single block holds the four input words followed by the padding: a set bit right after
+// the input and the message length of 128 bits in the last word. The remaining words are 0.
+static constexpr u32 kInputWordCount = 4;
+static constexpr u32 kPaddingWord = 4;
+static constexpr u32 kPaddingValue = 0x80000000;
+static constexpr u32 kLengthWord = 15;
+static constexpr u32 kLengthValue = 128;
+
+// Philox-4x32 round multipliers and key increments.
+static constexpr u32 kPhiloxMultiplier0 = 0xD2511F53;
+static constexpr u32 kPhiloxMultiplier1 = 0xCD9E8D57;
+static constexpr u32 kPhiloxKeyStep0 = 0x9E3779B9;
+static constexpr u32 kPhiloxKeyStep1 = 0xBB67AE85;
+static constexpr u32 kPhiloxRoundCount = 10;
+
+// Maps a hash to [0; 1]. The vector versions convert through doubles as well, so every lane type gives the same floats.
+static f32 toFloat(u32 value)
 {
-    if (S.size() != 0)
-        return;
+    return static_cast<f32>(static_cast<f64>(value) / static_cast<f64>(UINT32_MAX));
+}
 
-    S.resize(64);
-    for (u32 i = 0; i < 4; ++i)
-    {
-        S[i * 4] = 7;
-        S[i * 4 + 1] = 12;
-        S[i * 4 + 2] = 17;
-        S[i * 4 + 3] = 22;
+// Lane types provide the operations the hashes need, so the same code runs on 1, 4, 8 or 16 pixels at once.
+struct ScalarLanes
+{
+    typedef u32 Type;
+    static constexpr u32 kCount = 1;
 
-        S[i * 4 + 16] = 5;
-        S[i * 4 + 17] = 9;
-        S[i * 4 + 18] = 14;
-        S[i * 4 + 19] = 20;
+    static Type Set(u32 value) { return value; }
+    static Type SetSequence(u32 first) { return first; }
+    static Type Add(Type a, Type b) { return a + b; }
+    static Type And(Type a, Type b) { return a & b; }
+    static Type AndNot(Type a, Type b) { return ~a & b; }
+    static Type Or(Type a, Type b) { return a | b; }
+    static Type Xor(Type a, Type b) { return a ^ b; }
+    static Type OrNot(Type a, Type b) { return a | ~b; }
+    static Type Multiply(Type a, Type b) { return a * b; }
+    static Type MultiplyHigh(Type a, Type b) { return static_cast<u32>((static_cast<u64>(a) * b) >> 32); }
+    template<u32 shift>
+    static Type ShiftRight(Type a) { return a >> shift; }
+    template<u32 shift>
+    static Type Rotate(Type a) { return (a << shift) | (a >> (32 - shift)); }
+    static void Store(u32* destination, Type a) { destination[0] = a; }
+    static void StoreUnitFloats(f32* destination, Type a) { destination[0] = toFloat(a); }
+};
 
-        S[i * 4 + 32] = 4;
-        S[i * 4 + 33] = 11;
-        S[i * 4 + 34] = 16;
-        S[i * 4 + 35] = 23;
+#if NOISE_SIMD_SSE2
+struct Sse2Lanes
+{
+    typedef __m128i Type;
+    static constexpr u32 kCount = 4;
 
-        S[i * 4 + 48] = 6;
-        S[i * 4 + 49] = 10;
-        S[i * 4 + 50] = 15;
-        S[i * 4 + 51] = 21;
+    static Type Set(u32 value) { return _mm_set1_epi32(static_cast<i32>(value)); }
+    static Type SetSequence(u32 first) { return _mm_add_epi32(Set(first), _mm_setr_epi32(0, 1, 2, 3)); }
+    static Type Add(Type a, Type b) { return _mm_add_epi32(a, b); }
+    static Type And(Type a, Type b) { return _mm_and_si128(a, b); }
+    static Type AndNot(Type a, Type b) { return _mm_andnot_si128(a, b); }
+    static Type Or(Type a, Type b) { return _mm_or_si128(a, b); }
+    static Type Xor(Type a, Type b) { return _mm_xor_si128(a, b); }
+    static Type OrNot(Type a, Type b) { return _mm_or_si128(a, _mm_xor_si128(b, _mm_set1_epi32(-1))); }
+    // SSE2 only multiplies the even lanes into 64 bit products, the odd ones are shifted down first.
+    static Type Multiply(Type a, Type b)
+    {
+        __m128i even = _mm_mul_epu32(a, b);
+        __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(2, 0, 2, 0)));
     }
-
-    K.resize(64);
-    double d = static_cast<double>(0x100000000ull);
-    for (u32 i = 0; i < 64; ++i)
+    static Type MultiplyHigh(Type a, Type b)
     {
-        K[i] = static_cast<u32>(floor(d * abs(sin(i + 1))));
+        __m128i even = _mm_mul_epu32(a, b);
+        __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(3, 1, 3, 1)));
     }
-}
+    template<u32 shift>
+    static Type ShiftRight(Type a) { return _mm_srli_epi32(a, shift); }
+    template<u32 shift>
+    static Type Rotate(Type a) { return _mm_or_si128(_mm_slli_epi32(a, shift), _mm_srli_epi32(a, 32 - shift)); }
+    static void Store(u32* destination, Type a) { _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), a); }
+    static void StoreUnitFloats(f32* destination, Type a)
+    {
+        // Flipping the top bit turns the unsigned value into a signed one that converts exactly.
+        __m128i shifted = _mm_xor_si128(a, _mm_set1_epi32(INT32_MIN));
+        __m128d offset = _mm_set1_pd(2147483648.0);
+        __m128d scale = _mm_set1_pd(static_cast<f64>(UINT32_MAX));
+        __m128d low = _mm_div_pd(_mm_add_pd(_mm_cvtepi32_pd(shifted), offset), scale);
+        __m128d high = _mm_div_pd(_mm_add_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(shifted, _MM_SHUFFLE(1, 0, 3, 2))), offset), scale);
+        _mm_storeu_ps(destination, _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high)));
+    }
+};
+#endif
 
-static void GenerateWhiteNoise(u32 x, u32 y, u32 z, u32 w, u32 key, u32* result)
+#if NOISE_SIMD_AVX2
+struct Avx2Lanes
 {
-    Initialize();
+    typedef __m256i Type;
+    static constexpr u32 kCount = 8;
 
-    u32 data[16] = {
-        x ^ key, y ^ key, z ^ key, w ^ key,
-        0x80000000, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 128
-    };
-    
-    u32 A = 0x67452301;
-    u32 B = 0xefcdab89;
-    u32 C = 0x98badcfe;
-    u32 D = 0x10325476;
+    static Type Set(u32 value) { return _mm256_set1_epi32(static_cast<i32>(value)); }
+    static Type SetSequence(u32 first) { return _mm256_add_epi32(Set(first), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)); }
+    static Type Add(Type a, Type b) { return _mm256_add_epi32(a, b); }
+    static Type And(Type a, Type b) { return _mm256_and_si256(a, b); }
+    static Type AndNot(Type a, Type b) { return _mm256_andnot_si256(a, b); }
+    static Type Or(Type a, Type b) { return _mm256_or_si256(a, b); }
+    static Type Xor(Type a, Type b) { return _mm256_xor_si256(a, b); }
+    static Type OrNot(Type a, Type b) { return _mm256_or_si256(a, _mm256_xor_si256(b, _mm256_set1_epi32(-1))); }
+    static Type Multiply(Type a, Type b) { return _mm256_mullo_epi32(a, b); }
+    static Type MultiplyHigh(Type a, Type b)
+    {
+        __m256i even = _mm256_mul_epu32(a, b);
+        __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+        return _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+    }
+    template<u32 shift>
+    static Type ShiftRight(Type a) { return _mm256_srli_epi32(a, shift); }
+    template<u32 shift>
+    static Type Rotate(Type a) { return _mm256_or_si256(_mm256_slli_epi32(a, shift), _mm256_srli_epi32(a, 32 - shift)); }
+    static void Store(u32* destination, Type a) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination), a); }
+    static void StoreUnitFloats(f32* destination, Type a)
+    {
+        // Flipping the top bit turns the unsigned value into a signed one that converts exactly.
+        __m256i shifted = _mm256_xor_si256(a, _mm256_set1_epi32(INT32_MIN));
+        __m256d offset = _mm256_set1_pd(2147483648.0);
+        __m256d scale = _mm256_set1_pd(static_cast<f64>(UINT32_MAX));
+        __m256d low = _mm256_div_pd(_mm256_add_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(shifted)), offset), scale);
+        __m256d high = _mm256_div_pd(_mm256_add_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(shifted, 1)), offset), scale);
+        _mm_storeu_ps(destination, _mm256_cvtpd_ps(low));
+        _mm_storeu_ps(destination + 4, _mm256_cvtpd_ps(high));
+    }
+};
+#endif
 
-    u32 F;
-    u32 g;
-    u32 s;
+#if NOISE_SIMD_AVX512
+struct Avx512Lanes
+{
+    typedef __m512i Type;
+    static constexpr u32 kCount = 16;
 
-    for (u32 i = 0; i < 16; ++i)
+    static Type Set(u32 value) { return _mm512_set1_epi32(static_cast<i32>(value)); }
+    static Type SetSequence(u32 first) { return _mm512_add_epi32(Set(first), _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)); }
+    static Type Add(Type a, Type b) { return _mm512_add_epi32(a, b); }
+    static Type And(Type a, Type b) { return _mm512_and_si512(a, b); }
+    static Type AndNot(Type a, Type b) { return _mm512_andnot_si512(a, b); }
+    static Type Or(Type a, Type b) { return _mm512_or_si512(a, b); }
+    static Type Xor(Type a, Type b) { return _mm512_xor_si512(a, b); }
+    static Type OrNot(Type a, Type b) { return _mm512_or_si512(a, _mm512_xor_si512(b, _mm512_set1_epi32(-1))); }
+    static Type Multiply(Type a, Type b) { return _mm512_mullo_epi32(a, b); }
+    static Type MultiplyHigh(Type a, Type b)
     {
-        F = ((B & C) | (~B & D)) + A + K[i] + data[i];
-        A = D;
-        D = C;
-        C = B;
-        s = S[i];
-        B += (F << s) | (F >> (32 - s));
+        __m512i even = _mm512_mul_epu32(a, b);
+        __m512i odd = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), _mm512_srli_epi64(b, 32));
+        return _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(even, 32), odd);
     }
-    for (u32 i = 16; i < 32; ++i)
+    template<u32 shift>
+    static Type ShiftRight(Type a) { return _mm512_srli_epi32(a, shift); }
+    template<u32 shift>
+    static Type Rotate(Type a) { return _mm512_rol_epi32(a, shift); }
+    static void Store(u32* destination, Type a) { _mm512_storeu_si512(destination, a); }
+    static void StoreUnitFloats(f32* destination, Type a)
     {
-        g = (i * 5 + 1) & 0xF;
-
-        F = ((D & B) | (~D & C)) + A + K[i] + data[g];
-        A = D;
-        D = C;
-        C = B;
-        s = S[i];
-        B += (F << s) | (F >> (32 - s));
+        __m512d scale = _mm512_set1_pd(static_cast<f64>(UINT32_MAX));
+        __m512d low = _mm512_div_pd(_mm512_cvtepu32_pd(_mm512_castsi512_si256(a)), scale);
+        __m512d high = _mm512_div_pd(_mm512_cvtepu32_pd(_mm512_extracti64x4_epi64(a, 1)), scale);
+        _mm256_storeu_ps(destination, _mm512_cvtpd_ps(low));
+        _mm256_storeu_ps(destination + 8, _mm512_cvtpd_ps(high));
     }
-    for (u32 i = 32; i < 48; ++i)
+};
+#endif
+
+#if NOISE_SIMD_AVX512
+typedef Avx512Lanes WhiteNoiseLanes;
+#elif NOISE_SIMD_AVX2
+typedef Avx2Lanes WhiteNoiseLanes;
+#elif NOISE_SIMD_SSE2
+typedef Sse2Lanes WhiteNoiseLanes;
+#else
+typedef ScalarLanes WhiteNoiseLanes;
+#endif
+
+template<class Lanes>
+struct Md5State
+{
+    typename Lanes::Type A;
+    typename Lanes::Type B;
+    typename Lanes::Type C;
+    typename Lanes::Type D;
+};
+
+// One MD5 round with everything that only depends on the round index resolved at compile time.
+// Zero message words are skipped and the padding words are folded into the round constant.
+template<class Lanes, u32 i>
+static inline void md5Round(Md5State<Lanes>& state, const typename Lanes::Type* data)
+{
+    typedef typename Lanes::Type Type;
+
+    constexpr u32 g = i < 16 ? i : (i < 32 ? (i * 5 + 1) & 0xF : (i < 48 ? (i * 3 + 5) & 0xF : (i * 7) & 0xF));
+    constexpr u32 padding = g == kPaddingWord ? kPaddingValue : (g == kLengthWord ? kLengthValue : 0);
+
+    Type F;
+    if constexpr (i < 16)
+        F = Lanes::Or(Lanes::And(state.B, state.C), Lanes::AndNot(state.B, state.D));
+    else if constexpr (i < 32)
+        F = Lanes::Or(Lanes::And(state.D, state.B), Lanes::AndNot(state.D, state.C));
+    else if constexpr (i < 48)
+        F = Lanes::Xor(Lanes::Xor(state.B, state.C), state.D);
+    else
+        F = Lanes::Xor(state.C, Lanes::OrNot(state.B, state.D));
+
+    F = Lanes::Add(Lanes::Add(F, state.A), Lanes::Set(kConstants[i] + padding));
+    if constexpr (g < kInputWordCount)
+        F = Lanes::Add(F, data[g]);
+
+    state.A = state.D;
+    state.D = state.C;
+    state.C = state.B;
+    state.B = Lanes::Add(state.B, Lanes::template Rotate<kShifts[i]>(F));
+}
+
+template<class Lanes, u32... i>
+static inline void md5Rounds(Md5State<Lanes>& state, const typename Lanes::Type* data, std::integer_sequence<u32, i...>)
+{
+    (md5Round<Lanes, i>(state, data), ...);
+}
+
+// Every hash maps (x, y, z, w) and a key to four words. Each lane is an independent hash.
+// MD5, with the key mixed into every input word.
+struct Md5Hash
+{
+    template<class Lanes>
+    static void Generate(typename Lanes::Type x, typename Lanes::Type y, typename Lanes::Type z, typename Lanes::Type w, u32 key,
+        typename Lanes::Type* result)
     {
-        g = (i * 3 + 5) & 0xF;
+        typename Lanes::Type keys = Lanes::Set(key);
+        const typename Lanes::Type data[kInputWordCount] = {
+            Lanes::Xor(x, keys), Lanes::Xor(y, keys), Lanes::Xor(z, keys), Lanes::Xor(w, keys)
+        };
+
+        Md5State<Lanes> state;
+        state.A = Lanes::Set(0x67452301);
+        state.B = Lanes::Set(0xefcdab89);
+        state.C = Lanes::Set(0x98badcfe);
+        state.D = Lanes::Set(0x10325476);
 
-        F = (B ^ C ^ D) + A + K[i] + data[g];
-        A = D;
-        D = C;
-        C = B;
-        s = S[i];
-        B += (F << s) | (F >> (32 - s));
+        md5Rounds<Lanes>(state, data, std::make_integer_sequence<u32, 64>());
+
+        result[0] = state.A;
+        result[1] = state.B;
+        result[2] = state.C;
+        result[3] = state.D;
     }
-    for (u32 i = 48; i < 64; ++i)
+};
+
+// pcg4d from "Hash Functions for GPU Rendering" (Jarzynski, Olano), with the key mixed into every input word.
+struct PcgHash
+{
+    template<class Lanes>
+    static void Generate(typename Lanes::Type x, typename Lanes::Type y, typename Lanes::Type z, typename Lanes::Type w, u32 key,
+        typename Lanes::Type* result)
     {
-        g = (i * 7) & 0xF;
+        typedef typename Lanes::Type Type;
 
-        F = (C ^ (B | ~D)) + A + K[i] + data[g];
-        A = D;
-        D = C;
-        C = B;
-        s = S[i];
-        B += (F << s) | (F >> (32 - s));
+        Type keys = Lanes::Set(key);
+        Type multiplier = Lanes::Set(1664525u);
+        Type increment = Lanes::Set(1013904223u);
+        Type v[4] = {
+            Lanes::Add(Lanes::Multiply(Lanes::Xor(x, keys), multiplier), increment),
+            Lanes::Add(Lanes::Multiply(Lanes::Xor(y, keys), multiplier), increment),
+            Lanes::Add(Lanes::Multiply(Lanes::Xor(z, keys), multiplier), increment),
+            Lanes::Add(Lanes::Multiply(Lanes::Xor(w, keys), multiplier), increment)
+        };
+
+        Mix<Lanes>(v);
+        for (u32 i = 0; i < 4; ++i)
+            v[i] = Lanes::Xor(v[i], Lanes::template ShiftRight<16>(v[i]));
+        Mix<Lanes>(v);
+
+        for (u32 i = 0; i < 4; ++i)
+            result[i] = v[i];
     }
 
-    result[0] = A;
-    result[1] = B;
-    result[2] = C;
-    result[3] = D;
-}
+private:
+    template<class Lanes>
+    static void Mix(typename Lanes::Type* v)
+    {
+        v[0] = Lanes::Add(v[0], Lanes::Multiply(v[1], v[3]));
+        v[1] = Lanes::Add(v[1], Lanes::Multiply(v[2], v[0]));
+        v[2] = Lanes::Add(v[2], Lanes::Multiply(v[0], v[1]));
+        v[3] = Lanes::Add(v[3], Lanes::Multiply(v[1], v[2]));
+    }
+};
 
-static f32 toFloat(u32 value)
+// Philox-4x32-10 from "Parallel Random Numbers: As Easy as 1, 2, 3" (Salmon et al.), counting (x, y, z, w) under the key.
+struct PhiloxHash
 {
-    return static_cast<f32>(static_cast<f64>(value) / static_cast<f64>(UINT32_MAX));
+    template<class Lanes>
+    static void Generate(typename Lanes::Type x, typename Lanes::Type y, typename Lanes::Type z, typename Lanes::Type w, u32 key,
+        typename Lanes::Type* result)
+    {
+        typedef typename Lanes::Type Type;
+
+        const Type multiplier0 = Lanes::Set(kPhiloxMultiplier0);
+        const Type multiplier1 = Lanes::Set(kPhiloxMultiplier1);
+        Type counter[4] = { x, y, z, w };
+        u32 key0 = key;
+        u32 key1 = 0;
+        for (u32 round = 0; round < kPhiloxRoundCount; ++round)
+        {
+            Type high0 = Lanes::MultiplyHigh(multiplier0, counter[0]);
+            Type low0 = Lanes::Multiply(multiplier0, counter[0]);
+            Type high1 = Lanes::MultiplyHigh(multiplier1, counter[2]);
+            Type low1 = Lanes::Multiply(multiplier1, counter[2]);
+
+            counter[0] = Lanes::Xor(Lanes::Xor(high1, counter[1]), Lanes::Set(key0));
+            counter[1] = low1;
+            counter[2] = Lanes::Xor(Lanes::Xor(high0, counter[3]), Lanes::Set(key1));
+            counter[3] = low0;
+
+            key0 += kPhiloxKeyStep0;
+            key1 += kPhiloxKeyStep1;
+        }
+
+        for (u32 i = 0; i < 4; ++i)
+            result[i] = counter[i];
+    }
+};
+
+template<class Lanes, class Hash>
+static void generateRow(u32 y, u32 width, f32* row)
+{
+    const typename Lanes::Type zero = Lanes::Set(0);
+    const typename Lanes::Type ys = Lanes::Set(y);
+    typename Lanes::Type buffer[4];
+    f32 tail[Lanes::kCount];
+    for (u32 x = 0; x < width; x += Lanes::kCount)
+    {
+        Hash::template Generate<Lanes>(Lanes::SetSequence(x), ys, zero, zero, 0, buffer);
+
+        // The last group of a row may cover fewer pixels than there are lanes.
+        u32 count = width - x < Lanes::kCount ? width - x : Lanes::kCount;
+        if (count == Lanes::kCount)
+        {
+            Lanes::StoreUnitFloats(row + x, buffer[0]);
+        }
+        else
+        {
+            Lanes::StoreUnitFloats(tail, buffer[0]);
+            for (u32 lane = 0; lane < count; ++lane)
+                row[x + lane] = tail[lane];
+        }
+    }
 }
 
-void WhiteNoise::GenerateSimple(const Parameters&, ImageData& data)
+template<class Hash>
+static void generate(ImageData& data)
 {
+    PROFILE_SCOPE_BYTES("pixels", data.GetByteCount());
+
     const u32 mips = data.GetMipLevelCount();
     for (u32 mip = 0; mip < mips; ++mip)
     {
@@ -129,17 +393,59 @@ void WhiteNoise::GenerateSimple(const Parameters&, ImageData& data)
 
         f32* pixels = data.GetPixels(mip);
 
-        u32 buffer[4];
-        u32 index = 0;
-        for (u32 y = 0; y < h; ++y)
+        u32 firstRow;
+        u32 rowCount;
+        data.GetRows(mip, firstRow, rowCount);
+        ThreadPool::Instance().ParallelFor(rowCount, [&](u32 begin, u32 end)
         {
-            for (u32 x = 0; x < w; ++x)
-            {
-                GenerateWhiteNoise(x, y, 0, 0, 0, buffer);
-                pixels[index] = toFloat(buffer[0]);
-                ++index;
-            }
-        }
+            for (u32 row = begin; row < end; ++row)
+                generateRow<WhiteNoiseLanes, Hash>(firstRow + row, w, pixels + static_cast<u64>(row) * w);
+        });
+    }
+}
+
+template<class Hash>
+static void generateRowOnLanes(u32 laneCount, u32 y, u32 width, f32* row)
+{
+    switch (laneCount)
+    {
+    case ScalarLanes::kCount:
+        generateRow<ScalarLanes, Hash>(y, width, row);
+        break;
+#if NOISE_SIMD_SSE2
+    case Sse2Lanes::kCount:
+        generateRow<Sse2Lanes, Hash>(y, width, row);
+        break;
+#endif
+#if NOISE_SIMD_AVX2
+    case Avx2Lanes::kCount:
+        generateRow<Avx2Lanes, Hash>(y, width, row);
+        break;
+#endif
+#if NOISE_SIMD_AVX512
+    case Avx512Lanes::kCount:
+        generateRow<Avx512Lanes, Hash>(y, width, row);
+        break;
+#endif
+    default:
+        assert(false);
+        break;
+    }
+}
+
+void WhiteNoise::GenerateSimple(const Parameters& parameters, ImageData& data)
+{
+    switch (parameters.hash)
+    {
+    case Hash::kMd5:
+        generate<Md5Hash>(data);
+        break;
+    case Hash::kPcg:
+        generate<PcgHash>(data);
+        break;
+    case Hash::kPhilox:
+        generate<PhiloxHash>(data);
+        break;
     }
 }
 
@@ -147,3 +453,50 @@ void WhiteNoise::GenerateWang(const Parameters& parameters, ImageData& data)
 {
     GenerateSimple(parameters, data);
 }
+
+void WhiteNoise::HashWords(Hash hash, const u32* input, u32 key, u32* output)
+{
+    switch (hash)
+    {
+    case Hash::kMd5:
+        Md5Hash::Generate<ScalarLanes>(input[0], input[1], input[2], input[3], key, output);
+        break;
+    case Hash::kPcg:
+        PcgHash::Generate<ScalarLanes>(input[0], input[1], input[2], input[3], key, output);
+        break;
+    case Hash::kPhilox:
+        PhiloxHash::Generate<ScalarLanes>(input[0], input[1], input[2], input[3], key, output);
+        break;
+    }
+}
+
+std::vector<u32> WhiteNoise::GetLaneCounts()
+{
+    std::vector<u32> counts = { ScalarLanes::kCount };
+#if NOISE_SIMD_SSE2
+    counts.push_back(Sse2Lanes::kCount);
+#endif
+#if NOISE_SIMD_AVX2
+    counts.push_back(Avx2Lanes::kCount);
+#endif
+#if NOISE_SIMD_AVX512
+    counts.push_back(Avx512Lanes::kCount);
+#endif
+    return counts;
+}
+
+void WhiteNoise::GenerateRow(Hash hash, u32 laneCount, u32 y, u32 width, f32* row)
+{
+    switch (hash)
+    {
+    case Hash::kMd5:
+        generateRowOnLanes<Md5Hash>(laneCount, y, width, row);
+        break;
+    case Hash::kPcg:
+        generateRowOnLanes<PcgHash>(laneCount, y, width, row);
+        break;
+    case Hash::kPhilox:
+        generateRowOnLanes<PhiloxHash>(laneCount, y, width, row);
+        break;
+    }
+}
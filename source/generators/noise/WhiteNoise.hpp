@@ -3,14 +3,32 @@
 #include "generators/TilingMode.hpp"
 #include "utility/Types.hpp"
 
+#include <vector>
+
 class ImageData;
 
 class WhiteNoise
 {
 public:
+    enum class Hash
+    {
+        kMd5,
+        kPcg,
+        kPhilox,
+    };
+
     struct Parameters
-    {};
+    {
+        Hash hash;
+    };
 
     static void GenerateSimple(const Parameters& parameters, ImageData& data);
     static void GenerateWang(const Parameters& parameters, ImageData& data);
+
+    // The four words hash maps (x, y, z, w) and key to, computed one pixel at a time.
+    static void HashWords(Hash hash, const u32* input, u32 key, u32* output);
+    // Lane counts of the paths compiled in, starting with 1 for the scalar one. GenerateSimple uses the last.
+    static std::vector<u32> GetLaneCounts();
+    // Writes row y of an image width pixels wide the way GenerateSimple does, laneCount pixels at a time.
+    static void GenerateRow(Hash hash, u32 laneCount, u32 y, u32 width, f32* row);
 };
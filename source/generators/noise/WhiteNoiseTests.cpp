@@ -0,0 +1,111 @@
+#include "WhiteNoise.hpp"
+
+#include "image/ImageData.hpp"
+
+#include "testing/TestFixture.hpp"
+#include "testing/TestRunner.hpp"
+#include "testing/TestSuite.hpp"
+
+#include <algorithm>
+#include <vector>
+
+// Category 1: Hashes
+// 1.1: Philox-4x32-10 matches the Random123 known-answer vector for counter 0 and key 0
+// 1.2: pcg4d matches the reference implementation, with the key mixed into the input
+// 1.3: MD5 images keep the pixels of the scalar generator of earlier versions, so existing assets do not change
+// Category 2: Lanes
+// 2.1: Every compiled lane count writes the same rows as the scalar path, also in the partial last group of a row
+
+struct WhiteNoiseFixture
+{
+	virtual ~WhiteNoiseFixture() = default;
+
+	static bool HashesTo(WhiteNoise::Hash hash, const u32 (&input)[4], u32 key, const u32 (&expected)[4])
+	{
+		u32 output[4];
+		WhiteNoise::HashWords(hash, input, key, output);
+		return output[0] == expected[0] && output[1] == expected[1] && output[2] == expected[2] && output[3] == expected[3];
+	}
+};
+
+// Category 1: Hashes
+TEST_SUITE(WhiteNoise_Hashes)
+{
+	// 1.1: Philox-4x32-10 matches the Random123 known-answer vector for counter 0 and key 0
+	TEST_FIXTURE(WhiteNoiseFixture, ZeroCounter_Philox_MatchesRandom123)
+	{
+		Check(HashesTo(WhiteNoise::Hash::kPhilox, { 0, 0, 0, 0 }, 0, { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 }));
+	}
+
+	// 1.2: pcg4d matches the reference implementation, with the key mixed into the input
+	TEST_FIXTURE(WhiteNoiseFixture, FixedInputs_Pcg_MatchesReference)
+	{
+		Check(HashesTo(WhiteNoise::Hash::kPcg, { 0, 0, 0, 0 }, 0, { 0x0f02f829, 0x2d568769, 0x32b0c43b, 0xd32548ea }));
+		Check(HashesTo(WhiteNoise::Hash::kPcg, { 1, 2, 3, 4 }, 7, { 0xa682c52a, 0x7867e4ce, 0xaa9341f3, 0xf2a3e345 }));
+	}
+
+	// 1.3: MD5 images keep the pixels of the scalar generator of earlier versions, so existing assets do not change
+	TEST_FIXTURE(WhiteNoiseFixture, Md5Pixels_GenerateSimple_MatchEarlierVersions)
+	{
+		static constexpr u32 kSize = 256;
+		// Pixels and first hash words written by the generator before it had vector paths.
+		struct KnownPixel
+		{
+			u32 x;
+			u32 y;
+			u32 word;
+			f32 value;
+		};
+		const KnownPixel knownPixels[] = {
+			{ 0, 0, 0xb4fbe0b1, 0.706968367f },
+			{ 1, 0, 0xfec212f4, 0.995148838f },
+			{ 5, 3, 0xe1511569, 0.880143464f },
+			{ 36, 2, 0x14b8badb, 0.0809437558f },
+			{ 255, 255, 0x784f292b, 0.469957888f },
+		};
+
+		ImageData image(kSize, kSize, 1, false);
+		WhiteNoise::GenerateSimple({ WhiteNoise::Hash::kMd5 }, image);
+
+		const f32* pixels = image.GetPixels(0);
+		for (const KnownPixel& known : knownPixels)
+		{
+			const u32 input[4] = { known.x, known.y, 0, 0 };
+			u32 output[4];
+			WhiteNoise::HashWords(WhiteNoise::Hash::kMd5, input, 0, output);
+			CheckEqual(output[0], known.word);
+			CheckEqual(pixels[known.y * kSize + known.x], known.value);
+		}
+	}
+}
+
+// Category 2: Lanes
+TEST_SUITE(WhiteNoise_Lanes)
+{
+	// 2.1: Every compiled lane count writes the same rows as the scalar path, also in the partial last group of a row
+	TEST_FIXTURE(WhiteNoiseFixture, OddWidth_GenerateRow_MatchesScalar)
+	{
+		// Not a multiple of any lane count, so every wide path ends a row with a partial group.
+		static constexpr u32 kWidth = 37;
+		static constexpr u32 kRowCount = 4;
+
+		const std::vector<u32> laneCounts = WhiteNoise::GetLaneCounts();
+		CheckEqual(laneCounts.front(), 1u);
+		for (WhiteNoise::Hash hash : { WhiteNoise::Hash::kMd5, WhiteNoise::Hash::kPcg, WhiteNoise::Hash::kPhilox })
+		{
+			for (u32 y = 0; y < kRowCount; ++y)
+			{
+				std::vector<f32> expected(kWidth);
+				WhiteNoise::GenerateRow(hash, 1, y, kWidth, expected.data());
+				for (u32 laneCount : laneCounts)
+				{
+					// A sentinel past the row catches stores that overrun it.
+					std::vector<f32> row(kWidth + 1, -1.0f);
+					WhiteNoise::GenerateRow(hash, laneCount, y, kWidth, row.data());
+					Check(std::equal(expected.begin(), expected.end(), row.begin()));
+					CheckEqual(row[kWidth], -1.0f);
+				}
+			}
+		}
+	}
+}
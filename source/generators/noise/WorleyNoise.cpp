@@ -2,11 +2,15 @@
 
 #include "IndexProviders.hpp"
 
+#include "generators/NoiseCommon.hpp"
 #include "image/ImageData.hpp"
+#include "utility/Profiler.hpp"
 #include "utility/Random.hpp"
+#include "utility/ThreadPool.hpp"
 
 #include <cassert>
 #include <cmath>
+#include <vector>
 
 struct Result
 {
@@ -32,26 +36,140 @@ struct Result
     }
 };
 
+// Feature points of one row of cells. Every cell is generated once and then shared by all pixels that see it.
+struct CellRow
+{
+    i32 cellY = 0;
+    bool isValid = false;
+    std::vector<u32> firstPoints;
+    std::vector<f32> pointsX;
+    std::vector<f32> pointsY;
+    std::vector<u32> pointIds;
+};
+
+// Rolling cache of the three cell rows that the pixels of a row sample.
 template<class IndexProvider>
-struct NoiseSampler
+struct CellCache
 {
-    void SampleCell(Result& result, const IndexProvider& indexProvider, const WorleyNoise::Parameters& parameters, i32 i, i32 j, f32 x, f32 y)
+    CellCache(const IndexProvider& provider, const WorleyNoise::Parameters& noiseParameters, i32 lastCellX)
+        : indexProvider(provider)
+        , parameters(noiseParameters)
+        , columnCount(static_cast<u32>(lastCellX) + 3)
     {
-        u32 index = parameters.cellIndexOffset + indexProvider(i, j);
-        Random generator(index);
+    }
+
+    const CellRow& Get(i32 cellY)
+    {
+        // Rows start at -1, so the slot index is never negative.
+        CellRow& row = rows[static_cast<u32>(cellY + 3) % 3];
+        if (!row.isValid || row.cellY != cellY)
+            Build(row, cellY);
+        return row;
+    }
 
-        u32 pointCount = generator.Uniform(parameters.minPointsPerCell, parameters.maxPointsPerCell);
+private:
+    void Build(CellRow& row, i32 cellY)
+    {
+        row.cellY = cellY;
+        row.isValid = true;
+        row.firstPoints.clear();
+        row.pointsX.clear();
+        row.pointsY.clear();
+        row.pointIds.clear();
 
-        for (u32 point = 0; point < pointCount; ++point)
+        const u32 idStride = parameters.cellsPerRow * parameters.cellsPerRow;
+        for (u32 column = 0; column < columnCount; ++column)
         {
-            f32 xi = x - generator.Uniform();
-            f32 yi = y - generator.Uniform();
+            i32 cellX = static_cast<i32>(column) - 1;
+            u32 index = parameters.cellIndexOffset + indexProvider(cellX, cellY);
+            Random generator(index);
+
+            u32 pointCount = generator.Uniform(parameters.minPointsPerCell, parameters.maxPointsPerCell);
 
-            result.update(xi * xi + yi * yi, index + point * parameters.cellsPerRow * parameters.cellsPerRow);
+            row.firstPoints.push_back(static_cast<u32>(row.pointsX.size()));
+            for (u32 point = 0; point < pointCount; ++point)
+            {
+                row.pointsX.push_back(generator.Uniform());
+                row.pointsY.push_back(generator.Uniform());
+                row.pointIds.push_back(index + point * idStride);
+            }
         }
+        row.firstPoints.push_back(static_cast<u32>(row.pointsX.size()));
     }
 
-    void operator ()(const IndexProvider& indexProvider, const WorleyNoise::Parameters& parameters, f32 x, f32 y, f32& outR, f32& outG, f32& outB)
+    const IndexProvider& indexProvider;
+    const WorleyNoise::Parameters& parameters;
+    u32 columnCount;
+    CellRow rows[3];
+};
+
+// Feature points of the three layers of cells that the pixels of a volume slice sample, stored cell by cell in index
+// order. Every cell of the layers is generated once for the slice.
+struct CellLayers
+{
+    CellLayers(const VolumeTilingIndexProvider& indexProvider, const WorleyNoise::Parameters& parameters, i32 centerLayer)
+        : layer(centerLayer)
+        , cellsPerRow(parameters.cellsPerRow)
+    {
+        const u32 idStride = parameters.cellsPerRow * parameters.cellsPerRow * parameters.cellLayers;
+        for (i32 k = -1; k < 2; ++k)
+        {
+            for (u32 j = 0; j < cellsPerRow; ++j)
+            {
+                for (u32 i = 0; i < cellsPerRow; ++i)
+                {
+                    u32 index = parameters.cellIndexOffset + indexProvider(static_cast<i32>(i), static_cast<i32>(j), layer + k);
+                    Random generator(index);
+
+                    u32 pointCount = generator.Uniform(parameters.minPointsPerCell, parameters.maxPointsPerCell);
+
+                    firstPoints.push_back(static_cast<u32>(pointsX.size()));
+                    for (u32 point = 0; point < pointCount; ++point)
+                    {
+                        pointsX.push_back(generator.Uniform());
+                        pointsY.push_back(generator.Uniform());
+                        pointsZ.push_back(generator.Uniform());
+                        pointIds.push_back(index + point * idStride);
+                    }
+                }
+            }
+        }
+        firstPoints.push_back(static_cast<u32>(pointsX.size()));
+    }
+
+    // Cell (i, j) of layer layer + k, with i and j wrapped around the row.
+    u32 GetCell(i32 i, i32 j, i32 k) const
+    {
+        const u32 mask = cellsPerRow - 1;
+        return ((static_cast<u32>(k + 1) * cellsPerRow + (static_cast<u32>(j) & mask)) * cellsPerRow) + (static_cast<u32>(i) & mask);
+    }
+
+    i32 layer;
+    u32 cellsPerRow;
+    std::vector<u32> firstPoints;
+    std::vector<f32> pointsX;
+    std::vector<f32> pointsY;
+    std::vector<f32> pointsZ;
+    std::vector<u32> pointIds;
+};
+
+struct NoiseSampler
+{
+    void SampleCell(Result& result, const CellRow& row, i32 i, f32 x, f32 y)
+    {
+        u32 column = static_cast<u32>(i + 1);
+        u32 end = row.firstPoints[column + 1];
+        for (u32 point = row.firstPoints[column]; point < end; ++point)
+        {
+            f32 xi = x - row.pointsX[point];
+            f32 yi = y - row.pointsY[point];
+
+            result.update(xi * xi + yi * yi, row.pointIds[point]);
+        }
+    }
+
+    template<class IndexProvider>
+    void operator ()(CellCache<IndexProvider>& cache, const WorleyNoise::Parameters& parameters, f32 x, f32 y, f32& outR, f32& outG, f32& outB)
     {
         f32 scaledX = x / parameters.cellSize;
         f32 scaledY = y / parameters.cellSize;
@@ -65,12 +183,96 @@ struct NoiseSampler
         result.f0 *= result.f0;
         result.f1 = result.f0;
 
+        for (i32 j = -1; j < 2; ++j)
+        {
+            const CellRow& row = cache.Get(iy + j);
+            for (i32 i = -1; i < 2; ++i)
+                SampleCell(result, row, ix + i, fx - static_cast<f32>(i), fy - static_cast<f32>(j));
+        }
+
+        Shade(result, parameters, outR, outG, outB);
+    }
+
+    // Generates the feature points of every cell on the spot, in the order CellCache stores them, so no cache is needed.
+    template<class IndexProvider>
+    void operator ()(const IndexProvider& indexProvider, const WorleyNoise::Parameters& parameters, f32 x, f32 y, f32& outR, f32& outG, f32& outB)
+    {
+        f32 scaledX = x / parameters.cellSize;
+        f32 scaledY = y / parameters.cellSize;
+        f32 fx = scaledX - floorf(scaledX);
+        f32 fy = scaledY - floorf(scaledY);
+        i32 ix = static_cast<i32>(floorf(scaledX));
+        i32 iy = static_cast<i32>(floorf(scaledY));
+
+        Result result;
+        result.f0 = parameters.cellSize * 2.0f;
+        result.f0 *= result.f0;
+        result.f1 = result.f0;
+
+        const u32 idStride = parameters.cellsPerRow * parameters.cellsPerRow;
         for (i32 j = -1; j < 2; ++j)
         {
             for (i32 i = -1; i < 2; ++i)
-                SampleCell(result, indexProvider, parameters, ix + i, iy + j, fx - static_cast<f32>(i), fy - static_cast<f32>(j));
+            {
+                u32 index = parameters.cellIndexOffset + indexProvider(ix + i, iy + j);
+                Random generator(index);
+
+                u32 pointCount = generator.Uniform(parameters.minPointsPerCell, parameters.maxPointsPerCell);
+                for (u32 point = 0; point < pointCount; ++point)
+                {
+                    f32 xi = fx - static_cast<f32>(i) - generator.Uniform();
+                    f32 yi = fy - static_cast<f32>(j) - generator.Uniform();
+
+                    result.update(xi * xi + yi * yi, index + point * idStride);
+                }
+            }
         }
 
+        Shade(result, parameters, outR, outG, outB);
+    }
+
+    // Samples the 3x3x3 cells around a pixel of the slice that layers were generated for.
+    void operator ()(const CellLayers& layers, const WorleyNoise::Parameters& parameters, f32 x, f32 y, f32 z, f32& outR, f32& outG, f32& outB)
+    {
+        f32 scaledX = x / parameters.cellSize;
+        f32 scaledY = y / parameters.cellSize;
+        f32 scaledZ = z / parameters.cellSize;
+        f32 fx = scaledX - floorf(scaledX);
+        f32 fy = scaledY - floorf(scaledY);
+        f32 fz = scaledZ - floorf(scaledZ);
+        i32 ix = static_cast<i32>(scaledX);
+        i32 iy = static_cast<i32>(scaledY);
+
+        Result result;
+        result.f0 = parameters.cellSize * 2.0f;
+        result.f0 *= result.f0;
+        result.f1 = result.f0;
+
+        for (i32 k = -1; k < 2; ++k)
+        {
+            for (i32 j = -1; j < 2; ++j)
+            {
+                for (i32 i = -1; i < 2; ++i)
+                {
+                    u32 cell = layers.GetCell(ix + i, iy + j, k);
+                    u32 end = layers.firstPoints[cell + 1];
+                    for (u32 point = layers.firstPoints[cell]; point < end; ++point)
+                    {
+                        f32 xi = fx - static_cast<f32>(i) - layers.pointsX[point];
+                        f32 yi = fy - static_cast<f32>(j) - layers.pointsY[point];
+                        f32 zi = fz - static_cast<f32>(k) - layers.pointsZ[point];
+
+                        result.update(xi * xi + yi * yi + zi * zi, layers.pointIds[point]);
+                    }
+                }
+            }
+        }
+
+        Shade(result, parameters, outR, outG, outB);
+    }
+
+    void Shade(const Result& result, const WorleyNoise::Parameters& parameters, f32& outR, f32& outG, f32& outB)
+    {
         Random generator(result.i0);
         float multiplier = 1.0f - result.f0 / result.f1;
         outR = fmaf(generator.Uniform(), parameters.rMul, parameters.rAdd) * multiplier;
@@ -91,10 +293,64 @@ void WorleyNoise::GenerateWang(const Parameters& parameters, ImageData& data)
     Generate(indexProvider, parameters, data);
 }
 
+void WorleyNoise::Evaluate(const Parameters& parameters, const f32* xs, const f32* ys, f32* out, size_t n)
+{
+    SimpleTilingIndexProvider indexProvider(parameters.cellsPerRow);
+    NoiseSampler sampler;
+    const f32 period = static_cast<f32>(parameters.cellsPerRow) * parameters.cellSize;
+    for (size_t k = 0; k < n; ++k)
+    {
+        f32 x = wrapCoordinate(xs[k], period);
+        f32 y = wrapCoordinate(ys[k], period);
+        // Distances to NaN never win a comparison, so the sampler would shade a point that has no cell.
+        if (std::isnan(x) || std::isnan(y))
+            out[k * 4] = out[k * 4 + 1] = out[k * 4 + 2] = NAN;
+        else
+            sampler(indexProvider, parameters, x, y, out[k * 4], out[k * 4 + 1], out[k * 4 + 2]);
+        out[k * 4 + 3] = 1.0f;
+    }
+}
+
+void WorleyNoise::GenerateSlice(const Parameters& parameters, u32 z, ImageData& data)
+{
+    PROFILE_SCOPE_BYTES("pixels", data.GetByteCount());
+
+    assert(data.GetMipLevelCount() == 1);
+
+    const u32 w = data.GetWidth();
+    const u32 h = data.GetHeight();
+    const f32 sliceZ = static_cast<f32>(z);
+    VolumeTilingIndexProvider indexProvider(parameters.cellsPerRow, parameters.cellLayers);
+    CellLayers layers(indexProvider, parameters, static_cast<i32>(sliceZ / parameters.cellSize));
+    NoiseSampler sampler;
+
+    f32* pixels = data.GetPixels(0);
+    ThreadPool::Instance().ParallelFor(h, [&](u32 begin, u32 end)
+    {
+        u64 index = static_cast<u64>(begin) * w * 4;
+        f32 r;
+        f32 g;
+        f32 b;
+        for (u32 y = begin; y < end; ++y)
+        {
+            for (u32 x = 0; x < w; ++x)
+            {
+                sampler(layers, parameters, static_cast<f32>(x), static_cast<f32>(y), sliceZ, r, g, b);
+                pixels[index++] = r;
+                pixels[index++] = g;
+                pixels[index++] = b;
+                pixels[index++] = 1.0f;
+            }
+        }
+    });
+}
+
 template<class IndexProvider>
 void WorleyNoise::Generate(const IndexProvider& indexProvider, const Parameters& parameters, ImageData& data)
 {
-    NoiseSampler<IndexProvider> sampler;
+    PROFILE_SCOPE_BYTES("pixels", data.GetByteCount());
+
+    NoiseSampler sampler;
 
     u32 mips = data.GetMipLevelCount();
     u32 width = data.GetWidth();
@@ -110,21 +366,33 @@ void WorleyNoise::Generate(const IndexProvider& indexProvider, const Parameters&
 
         f32* pixels = data.GetPixels(mip);
 
-        u32 index = 0;
-        f32 r;
-        f32 g;
-        f32 b;
-        for (u32 y = 0; y < h; ++y)
+        // Pixel positions grow with x, so the last column finds the rightmost cell.
+        i32 lastCellX = static_cast<i32>(static_cast<f32>(w - 1) * xScale / parameters.cellSize);
+
+        u32 firstRow;
+        u32 rowCount;
+        data.GetRows(mip, firstRow, rowCount);
+        ThreadPool::Instance().ParallelFor(rowCount, [&](u32 begin, u32 end)
         {
-            f32 fy = static_cast<f32>(y) * yScale;
-            for (u32 x = 0; x < w; ++x)
+            u32 yBegin = firstRow + begin;
+            u32 yEnd = firstRow + end;
+            CellCache<IndexProvider> cache(indexProvider, parameters, lastCellX);
+            u64 index = static_cast<u64>(begin) * w * 4;
+            f32 r;
+            f32 g;
+            f32 b;
+            for (u32 y = yBegin; y < yEnd; ++y)
             {
-                sampler(indexProvider, parameters, static_cast<f32>(x) * xScale, fy, r, g, b);
-                pixels[index++] = r;
-                pixels[index++] = g;
-                pixels[index++] = b;
-                pixels[index++] = 1.0f;
+                f32 fy = static_cast<f32>(y) * yScale;
+                for (u32 x = 0; x < w; ++x)
+                {
+                    sampler(cache, parameters, static_cast<f32>(x) * xScale, fy, r, g, b);
+                    pixels[index++] = r;
+                    pixels[index++] = g;
+                    pixels[index++] = b;
+                    pixels[index++] = 1.0f;
+                }
             }
-        }
+        });
     }
 }
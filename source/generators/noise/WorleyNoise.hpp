@@ -3,6 +3,8 @@
 #include "generators/TilingMode.hpp"
 #include "utility/Types.hpp"
 
+#include <cstddef>
+
 class ImageData;
 
 class WorleyNoise final
@@ -12,6 +14,8 @@ public:
     {
         u32 cellSize;
         u32 cellsPerRow;
+        // Cells along z of volumes, a power of 2 like cellsPerRow.
+        u32 cellLayers;
         u32 minPointsPerCell;
         u32 maxPointsPerCell;
         u32 cellIndexOffset;
@@ -25,6 +29,14 @@ public:
 
     static void GenerateSimple(const Parameters& parameters, ImageData& data);
     static void GenerateWang(const Parameters& parameters, ImageData& data);
+    // Samples the noise of GenerateSimple at n points given in pixels of the top mip level, so that it repeats every
+    // cellsPerRow cells. Writes RGBA like the image, out holds 4 * n values. Points are wrapped into the first period,
+    // so any finite coordinate is valid. A NaN coordinate gives NaN colour channels.
+    static void Evaluate(const Parameters& parameters, const f32* xs, const f32* ys, f32* out, size_t n);
+    // Fills data with slice z of a volume of cubic cells that repeats every cellsPerRow x cellsPerRow x cellLayers cells.
+    // Only the three layers of cells around the slice are generated, so a volume can be generated and written a slice at
+    // a time.
+    static void GenerateSlice(const Parameters& parameters, u32 z, ImageData& data);
 
 private:
     template<class IndexProvider>
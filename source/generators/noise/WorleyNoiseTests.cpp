@@ -0,0 +1,111 @@
+#include "WorleyNoise.hpp"
+
+#include "image/ImageData.hpp"
+
+#include "testing/NoiseFixture.hpp"
+#include "testing/TestFixture.hpp"
+#include "testing/TestRunner.hpp"
+#include "testing/TestSuite.hpp"
+
+#include <cmath>
+#include <vector>
+
+// Category 1: Evaluate
+// 1.1: Points at the pixels of the top mip level evaluate to the pixels of GenerateSimple
+// 1.2: Points a period apart evaluate to the same colour
+// 1.3: Far points evaluate to colours of the pattern, NaN points to NaN
+// Category 2: GenerateSlice
+// 2.1: The last slice of a volume continues into slice 0 as smoothly as slices continue into the next one
+// 2.2: A slice continues from its last column into its first and from its last row into its first
+
+struct WorleyNoiseFixture
+	: public NoiseFixture
+{
+	static constexpr u32 kSize = 64;
+
+	// kSize / cellSize cells per row, so images repeat like Evaluate.
+	WorleyNoise::Parameters parameters = { 16, 4, 4, 1, 3, 1, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+	std::vector<f32> xs;
+	std::vector<f32> ys;
+
+	std::vector<f32> Evaluate() const
+	{
+		std::vector<f32> colours(xs.size() * 4);
+		WorleyNoise::Evaluate(parameters, xs.data(), ys.data(), colours.data(), xs.size());
+		return colours;
+	}
+
+	// cellLayers * cellSize slices.
+	std::vector<f32> GenerateSlice(u32 z) const
+	{
+		ImageData image(kSize, kSize, 4, false);
+		WorleyNoise::GenerateSlice(parameters, z, image);
+		return std::vector<f32>(image.GetPixels(0), image.GetPixels(0) + kSize * kSize * 4);
+	}
+};
+
+// Category 1: Evaluate
+TEST_SUITE(WorleyNoise_Evaluate)
+{
+	// 1.1: Points at the pixels of the top mip level evaluate to the pixels of GenerateSimple
+	TEST_FIXTURE(WorleyNoiseFixture, PixelPoints_Evaluate_MatchesGenerateSimple)
+	{
+		ImageData image(kSize, kSize, 4, false);
+		WorleyNoise::GenerateSimple(parameters, image);
+		AddPixels(kSize, kSize, 1.0f, 1.0f, xs, ys);
+
+		CheckEqual(CountMismatches(Evaluate(), image.GetPixels(0)), 0u);
+	}
+
+	// 1.2: Points a period apart evaluate to the same colour
+	TEST_FIXTURE(WorleyNoiseFixture, ShiftedByPeriod_Evaluate_SameColours)
+	{
+		AddPixels(kSize, kSize, 1.0f, 1.0f, xs, ys);
+		const std::vector<f32> expected = Evaluate();
+		ShiftByPeriods(static_cast<f32>(kSize), static_cast<f32>(kSize), xs, ys);
+
+		CheckEqual(CountMismatches(Evaluate(), expected.data()), 0u);
+	}
+
+	// 1.3: Far points evaluate to colours of the pattern, NaN points to NaN
+	TEST_FIXTURE(WorleyNoiseFixture, FarAndNaNPoints_Evaluate_WrappedOrNaN)
+	{
+		xs = { 1e30f, -1e30f, NAN };
+		ys = { 20.0f, 20.0f, 20.0f };
+		const std::vector<f32> colours = Evaluate();
+
+		// 1e30 is a multiple of the period, so the far points land on their counterpart at 0.
+		xs = { 0.0f };
+		ys = { 20.0f };
+		const std::vector<f32> expected = Evaluate();
+		CheckEqual(CountMismatches(std::vector<f32>(colours.begin(), colours.begin() + 4), expected.data()), 0u);
+		CheckEqual(CountMismatches(std::vector<f32>(colours.begin() + 4, colours.begin() + 8), expected.data()), 0u);
+		Check(std::isnan(colours[8]) && std::isnan(colours[9]) && std::isnan(colours[10]));
+		CheckEqual(colours[11], 1.0f);
+	}
+}
+
+// Category 2: GenerateSlice
+TEST_SUITE(WorleyNoise_GenerateSlice)
+{
+	// 2.1: The last slice of a volume continues into slice 0 as smoothly as slices continue into the next one
+	TEST_FIXTURE(WorleyNoiseFixture, LastSlice_GenerateSlice_ContinuesIntoFirst)
+	{
+		const u32 depth = parameters.cellLayers * parameters.cellSize;
+
+		Check(IsSeamless(GetSliceSteps(depth, [&](u32 z) { return GenerateSlice(z); })));
+	}
+
+	// 2.2: A slice continues from its last column into its first and from its last row into its first
+	TEST_FIXTURE(WorleyNoiseFixture, Slice_GenerateSlice_TilesInXAndY)
+	{
+		const std::vector<f32> slice = GenerateSlice(parameters.cellSize + 5);
+		std::vector<f64> columnSteps;
+		std::vector<f64> rowSteps;
+		// The alpha channel is always 1.
+		GetColumnAndRowSteps(slice, kSize, kSize, 4, 3, columnSteps, rowSteps);
+
+		Check(IsSeamless(columnSteps));
+		Check(IsSeamless(rowSteps));
+	}
+}
@@ -1,7 +1,9 @@
 #include "Checker.hpp"
 
 #include "image/ImageData.hpp"
+#include "utility/Profiler.hpp"
 #include "utility/Random.hpp"
+#include "utility/ThreadPool.hpp"
 
 #include <cassert>
 #include <iostream>
@@ -45,6 +47,8 @@ void Checker::GenerateWang(const Parameters& parameters, ImageData& data)
 
 void Checker::Generate(const Parameters& parameters, ImageData& data)
 {
+    PROFILE_SCOPE_BYTES("pixels", data.GetByteCount());
+
     u32 mips = data.GetMipLevelCount();
 
     u32 w = data.GetWidth();
@@ -85,31 +89,41 @@ void Checker::Generate(const Parameters& parameters, ImageData& data)
 
         if (tileWidth > 0 && tileHeight > 0)
         {
-            u32 yCounter = 0;
-            u32 tileIndex = 0;
-
-            for (u32 j = 0; j < h; ++j)
+            const u32 tilesPerRow = w / tileWidth;
+            u32 firstRow;
+            u32 rowCount;
+            data.GetRows(mip, firstRow, rowCount);
+            ThreadPool::Instance().ParallelFor(rowCount, [&](u32 begin, u32 end)
             {
-                u32 xCounter = 0;
-                u32 tile = tileIndex;
-                for (u32 i = 0; i < w; ++i)
+                u32 yBegin = firstRow + begin;
+                u32 yEnd = firstRow + end;
+                f32* rowPixels = pixels + static_cast<u64>(begin) * w * pixelSize;
+                u32 yCounter = yBegin % tileHeight;
+                u32 tileIndex = (yBegin / tileHeight) * tilesPerRow;
+
+                for (u32 j = yBegin; j < yEnd; ++j)
                 {
-                    *pixels = tiles[tileIndex];
-                    pixels += pixelSize;
-                    ++xCounter;
-                    if (xCounter == tileWidth)
+                    u32 xCounter = 0;
+                    u32 tile = tileIndex;
+                    for (u32 i = 0; i < w; ++i)
                     {
-                        xCounter = 0;
-                        ++tileIndex;
+                        *rowPixels = tiles[tileIndex];
+                        rowPixels += pixelSize;
+                        ++xCounter;
+                        if (xCounter == tileWidth)
+                        {
+                            xCounter = 0;
+                            ++tileIndex;
+                        }
                     }
-                }
 
-                ++yCounter;
-                if (yCounter == tileHeight)
-                    yCounter = 0;
-                else
-                    tileIndex = tile;
-            }
+                    ++yCounter;
+                    if (yCounter == tileHeight)
+                        yCounter = 0;
+                    else
+                        tileIndex = tile;
+                }
+            });
         }
         else
         {
@@ -1,6 +1,8 @@
 #include "ChannelConversion.hpp"
 #include "ImageData.hpp"
 
+#include "utility/Profiler.hpp"
+
 #include <cassert>
 
 typedef void (*ConverterFunction)(const f32*, f32*, u32);
@@ -73,5 +75,6 @@ void ChannelConverter::RToRRR1(const ImageData& source, ImageData& destination)
 {
     assert(destination.GetChannelCount() == 4);
     assert(source.GetChannelCount() == 1);
+    PROFILE_SCOPE_BYTES("expand channels", destination.GetByteCount());
     DoConversion(source, destination, ::RToRRR1);
 }
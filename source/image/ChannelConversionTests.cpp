@@ -6,6 +6,8 @@
 #include "testing/TestRunner.hpp"
 #include "testing/TestSuite.hpp"
 
+#include <cmath>
+
 // Category 1: Channel conversion
 // 1.1: R expanded to RRR1 with mips
 // 1.2: RG expanded to RG01 with mips
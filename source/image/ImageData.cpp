@@ -1,13 +1,26 @@
 #include "ImageData.hpp"
 
 #include "format/TGAFileFormat.hpp"
+#include "utility/Memory.hpp"
+#include "utility/Profiler.hpp"
+#include "utility/Simd.hpp"
+#include "utility/ThreadPool.hpp"
 
 #include <cassert>
 #include <cmath>
+#include <cstring>
 #include <sstream>
 
-ImageData::ImageData(u32 mip0Width, u32 mip0Height, u32 numChannels, bool generateMipChain)
-    : width(mip0Width)
+static constexpr u64 kMipAlignment = Memory::kCacheLineSize / sizeof(f32);
+
+static u64 alignMipOffset(u64 offset)
+{
+    return (offset + kMipAlignment - 1) / kMipAlignment * kMipAlignment;
+}
+
+ImageData::ImageData(u32 mip0Width, u32 mip0Height, u32 numChannels, bool generateMipChain, bool clearPixels)
+    : pixels(nullptr)
+    , width(mip0Width)
     , height(mip0Height)
     , channels(numChannels)
 {
@@ -15,12 +28,13 @@ ImageData::ImageData(u32 mip0Width, u32 mip0Height, u32 numChannels, bool genera
 
     u32 w = width;
     u32 h = height;
+    u64 elementCount = 0;
 
     bool first = true;
     while ((first || generateMipChain) && (w > 1 || h > 1))
     {
-        u32 elementCount = channels * w * h;
-        mipLevels.emplace_back(elementCount, 0.0f);
+        mipOffsets.push_back(elementCount);
+        elementCount = alignMipOffset(elementCount + static_cast<u64>(channels) * w * h);
 
         first = false;
         w >>= 1;
@@ -29,15 +43,122 @@ ImageData::ImageData(u32 mip0Width, u32 mip0Height, u32 numChannels, bool genera
         h = h > 0 ? h : 1;
     }
     // Add last mip
-    if (generateMipChain)
+    if (generateMipChain || mipOffsets.empty())
     {
-        u32 elementCount = channels;
-        mipLevels.emplace_back(elementCount, 0.0f);
+        mipOffsets.push_back(elementCount);
+        elementCount = alignMipOffset(elementCount + channels);
     }
+
+    u64 size = elementCount * sizeof(f32);
+    pixels = static_cast<f32*>(Memory::Allocate(size));
+    assert(pixels != nullptr);
+
+    if (clearPixels)
+        memset(pixels, 0, size);
+}
+
+ImageData::ImageData(u32 mip0Width, u32 mip0Height, u32 numChannels, u32 maxStripHeight, StripTag)
+    : pixels(nullptr)
+    , width(mip0Width)
+    , height(mip0Height)
+    , channels(numChannels)
+    , stripHeight(maxStripHeight < mip0Height ? maxStripHeight : mip0Height)
+    , isStrip(true)
+{
+    assert(width > 0 && height > 0 && stripHeight > 0);
+
+    mipOffsets.push_back(0);
+    pixels = static_cast<f32*>(Memory::Allocate(static_cast<u64>(channels) * width * stripHeight * sizeof(f32)));
+    assert(pixels != nullptr);
+}
+
+ImageData::~ImageData()
+{
+    Memory::Free(pixels);
+}
+
+ImageData* ImageData::CreateStrip(u32 width, u32 height, u32 channels, u32 stripHeight)
+{
+    return new ImageData(width, height, channels, stripHeight, StripTag());
+}
+
+// Bilinear interpolation with 0.5 as weights:
+// (p[x, y] + p[x + 1, y] + p[x, y + 1] + p[x + 1, y + 1]) * 0.25
+// The specialized versions add in the same order, so all of them produce the same values.
+static void reduceRow(const f32* sourceRow, const f32* nextSourceRow, f32* destinationRow, u32 destinationWidth, u32 pixelSize)
+{
+    for (u32 x = 0; x < destinationWidth; ++x)
+    {
+        for (u32 c = 0; c < pixelSize; ++c)
+        {
+            u32 left = x * 2 * pixelSize + c;
+            u32 right = left + pixelSize;
+            f32 a = sourceRow[left] + sourceRow[right];
+            f32 b = nextSourceRow[left] + nextSourceRow[right];
+            destinationRow[x * pixelSize + c] = (a + b) * 0.25f;
+        }
+    }
+}
+
+static void reduceRowOneChannel(const f32* sourceRow, const f32* nextSourceRow, f32* destinationRow, u32 destinationWidth)
+{
+    u32 x = 0;
+#if NOISE_SIMD_AVX2
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+    for (; x + 8 <= destinationWidth; x += 8)
+    {
+        // Splitting 16 source pixels into even and odd ones mixes up the 128 bit halves, the final permute restores the order.
+        __m256 first = _mm256_loadu_ps(sourceRow + x * 2);
+        __m256 second = _mm256_loadu_ps(sourceRow + x * 2 + 8);
+        __m256 a = _mm256_add_ps(_mm256_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0)), _mm256_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1)));
+
+        first = _mm256_loadu_ps(nextSourceRow + x * 2);
+        second = _mm256_loadu_ps(nextSourceRow + x * 2 + 8);
+        __m256 b = _mm256_add_ps(_mm256_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0)), _mm256_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1)));
+
+        __m256 result = _mm256_mul_ps(_mm256_add_ps(a, b), quarter);
+        _mm256_storeu_ps(destinationRow + x, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(result), _MM_SHUFFLE(3, 1, 2, 0))));
+    }
+#endif
+    reduceRow(sourceRow + x * 2, nextSourceRow + x * 2, destinationRow + x, destinationWidth - x, 1);
+}
+
+static void reduceRowFourChannels(const f32* sourceRow, const f32* nextSourceRow, f32* destinationRow, u32 destinationWidth)
+{
+    u32 x = 0;
+#if NOISE_SIMD_AVX2
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+    for (; x + 2 <= destinationWidth; x += 2)
+    {
+        // Four source pixels per row, pairing the left and the right pixel of each block.
+        __m256 first = _mm256_loadu_ps(sourceRow + x * 8);
+        __m256 second = _mm256_loadu_ps(sourceRow + x * 8 + 8);
+        __m256 a = _mm256_add_ps(_mm256_permute2f128_ps(first, second, 0x20), _mm256_permute2f128_ps(first, second, 0x31));
+
+        first = _mm256_loadu_ps(nextSourceRow + x * 8);
+        second = _mm256_loadu_ps(nextSourceRow + x * 8 + 8);
+        __m256 b = _mm256_add_ps(_mm256_permute2f128_ps(first, second, 0x20), _mm256_permute2f128_ps(first, second, 0x31));
+
+        _mm256_storeu_ps(destinationRow + x * 4, _mm256_mul_ps(_mm256_add_ps(a, b), quarter));
+    }
+#endif
+    reduceRow(sourceRow + x * 8, nextSourceRow + x * 8, destinationRow + x * 4, destinationWidth - x, 4);
+}
+
+void ImageData::ReduceRow(const f32* sourceRow, const f32* nextSourceRow, f32* destinationRow, u32 destinationWidth, u32 channels)
+{
+    if (channels == 1)
+        reduceRowOneChannel(sourceRow, nextSourceRow, destinationRow, destinationWidth);
+    else if (channels == 4)
+        reduceRowFourChannels(sourceRow, nextSourceRow, destinationRow, destinationWidth);
+    else
+        reduceRow(sourceRow, nextSourceRow, destinationRow, destinationWidth, channels);
 }
 
 void ImageData::GenerateMips(u32 base)
 {
+    PROFILE_SCOPE_BYTES("mips", GetByteCount(base + 1));
+
     u32 mipLevelCount = GetMipLevelCount();
     for (u32 i = base + 1; i < mipLevelCount; ++i)
     {
@@ -48,11 +169,32 @@ void ImageData::GenerateMips(u32 base)
         GetDimensions(sourceWidth, sourceHeight, i - 1);
         GetDimensions(destinationWidth, destinationHeight, i);
 
-        u32 sourceIndex = 0;
+        // Levels that halve both dimensions exactly are reduced row by row on the thread pool.
+        if (sourceWidth == destinationWidth * 2 && sourceHeight == destinationHeight * 2)
+        {
+            const u32 pixelSize = GetChannelCount();
+            const u32 sourcePitch = sourceWidth * pixelSize;
+            const u32 destinationPitch = destinationWidth * pixelSize;
+            const f32* sourcePixels = GetPixels(i - 1);
+            f32* destinationPixels = GetPixels(i);
+
+            ThreadPool::Instance().ParallelFor(destinationHeight, [&](u32 yBegin, u32 yEnd)
+            {
+                for (u32 y = yBegin; y < yEnd; ++y)
+                {
+                    const f32* sourceRow = sourcePixels + static_cast<u64>(y) * 2 * sourcePitch;
+                    f32* destinationRow = destinationPixels + static_cast<u64>(y) * destinationPitch;
+                    ReduceRow(sourceRow, sourceRow + sourcePitch, destinationRow, destinationWidth, pixelSize);
+                }
+            });
+            continue;
+        }
+
+        u64 sourceIndex = 0;
         const u32 pixelSize = GetChannelCount();
-        const u32 sourcePitch = sourceWidth * pixelSize;
-        u32 nextSourceIndex = sourcePitch;
-        u32 destinationIndex = 0;
+        const u64 sourcePitch = static_cast<u64>(sourceWidth) * pixelSize;
+        u64 nextSourceIndex = sourcePitch;
+        u64 destinationIndex = 0;
 
         const f32* sourcePixels = GetPixels(i - 1);
         f32* destinationPixels = GetPixels(i);
@@ -94,25 +236,62 @@ void ImageData::GetDimensions(u32& outWidth, u32& outHeight, u32 mipLevel) const
     outHeight = outHeight > 0 ? outHeight : 1;
 }
 
+void ImageData::GetRows(u32 mipLevel, u32& outFirstRow, u32& outRowCount) const
+{
+    if (isStrip)
+    {
+        outFirstRow = stripFirstRow;
+        outRowCount = height - stripFirstRow < stripHeight ? height - stripFirstRow : stripHeight;
+        return;
+    }
+
+    u32 w;
+    GetDimensions(w, outRowCount, mipLevel);
+    outFirstRow = 0;
+}
+
+void ImageData::SetStrip(u32 firstRow)
+{
+    assert(isStrip && firstRow < height);
+    stripFirstRow = firstRow;
+}
+
+u64 ImageData::GetByteCount(u32 firstMipLevel) const
+{
+    u64 count = 0;
+    for (u32 mip = firstMipLevel; mip < GetMipLevelCount(); ++mip)
+    {
+        u32 w;
+        u32 h;
+        u32 firstRow;
+        u32 rowCount;
+        GetDimensions(w, h, mip);
+        GetRows(mip, firstRow, rowCount);
+        count += static_cast<u64>(w) * rowCount * channels * sizeof(f32);
+    }
+    return count;
+}
+
 u32 ImageData::GetMipLevelCount() const
 {
-    return static_cast<u32>(mipLevels.size());
+    return static_cast<u32>(mipOffsets.size());
 }
 
 f32* ImageData::GetPixels(u32 mipLevel)
 {
     assert(mipLevel < GetMipLevelCount());
-    return &mipLevels[mipLevel].front();
+    return pixels + mipOffsets[mipLevel];
 }
 
 const f32* ImageData::GetPixels(u32 mipLevel) const
 {
     assert(mipLevel < GetMipLevelCount());
-    return &mipLevels[mipLevel].front();
+    return pixels + mipOffsets[mipLevel];
 }
 
-void ImageData::Save(const std::string& baseFileName) const
+void ImageData::Save(const std::string& baseFileName, bool compress) const
 {
+    assert(!isStrip);
     u32 mipCount = GetMipLevelCount();
     if (mipCount > 1)
     {
@@ -122,7 +301,7 @@ void ImageData::Save(const std::string& baseFileName) const
         {
             std::stringstream s;
             s << baseFileName << "_mip" << i << ".tga";
-            TGAFileFormat::Save(GetPixels(i), w, h, channels, s.str());
+            TGAFileFormat::Save(GetPixels(i), w, h, channels, s.str(), compress);
 
             w >>= 1;
             h >>= 1;
@@ -132,6 +311,6 @@ void ImageData::Save(const std::string& baseFileName) const
     }
     else
     {
-        TGAFileFormat::Save(GetPixels(0), width, height, channels, baseFileName + ".tga");
+        TGAFileFormat::Save(GetPixels(0), width, height, channels, baseFileName + ".tga", compress);
     }
 }
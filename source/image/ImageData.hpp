@@ -5,33 +5,59 @@
 #include <vector>
 #include <string>
 
+// All mip levels live in a single block, every level starting on a cache line boundary.
 class ImageData
 {
 public:
     ImageData() = delete;
     ImageData(const ImageData&) = delete;
     ImageData(ImageData&&) = delete;
-    ImageData(u32 width, u32 height, u32 channels, bool generateMipChain);
-    ~ImageData() = default;
+    // Callers that write every pixel anyway can skip clearing the pixels to 0.
+    ImageData(u32 width, u32 height, u32 channels, bool generateMipChain, bool clearPixels = true);
+    ~ImageData();
+
+    // Holds a strip of at most stripHeight rows of the top level of a width x height image, for images that do not fit in memory.
+    // The strip starts at row 0, SetStrip moves it down. The pixels are not cleared. The caller deletes the image.
+    static ImageData* CreateStrip(u32 width, u32 height, u32 channels, u32 stripHeight);
 
     ImageData& operator =(const ImageData&) = delete;
     ImageData& operator =(ImageData&&) = delete;
 
-    void Save(const std::string& baseFileName) const;
+    void Save(const std::string& baseFileName, bool compress = false) const;
     void GetDimensions(u32& outWidth, u32& outHeight, u32 mipLevel) const;
     u32 GetWidth() const { return width; }
     u32 GetHeight() const { return height; }
     u32 GetMipLevelCount() const;
     u32 GetChannelCount() const { return channels; }
+    bool IsStrip() const { return isStrip; }
+
+    // Rows of a mip level held in memory: every row, or the rows of the current strip. GetPixels points at firstRow.
+    void GetRows(u32 mipLevel, u32& outFirstRow, u32& outRowCount) const;
+    // The strip ends after stripHeight rows or at the bottom of the image.
+    void SetStrip(u32 firstRow);
+    // Size of the pixels GetRows covers, summed over the levels from firstMipLevel on.
+    u64 GetByteCount(u32 firstMipLevel = 0) const;
 
     f32* GetPixels(u32 mipLevel);
     const f32* GetPixels(u32 mipLevel) const;
 
     void GenerateMips(u32 base);
 
+    // Averages 2x2 pixels of two rows into one row, the same way GenerateMips does.
+    static void ReduceRow(const f32* sourceRow, const f32* nextSourceRow, f32* destinationRow, u32 destinationWidth, u32 channels);
+
 private:
-    std::vector<std::vector<f32>> mipLevels;
+    // Keeps the strip constructor apart from the one taking generateMipChain, which a u32 would convert to.
+    struct StripTag {};
+
+    ImageData(u32 width, u32 height, u32 channels, u32 stripHeight, StripTag);
+
+    std::vector<u64> mipOffsets;
+    f32* pixels;
     u32 width;
     u32 height;
     u32 channels;
+    u32 stripFirstRow = 0;
+    u32 stripHeight = 0;
+    bool isStrip = false;
 };
@@ -4,6 +4,8 @@
 #include "testing/TestRunner.hpp"
 #include "testing/TestSuite.hpp"
 
+#include <cmath>
+
 // Category 1: Mim dimensions
 // 1.1: Square image, pow2, 3 mips
 // 1.2: Horizontal rectangle image, pow2, 3 mips
@@ -14,6 +16,14 @@
 // 2.1: One channel, two mips
 // 2.2: Two channels, two mips
 // 2.3: Two channels, three mips
+// 2.4: One channel, wide image, values match the 2x2 average exactly
+// 2.5: Four channels, wide image, values match the 2x2 average exactly
+// Category 3: Memory layout
+// 3.1: Odd sized image, every mip level starts on a cache line
+// 3.2: Cleared image, every pixel of every mip is 0
+// Category 4: Strips
+// 4.1: Whole image, rows of every mip level are held
+// 4.2: Strip at the bottom, row count ends with the image
 
 struct ImageDataFixture
 {
@@ -25,6 +35,41 @@ struct ImageDataFixture
 	ImageData* image = nullptr;
 	u32 mipWidth = 0;
 	u32 mipHeight = 0;
+
+	void FillMip0()
+	{
+		image->GetDimensions(mipWidth, mipHeight, 0);
+		f32* pixels = image->GetPixels(0);
+		u32 count = mipWidth * mipHeight * image->GetChannelCount();
+		for (u32 i = 0; i < count; ++i)
+			pixels[i] = static_cast<f32>((i * 7919) % 1000) * 0.001f;
+	}
+
+	bool Mip1MatchesAverage()
+	{
+		const u32 pixelSize = image->GetChannelCount();
+		image->GetDimensions(mipWidth, mipHeight, 0);
+		const u32 sourcePitch = mipWidth * pixelSize;
+		const f32* source = image->GetPixels(0);
+		const f32* generated = image->GetPixels(1);
+		image->GetDimensions(mipWidth, mipHeight, 1);
+
+		for (u32 y = 0; y < mipHeight; ++y)
+		{
+			for (u32 x = 0; x < mipWidth; ++x)
+			{
+				for (u32 c = 0; c < pixelSize; ++c)
+				{
+					u32 sourceIndex = y * 2 * sourcePitch + x * 2 * pixelSize + c;
+					f32 a = source[sourceIndex] + source[sourceIndex + pixelSize];
+					f32 b = source[sourceIndex + sourcePitch] + source[sourceIndex + sourcePitch + pixelSize];
+					if (generated[(y * mipWidth + x) * pixelSize + c] != (a + b) * 0.25f)
+						return false;
+				}
+			}
+		}
+		return true;
+	}
 };
 
 // Category 1: MIP dimensions
@@ -177,4 +222,84 @@ TEST_SUITE(ImageData_MipGeneration)
 		Check(fabsf(generated[0] - 0.15f) < 0.001f);
 		Check(fabsf(generated[1] - 0.16f) < 0.001f);
 	}
+
+	// 2.4: One channel, wide image, values match the 2x2 average exactly
+	TEST_FIXTURE(ImageDataFixture, OneChannelWideImage_GenerateMips_ValuesMatchAverage)
+	{
+		image = new ImageData(76, 8, 1, true);
+		FillMip0();
+
+		image->GenerateMips(0);
+
+		Check(Mip1MatchesAverage());
+	}
+
+	// 2.5: Four channels, wide image, values match the 2x2 average exactly
+	TEST_FIXTURE(ImageDataFixture, FourChannelsWideImage_GenerateMips_ValuesMatchAverage)
+	{
+		image = new ImageData(38, 8, 4, true);
+		FillMip0();
+
+		image->GenerateMips(0);
+
+		Check(Mip1MatchesAverage());
+	}
+}
+
+// Category 3: Memory layout
+TEST_SUITE(ImageData_MemoryLayout)
+{
+	// 3.1: Odd sized image, every mip level starts on a cache line
+	TEST_FIXTURE(ImageDataFixture, OddSizedImage_GetPixels_MipsAreAligned)
+	{
+		image = new ImageData(37, 19, 3, true, false);
+
+		for (u32 i = 0; i < image->GetMipLevelCount(); ++i)
+			Check(reinterpret_cast<u64>(image->GetPixels(i)) % 64 == 0);
+	}
+
+	// 3.2: Cleared image, every pixel of every mip is 0
+	TEST_FIXTURE(ImageDataFixture, ClearedImage_GetPixels_AllZero)
+	{
+		image = new ImageData(37, 19, 3, true);
+
+		for (u32 i = 0; i < image->GetMipLevelCount(); ++i)
+		{
+			image->GetDimensions(mipWidth, mipHeight, i);
+			const f32* pixels = image->GetPixels(i);
+			for (u32 j = 0; j < mipWidth * mipHeight * 3; ++j)
+				Check(pixels[j] == 0.0f);
+		}
+	}
+}
+
+// Category 4: Strips
+TEST_SUITE(ImageData_Strips)
+{
+	// 4.1: Whole image, rows of every mip level are held
+	TEST_FIXTURE(ImageDataFixture, WholeImage_GetRows_AllRows)
+	{
+		image = new ImageData(16, 8, 1, true);
+		u32 firstRow;
+		u32 rowCount;
+
+		image->GetRows(2, firstRow, rowCount);
+
+		Check(!image->IsStrip());
+		Check(firstRow == 0 && rowCount == 2);
+	}
+
+	// 4.2: Strip at the bottom, row count ends with the image
+	TEST_FIXTURE(ImageDataFixture, BottomStrip_GetRows_EndsWithImage)
+	{
+		image = ImageData::CreateStrip(16, 10, 4, 4);
+		u32 firstRow;
+		u32 rowCount;
+
+		image->SetStrip(8);
+		image->GetRows(0, firstRow, rowCount);
+
+		Check(image->IsStrip() && image->GetMipLevelCount() == 1);
+		Check(firstRow == 8 && rowCount == 2);
+	}
 }
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "utility/Types.hpp"
+
+#include <cmath>
+#include <vector>
+
+// Points and measurements shared by the fixtures of the noise generator tests.
+struct NoiseFixture
+{
+	virtual ~NoiseFixture() = default;
+
+	// Coordinates of every pixel of a width x height image, row by row, scaled to the units Evaluate takes.
+	static void AddPixels(u32 width, u32 height, f32 xScale, f32 yScale, std::vector<f32>& xs, std::vector<f32>& ys)
+	{
+		for (u32 y = 0; y < height; ++y)
+		{
+			for (u32 x = 0; x < width; ++x)
+			{
+				xs.push_back(static_cast<f32>(x) * xScale);
+				ys.push_back(static_cast<f32>(y) * yScale);
+			}
+		}
+	}
+
+	// Moves every point a period to the right and three periods up.
+	static void ShiftByPeriods(f32 periodX, f32 periodY, std::vector<f32>& xs, std::vector<f32>& ys)
+	{
+		for (size_t i = 0; i < xs.size(); ++i)
+		{
+			xs[i] += periodX;
+			ys[i] -= periodY * 3.0f;
+		}
+	}
+
+	static u32 CountMismatches(const std::vector<f32>& values, const f32* expected)
+	{
+		u32 mismatches = 0;
+		for (size_t i = 0; i < values.size(); ++i)
+			mismatches += values[i] != expected[i] ? 1 : 0;
+		return mismatches;
+	}
+
+	// steps[i] measures the change from position i to the next one, the last step wraps around to position 0. A seam
+	// would change as much as unrelated noise does, several times more than any step inside the period.
+	static bool IsSeamless(const std::vector<f64>& steps)
+	{
+		f64 largest = 0.0;
+		for (size_t i = 0; i + 1 < steps.size(); ++i)
+			largest = steps[i] > largest ? steps[i] : largest;
+		return steps.back() <= largest * 2.0;
+	}
+
+	// Change from every slice of a volume to the next one, generateSlice(z) returning the pixels of slice z.
+	template<class GenerateSlice>
+	static std::vector<f64> GetSliceSteps(u32 depth, GenerateSlice generateSlice)
+	{
+		std::vector<f64> steps;
+		const std::vector<f32> first = generateSlice(0);
+		std::vector<f32> previous = first;
+		for (u32 z = 1; z <= depth; ++z)
+		{
+			const std::vector<f32> slice = z < depth ? generateSlice(z) : first;
+			f64 step = 0.0;
+			for (size_t i = 0; i < slice.size(); ++i)
+				step += std::fabs(slice[i] - previous[i]);
+			steps.push_back(step);
+			previous = slice;
+		}
+		return steps;
+	}
+
+	// Change from every column of a slice to the next one and from every row to the next one, over the first
+	// measuredChannels channels of each pixel.
+	static void GetColumnAndRowSteps(const std::vector<f32>& slice, u32 width, u32 height, u32 channels, u32 measuredChannels,
+		std::vector<f64>& columnSteps, std::vector<f64>& rowSteps)
+	{
+		columnSteps.assign(width, 0.0);
+		rowSteps.assign(height, 0.0);
+		for (u32 y = 0; y < height; ++y)
+		{
+			for (u32 x = 0; x < width; ++x)
+			{
+				for (u32 channel = 0; channel < measuredChannels; ++channel)
+				{
+					const f32 value = slice[(y * width + x) * channels + channel];
+					columnSteps[x] += std::fabs(slice[(y * width + (x + 1) % width) * channels + channel] - value);
+					rowSteps[y] += std::fabs(slice[((y + 1) % height * width + x) * channels + channel] - value);
+				}
+			}
+		}
+	}
+};
@@ -1,5 +1,6 @@
 #include "ArgumentParser.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
@@ -14,6 +15,25 @@ u64 ArgumentParser::GetValue(const std::string& name) const
 	return argumentValues[it - begin];
 }
 
+const std::string& ArgumentParser::GetText(const std::string& name) const
+{
+	auto begin = argumentNames.begin();
+	auto end = argumentNames.end();
+	auto it = std::find(begin, end, name);
+	assert(it != end);
+	assert(takesText[it - begin]);
+	return textValues[it - begin];
+}
+
+bool ArgumentParser::IsText(const std::string& name) const
+{
+	auto begin = argumentNames.begin();
+	auto end = argumentNames.end();
+	auto it = std::find(begin, end, name);
+	assert(it != end);
+	return takesText[it - begin];
+}
+
 void ArgumentParser::AddKnownArgument(const std::string& name, const std::string& shortName, const ValidValues& knownValues,
 	const Descriptions& parameterDescriptions)
 {
@@ -28,6 +48,16 @@ void ArgumentParser::AddKnownArgument(const std::string& name, const std::string
 	validValues.push_back(knownValues);
 	descriptions.push_back(parameterDescriptions);
 	argumentValues.push_back(defaultValue);
+	textValues.emplace_back();
+	takesText.push_back(false);
+}
+
+void ArgumentParser::AddKnownTextArgument(const std::string& name, const std::string& shortName, const std::string& description,
+	const std::string& defaultValue)
+{
+	AddKnownArgument(name, shortName, {}, { description });
+	textValues.back() = defaultValue;
+	takesText.back() = true;
 }
 
 bool ArgumentParser::Parse(i32 argc, const char** argv)
@@ -67,7 +97,9 @@ void ArgumentParser::PrintOptions() const
 		const bool offersChoice = numChoices > 1;
 		u64 defaultValue = argumentValues[i];
 		std::cout << " (default: ";
-		if (offersChoice)
+		if (takesText[i])
+			std::cout << textValues[i];
+		else if (offersChoice)
 			std::cout << validValues[i][defaultValue];
 		else
 			std::cout << defaultValue;
@@ -137,7 +169,11 @@ bool ArgumentParser::TryParseValue(const char* argument, u64& lastArgumentID)
 {
 	std::string value(argument);
 	const ValidValues& allValid = validValues[lastArgumentID];
-	if (allValid.empty())
+	if (takesText[lastArgumentID])
+	{
+		textValues[lastArgumentID] = value;
+	}
+	else if (allValid.empty())
 	{
 		char first = argument[0];
 		if (first >= '0' && first <= '9')
@@ -33,6 +33,13 @@ public:
 		const Descriptions& parameterDescriptions);
 	void AddKnownArgument(const std::string& name, const std::string& shortName, const ValidValues& knownValues,
 		const Descriptions& parameterDescriptions, u64 defaultValue);
+	// Text arguments take any value, such as a file name, which GetText returns as it was given.
+	void AddKnownTextArgument(const std::string& name, const std::string& shortName, const std::string& description,
+		const std::string& defaultValue);
+	const std::string& GetText(const std::string& name) const;
+	bool IsText(const std::string& name) const;
+	// Names of all known arguments, in the order they were added.
+	const std::vector<std::string>& GetNames() const { return argumentNames; }
 
 	// No checking for duplicates is performed. Last parameter wins.
 	// Each parameter can have 0 of 1 arguments that are parsed based on known arguments.
@@ -52,6 +59,9 @@ private:
 	ArgumentNames argumentNames;
 	ArgumentNames shortArgumentNames;
 	ArgumentValues argumentValues;
+	// Empty for arguments that are not text.
+	std::vector<std::string> textValues;
+	std::vector<bool> takesText;
 	std::vector<ValidValues> validValues;
 	std::vector<Descriptions> descriptions;
 };
@@ -27,6 +27,9 @@
 // 4.2: several valid values -> selects value index
 // 4.3: no valid values, not a number -> fail
 // 4.4. several valid values, value not in set -> fail
+// Category 5: text argument value
+// 5.1: text argument not supplied -> default text
+// 5.2: text argument supplied -> text as given, even if it starts with a digit
 
 struct ArgumentParserFixture
 {
@@ -280,3 +283,36 @@ TEST_SUITE(ArgumentParser_SpecifiedArgumentValue)
 		Check(!parser.Parse(numArguments, arguments));
 	}
 }
+
+// Category 5: text argument value
+TEST_SUITE(ArgumentParser_TextArgumentValue)
+{
+	// 5.1: text argument not supplied -> default text
+	TEST_FIXTURE(ArgumentParserFixture, TextArgumentNotSupplied_GetText_ReturnsDefault)
+	{
+		const i32 numArguments = sizeof(kDefaultArgument) / sizeof(const char*);
+
+		parser.AddKnownTextArgument("knownArg", "k", "", "output");
+		Check(parser.Parse(numArguments, kDefaultArgument));
+		Check(parser.GetText("knownArg") == "output");
+	}
+
+	// 5.2: text argument supplied -> text as given, even if it starts with a digit
+	TEST_FIXTURE(ArgumentParserFixture, TextArgumentSupplied_GetText_ReturnsArgument)
+	{
+		const char* arguments[] = {
+			"defaultArg",
+			"-k",
+			"2d/rocks.txt",
+			"--otherArg",
+			"7"
+		};
+		const i32 numArguments = sizeof(arguments) / sizeof(const char*);
+
+		parser.AddKnownTextArgument("knownArg", "k", "", "output");
+		parser.AddKnownArgument("otherArg", "o", {}, { "" });
+		Check(parser.Parse(numArguments, arguments));
+		Check(parser.GetText("knownArg") == "2d/rocks.txt");
+		CheckEqual(7ull, parser.GetValue("otherArg"));
+	}
+}
@@ -0,0 +1,159 @@
+#include "ContentHash.hpp"
+
+#include <cstring>
+
+static constexpr u64 kPrime1 = 0x9E3779B185EBCA87ull;
+static constexpr u64 kPrime2 = 0xC2B2AE3D27D4EB4Full;
+static constexpr u64 kPrime3 = 0x165667B19E3779F9ull;
+static constexpr u64 kPrime4 = 0x85EBCA77C2B2AE63ull;
+static constexpr u64 kPrime5 = 0x27D4EB2F165667C5ull;
+
+static u64 rotateLeft(u64 value, u32 bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static u64 read64(const u8* bytes)
+{
+    u64 value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static u32 read32(const u8* bytes)
+{
+    u32 value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static u64 round(u64 lane, u64 input)
+{
+    lane += input * kPrime2;
+    lane = rotateLeft(lane, 31);
+    return lane * kPrime1;
+}
+
+static u64 mergeRound(u64 hash, u64 lane)
+{
+    hash ^= round(0, lane);
+    return hash * kPrime1 + kPrime4;
+}
+
+// The four lanes are independent, so a stripe is 4 multiplications deep instead of 16.
+static void consumeStripes(u64* lanes, const u8* bytes, u64 stripeCount)
+{
+    u64 lane0 = lanes[0];
+    u64 lane1 = lanes[1];
+    u64 lane2 = lanes[2];
+    u64 lane3 = lanes[3];
+    for (u64 i = 0; i < stripeCount; ++i, bytes += 32)
+    {
+        lane0 = round(lane0, read64(bytes));
+        lane1 = round(lane1, read64(bytes + 8));
+        lane2 = round(lane2, read64(bytes + 16));
+        lane3 = round(lane3, read64(bytes + 24));
+    }
+    lanes[0] = lane0;
+    lanes[1] = lane1;
+    lanes[2] = lane2;
+    lanes[3] = lane3;
+}
+
+ContentHash::ContentHash(u64 hashSeed)
+    : seed(hashSeed)
+{
+    lanes[0] = seed + kPrime1 + kPrime2;
+    lanes[1] = seed + kPrime2;
+    lanes[2] = seed;
+    lanes[3] = seed - kPrime1;
+}
+
+void ContentHash::Add(const void* data, u64 size)
+{
+    const u8* bytes = static_cast<const u8*>(data);
+    totalSize += size;
+
+    if (bufferSize + size < kStripeSize)
+    {
+        memcpy(buffer + bufferSize, bytes, static_cast<size_t>(size));
+        bufferSize += static_cast<u32>(size);
+        return;
+    }
+
+    if (bufferSize > 0)
+    {
+        u32 fill = kStripeSize - bufferSize;
+        memcpy(buffer + bufferSize, bytes, fill);
+        consumeStripes(lanes, buffer, 1);
+        bytes += fill;
+        size -= fill;
+        bufferSize = 0;
+    }
+
+    u64 stripeCount = size / kStripeSize;
+    consumeStripes(lanes, bytes, stripeCount);
+    bytes += stripeCount * kStripeSize;
+    size -= stripeCount * kStripeSize;
+
+    memcpy(buffer, bytes, static_cast<size_t>(size));
+    bufferSize = static_cast<u32>(size);
+}
+
+void ContentHash::Add(const std::string& text)
+{
+    Add(static_cast<u64>(text.size()));
+    Add(text.data(), text.size());
+}
+
+u64 ContentHash::Get() const
+{
+    u64 hash;
+    if (totalSize >= kStripeSize)
+    {
+        hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+        hash = mergeRound(hash, lanes[0]);
+        hash = mergeRound(hash, lanes[1]);
+        hash = mergeRound(hash, lanes[2]);
+        hash = mergeRound(hash, lanes[3]);
+    }
+    else
+    {
+        hash = seed + kPrime5;
+    }
+    hash += totalSize;
+
+    const u8* bytes = buffer;
+    u32 remaining = bufferSize;
+    for (; remaining >= 8; remaining -= 8, bytes += 8)
+    {
+        hash ^= round(0, read64(bytes));
+        hash = rotateLeft(hash, 27) * kPrime1 + kPrime4;
+    }
+    if (remaining >= 4)
+    {
+        hash ^= static_cast<u64>(read32(bytes)) * kPrime1;
+        hash = rotateLeft(hash, 23) * kPrime2 + kPrime3;
+        remaining -= 4;
+        bytes += 4;
+    }
+    for (; remaining > 0; --remaining, ++bytes)
+    {
+        hash ^= *bytes * kPrime5;
+        hash = rotateLeft(hash, 11) * kPrime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+u64 ContentHash::Of(const void* data, u64 size, u64 seed)
+{
+    ContentHash hash(seed);
+    hash.Add(data, size);
+    return hash.Get();
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <string>
+
+// XXH64 of a stream of bytes, for cache keys and file checksums. Not meant to resist deliberate collisions.
+// Adding data in several pieces gives the same hash as adding it at once.
+class ContentHash final
+{
+public:
+    explicit ContentHash(u64 seed = 0);
+
+    void Add(const void* data, u64 size);
+    void Add(u64 value) { Add(&value, sizeof(value)); }
+    // The length is added first, so "ab" + "c" and "a" + "bc" hash differently.
+    void Add(const std::string& text);
+
+    u64 Get() const;
+
+    static u64 Of(const void* data, u64 size, u64 seed = 0);
+
+private:
+    static constexpr u32 kStripeSize = 32;
+
+    u64 lanes[4];
+    u64 seed;
+    u64 totalSize = 0;
+    u8 buffer[kStripeSize];
+    u32 bufferSize = 0;
+};
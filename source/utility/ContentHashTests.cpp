@@ -0,0 +1,72 @@
+#include "ContentHash.hpp"
+
+#include "testing/TestFixture.hpp"
+#include "testing/TestRunner.hpp"
+#include "testing/TestSuite.hpp"
+
+#include <cstring>
+#include <vector>
+
+// Category 1: Reference values
+// 1.1: Short inputs hash to the published XXH64 values
+// Category 2: Streaming
+// 2.1: Data added in pieces of any size hashes like data added at once
+// 2.2: Texts added one after the other are told apart by their lengths
+
+struct ContentHashFixture
+{
+	virtual ~ContentHashFixture() = default;
+};
+
+// Category 1: Reference values
+TEST_SUITE(ContentHash_ReferenceValues)
+{
+	// 1.1: Short inputs hash to the published XXH64 values
+	TEST_FIXTURE(ContentHashFixture, ShortInputs_Of_MatchesXXH64)
+	{
+		const char* sentence = "Nobody inspects the spammish repetition";
+
+		Check(ContentHash::Of("", 0) == 0xEF46DB3751D8E999ull);
+		Check(ContentHash::Of("abc", 3) == 0x44BC2CF5AD770999ull);
+		Check(ContentHash::Of(sentence, strlen(sentence)) == 0xFBCEA83C8A378BF1ull);
+	}
+}
+
+// Category 2: Streaming
+TEST_SUITE(ContentHash_Streaming)
+{
+	// 2.1: Data added in pieces of any size hashes like data added at once
+	TEST_FIXTURE(ContentHashFixture, Pieces_Add_MatchesWhole)
+	{
+		std::vector<u8> data(1000);
+		for (u32 i = 0; i < data.size(); ++i)
+			data[i] = static_cast<u8>(i * 37 + 11);
+		const u64 whole = ContentHash::Of(data.data(), data.size());
+
+		bool matches = true;
+		for (u32 pieceSize = 1; pieceSize <= 70; ++pieceSize)
+		{
+			ContentHash hash;
+			for (u32 offset = 0; offset < data.size(); offset += pieceSize)
+			{
+				u32 size = offset + pieceSize < data.size() ? pieceSize : static_cast<u32>(data.size()) - offset;
+				hash.Add(data.data() + offset, size);
+			}
+			matches = matches && hash.Get() == whole;
+		}
+		Check(matches);
+	}
+
+	// 2.2: Texts added one after the other are told apart by their lengths
+	TEST_FIXTURE(ContentHashFixture, SplitTexts_Add_HashDifferently)
+	{
+		ContentHash first;
+		first.Add(std::string("ab"));
+		first.Add(std::string("c"));
+		ContentHash second;
+		second.Add(std::string("a"));
+		second.Add(std::string("bc"));
+
+		Check(first.Get() != second.Get());
+	}
+}
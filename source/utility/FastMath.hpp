@@ -0,0 +1,133 @@
+#pragma once
+
+#include "utility/Simd.hpp"
+#include "utility/Types.hpp"
+
+#include <cmath>
+#include <cstring>
+
+// Polynomial approximations of exp and cos for code that trades accuracy for speed.
+// The vector overloads follow the same operation order as the scalar ones and return the same values.
+
+static constexpr f32 kFastExpMin = -87.0f;
+static constexpr f32 kFastExpMax = 88.0f;
+static constexpr f32 kFastExpLog2E = 1.44269504088896341f;
+static constexpr f32 kFastExpLn2High = 0.693359375f;
+static constexpr f32 kFastExpLn2Low = -2.12194440e-4f;
+static constexpr f32 kFastExpP0 = 1.9875691500e-4f;
+static constexpr f32 kFastExpP1 = 1.3981999507e-3f;
+static constexpr f32 kFastExpP2 = 8.3334519073e-3f;
+static constexpr f32 kFastExpP3 = 4.1665795894e-2f;
+static constexpr f32 kFastExpP4 = 1.6666665459e-1f;
+static constexpr f32 kFastExpP5 = 5.0000001201e-1f;
+
+static constexpr f32 kFastCosInverseTwoPi = 0.159154943091895336f;
+static constexpr f32 kFastCosTwoPiHigh = 6.28125f;
+static constexpr f32 kFastCosTwoPiLow = 1.93530717958647692e-3f;
+static constexpr f32 kFastCosPi = 3.14159265358979324f;
+static constexpr f32 kFastCosHalfPi = 1.57079632679489662f;
+static constexpr f32 kFastCosP0 = 2.08767570e-9f;
+static constexpr f32 kFastCosP1 = -2.75573192e-7f;
+static constexpr f32 kFastCosP2 = 2.48015873e-5f;
+static constexpr f32 kFastCosP3 = -1.38888889e-3f;
+static constexpr f32 kFastCosP4 = 4.16666667e-2f;
+static constexpr f32 kFastCosP5 = -0.5f;
+
+// Relative error of a few ulp for inputs in [-87; 88]. Inputs outside of the range are clamped.
+struct FastExp
+{
+    f32 operator ()(f32 x) const
+    {
+        x = x < kFastExpMax ? x : kFastExpMax;
+        x = x > kFastExpMin ? x : kFastExpMin;
+
+        // exp(x) = 2^n * exp(r), where |r| <= ln(2) / 2.
+        f32 n = nearbyintf(x * kFastExpLog2E);
+        f32 r = fmaf(-n, kFastExpLn2High, x);
+        r = fmaf(-n, kFastExpLn2Low, r);
+
+        f32 p = fmaf(kFastExpP0, r, kFastExpP1);
+        p = fmaf(p, r, kFastExpP2);
+        p = fmaf(p, r, kFastExpP3);
+        p = fmaf(p, r, kFastExpP4);
+        p = fmaf(p, r, kFastExpP5);
+        p = fmaf(p * r, r, r) + 1.0f;
+
+        u32 bits = static_cast<u32>(static_cast<i32>(n) + 127) << 23;
+        f32 scale;
+        memcpy(&scale, &bits, sizeof(scale));
+        return p * scale;
+    }
+
+#if NOISE_SIMD_AVX2
+    __m256 operator ()(__m256 x) const
+    {
+        x = _mm256_min_ps(x, _mm256_set1_ps(kFastExpMax));
+        x = _mm256_max_ps(x, _mm256_set1_ps(kFastExpMin));
+
+        __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(kFastExpLog2E)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(kFastExpLn2High), x);
+        r = _mm256_fnmadd_ps(n, _mm256_set1_ps(kFastExpLn2Low), r);
+
+        __m256 p = _mm256_fmadd_ps(_mm256_set1_ps(kFastExpP0), r, _mm256_set1_ps(kFastExpP1));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kFastExpP2));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kFastExpP3));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kFastExpP4));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kFastExpP5));
+        p = _mm256_add_ps(_mm256_fmadd_ps(_mm256_mul_ps(p, r), r, r), _mm256_set1_ps(1.0f));
+
+        __m256i bits = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+        return _mm256_mul_ps(p, _mm256_castsi256_ps(bits));
+    }
+#endif
+};
+
+// Absolute error below 1e-6 for arguments up to a few thousand radians.
+struct FastCos
+{
+    f32 operator ()(f32 x) const
+    {
+        // Reduce to [-pi; pi], then fold into [0; pi / 2] using cos(pi - a) = -cos(a).
+        f32 k = nearbyintf(x * kFastCosInverseTwoPi);
+        f32 r = fmaf(-k, kFastCosTwoPiHigh, x);
+        r = fmaf(-k, kFastCosTwoPiLow, r);
+
+        f32 a = fabsf(r);
+        bool isFlipped = a > kFastCosHalfPi;
+        a = isFlipped ? kFastCosPi - a : a;
+
+        f32 z = a * a;
+        f32 p = fmaf(kFastCosP0, z, kFastCosP1);
+        p = fmaf(p, z, kFastCosP2);
+        p = fmaf(p, z, kFastCosP3);
+        p = fmaf(p, z, kFastCosP4);
+        p = fmaf(p, z, kFastCosP5);
+        p = fmaf(p, z, 1.0f);
+
+        return isFlipped ? -p : p;
+    }
+
+#if NOISE_SIMD_AVX2
+    __m256 operator ()(__m256 x) const
+    {
+        __m256 k = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(kFastCosInverseTwoPi)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256 r = _mm256_fnmadd_ps(k, _mm256_set1_ps(kFastCosTwoPiHigh), x);
+        r = _mm256_fnmadd_ps(k, _mm256_set1_ps(kFastCosTwoPiLow), r);
+
+        __m256 signMask = _mm256_set1_ps(-0.0f);
+        __m256 a = _mm256_andnot_ps(signMask, r);
+        __m256 isFlipped = _mm256_cmp_ps(a, _mm256_set1_ps(kFastCosHalfPi), _CMP_GT_OQ);
+        a = _mm256_blendv_ps(a, _mm256_sub_ps(_mm256_set1_ps(kFastCosPi), a), isFlipped);
+
+        __m256 z = _mm256_mul_ps(a, a);
+        __m256 p = _mm256_fmadd_ps(_mm256_set1_ps(kFastCosP0), z, _mm256_set1_ps(kFastCosP1));
+        p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(kFastCosP2));
+        p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(kFastCosP3));
+        p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(kFastCosP4));
+        p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(kFastCosP5));
+        p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(1.0f));
+
+        return _mm256_xor_ps(p, _mm256_and_ps(isFlipped, signMask));
+    }
+#endif
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <string>
+
+// Read-only view of a whole file. IsOpen() is false when the file could not be mapped.
+class MappedFile
+{
+public:
+    MappedFile() = delete;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    explicit MappedFile(const std::string& fileName);
+    ~MappedFile();
+
+    MappedFile& operator =(const MappedFile&) = delete;
+    MappedFile& operator =(MappedFile&&) = delete;
+
+    bool IsOpen() const { return data != nullptr; }
+    const u8* GetData() const { return data; }
+    u64 GetSize() const { return size; }
+
+private:
+    const u8* data = nullptr;
+    u64 size = 0;
+#if defined(_WIN32)
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+};
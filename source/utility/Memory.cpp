@@ -0,0 +1,43 @@
+#include "Memory.hpp"
+
+#if defined(_WIN32)
+#include <malloc.h>
+#else
+#include <cstdlib>
+#endif
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+void* Memory::Allocate(u64 size)
+{
+    bool isHuge = size >= kHugePageSize;
+    u64 alignment = isHuge ? kHugePageSize : kCacheLineSize;
+    // aligned_alloc requires the size to be a multiple of the alignment.
+    u64 alignedSize = (size + alignment - 1) / alignment * alignment;
+    alignedSize = alignedSize > 0 ? alignedSize : alignment;
+
+#if defined(_WIN32)
+    void* block = _aligned_malloc(alignedSize, alignment);
+#else
+    void* block = aligned_alloc(alignment, alignedSize);
+#endif
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    // Only a hint: the kernel falls back to regular pages when transparent huge pages are disabled.
+    if (block != nullptr && isHuge)
+        madvise(block, alignedSize, MADV_HUGEPAGE);
+#endif
+
+    return block;
+}
+
+void Memory::Free(void* block)
+{
+#if defined(_WIN32)
+    _aligned_free(block);
+#else
+    free(block);
+#endif
+}
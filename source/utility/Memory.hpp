@@ -0,0 +1,15 @@
+#pragma once
+
+#include "Types.hpp"
+
+// Allocations for large pixel buffers.
+struct Memory final
+{
+    static constexpr u64 kCacheLineSize = 64;
+    // Blocks of at least this size are aligned to it and, where the OS allows it, backed by transparent huge pages.
+    static constexpr u64 kHugePageSize = 2 * 1024 * 1024;
+
+    // Returns a block aligned to at least kCacheLineSize bytes, or nullptr. The contents are not initialized.
+    static void* Allocate(u64 size);
+    static void Free(void* block);
+};
@@ -0,0 +1,280 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+struct ProfileNode
+{
+    const char* name;
+    u32 parent;
+    u64 calls;
+    u64 nanoseconds;
+    u64 bytes;
+    std::vector<u32> children;
+};
+
+struct TraceEvent
+{
+    const char* name;
+    // Since tracing was enabled.
+    u64 nanoseconds;
+    // Range of a TraceScope, empty for stages.
+    u32 rangeBegin;
+    u32 rangeEnd;
+    bool isBegin;
+};
+
+// Scopes that ran on one thread. Node 0 is the root the outermost scopes are nested in.
+struct ProfileTree
+{
+    std::vector<ProfileNode> nodes;
+    u32 current;
+    std::vector<TraceEvent> events;
+
+    ProfileTree()
+        : nodes(1, ProfileNode{ "", 0, 0, 0, 0, {} })
+        , current(0)
+    {
+    }
+};
+
+// Trees live until the process ends, so their threads never need to unregister them.
+struct ProfileRegistry
+{
+    std::mutex mutex;
+    std::vector<ProfileTree*> trees;
+
+    ~ProfileRegistry()
+    {
+        for (ProfileTree* tree : trees)
+            delete tree;
+    }
+};
+
+static ProfileRegistry& getRegistry()
+{
+    static ProfileRegistry registry;
+    return registry;
+}
+
+static thread_local ProfileTree* sThreadTree = nullptr;
+static std::chrono::steady_clock::time_point sTraceStart;
+
+static ProfileTree& getThreadTree()
+{
+    if (sThreadTree == nullptr)
+    {
+        sThreadTree = new ProfileTree();
+        ProfileRegistry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.trees.push_back(sThreadTree);
+    }
+    return *sThreadTree;
+}
+
+static u32 findChild(const std::vector<ProfileNode>& nodes, const std::vector<u32>& children, const char* name)
+{
+    // The same name can be a different literal in every translation unit, so names are compared by their text.
+    for (u32 child : children)
+        if (strcmp(nodes[child].name, name) == 0)
+            return child;
+    return 0;
+}
+
+static void merge(const ProfileTree& tree, u32 node, std::vector<ProfileNode>& merged, u32 mergedNode)
+{
+    for (u32 child : tree.nodes[node].children)
+    {
+        const ProfileNode& source = tree.nodes[child];
+        u32 target = findChild(merged, merged[mergedNode].children, source.name);
+        if (target == 0)
+        {
+            target = static_cast<u32>(merged.size());
+            merged.push_back(ProfileNode{ source.name, mergedNode, 0, 0, 0, {} });
+            merged[mergedNode].children.push_back(target);
+        }
+        merged[target].calls += source.calls;
+        merged[target].nanoseconds += source.nanoseconds;
+        merged[target].bytes += source.bytes;
+        merge(tree, child, merged, target);
+    }
+}
+
+static void flatten(const std::vector<ProfileNode>& merged, u32 node, u32 depth, std::vector<Profiler::Entry>& entries)
+{
+    for (u32 child : merged[node].children)
+    {
+        const ProfileNode& source = merged[child];
+        entries.push_back(Profiler::Entry{ source.name, depth, source.calls, source.nanoseconds, source.bytes });
+        flatten(merged, child, depth + 1, entries);
+    }
+}
+
+void Profiler::SetMode(u32 mode, bool enabled)
+{
+    if (enabled)
+        sModes.fetch_or(mode, std::memory_order_relaxed);
+    else
+        sModes.fetch_and(~mode, std::memory_order_relaxed);
+}
+
+void Profiler::SetTracing(bool enabled)
+{
+    if (enabled && !IsTracing())
+        sTraceStart = std::chrono::steady_clock::now();
+    SetMode(kTracing, enabled);
+}
+
+std::vector<Profiler::Entry> Profiler::Collect()
+{
+    std::vector<ProfileNode> merged(1, ProfileNode{ "", 0, 0, 0, 0, {} });
+    {
+        ProfileRegistry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const ProfileTree* tree : registry.trees)
+            merge(*tree, 0, merged, 0);
+    }
+
+    std::vector<Entry> entries;
+    flatten(merged, 0, 0, entries);
+    return entries;
+}
+
+void Profiler::Print()
+{
+    static constexpr u32 kIndentation = 2;
+    static constexpr u32 kNameWidth = 28;
+
+    std::vector<Entry> entries = Collect();
+    if (entries.empty())
+        return;
+
+    // Time of the enclosing scope, the last entry seen one level up.
+    std::vector<u64> enclosingTimes;
+    std::cout << "Profile, times of all threads summed:" << std::endl;
+    std::cout << "  " << std::left << std::setw(kNameWidth) << "stage" << std::right << std::setw(10) << "ms" << std::setw(8) << "%" <<
+        std::setw(9) << "calls" << std::setw(11) << "MB" << std::setw(11) << "MB/s" << std::endl;
+    std::cout << std::fixed;
+    for (const Entry& entry : entries)
+    {
+        enclosingTimes.resize(entry.depth + 1);
+        enclosingTimes[entry.depth] = entry.nanoseconds;
+
+        const double milliseconds = static_cast<double>(entry.nanoseconds) * 1e-6;
+        const u32 indentation = std::min(entry.depth * kIndentation, kNameWidth - 1);
+        std::cout << "  " << std::string(indentation, ' ') << std::left << std::setw(kNameWidth - indentation) << entry.name <<
+            std::right << std::setprecision(2) << std::setw(10) << milliseconds << std::setprecision(1) << std::setw(8);
+        const u64 enclosingTime = entry.depth > 0 ? enclosingTimes[entry.depth - 1] : 0;
+        if (enclosingTime > 0)
+            std::cout << 100.0 * static_cast<double>(entry.nanoseconds) / static_cast<double>(enclosingTime);
+        else
+            std::cout << "";
+        std::cout << std::setw(9) << entry.calls;
+        if (entry.bytes > 0)
+        {
+            const double megabytes = static_cast<double>(entry.bytes) / (1024.0 * 1024.0);
+            std::cout << std::setprecision(2) << std::setw(11) << megabytes;
+            if (entry.nanoseconds > 0)
+                std::cout << std::setprecision(1) << std::setw(11) << megabytes / (milliseconds * 1e-3);
+        }
+        std::cout << std::endl;
+    }
+    std::cout << std::defaultfloat;
+}
+
+bool Profiler::WriteTrace(const std::string& fileName)
+{
+    std::ofstream file(fileName, std::ios::trunc);
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    // Threads are numbered in the order they first ran a scope. Names are literals of the code, they need no escaping.
+    ProfileRegistry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    const char* separator = "\n";
+    for (u32 thread = 0; thread < registry.trees.size(); ++thread)
+    {
+        const std::vector<TraceEvent>& events = registry.trees[thread]->events;
+        if (events.empty())
+            continue;
+
+        file << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread <<
+            ",\"args\":{\"name\":\"thread " << thread << "\"}}";
+        separator = ",\n";
+        for (const TraceEvent& event : events)
+        {
+            file << separator << "{\"name\":\"" << event.name << "\",\"ph\":\"" << (event.isBegin ? 'B' : 'E') <<
+                "\",\"pid\":1,\"tid\":" << thread << ",\"ts\":" << static_cast<double>(event.nanoseconds) * 1e-3;
+            if (event.rangeEnd > event.rangeBegin)
+                file << ",\"args\":{\"begin\":" << event.rangeBegin << ",\"end\":" << event.rangeEnd << "}";
+            file << "}";
+        }
+    }
+    file << "\n]}\n";
+    file.close();
+    return !file.fail();
+}
+
+void Profiler::Reset()
+{
+    ProfileRegistry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (ProfileTree* tree : registry.trees)
+        *tree = ProfileTree();
+}
+
+u32 Profiler::Enter(const char* name)
+{
+    ProfileTree& tree = getThreadTree();
+    u32 node = findChild(tree.nodes, tree.nodes[tree.current].children, name);
+    if (node == 0)
+    {
+        node = static_cast<u32>(tree.nodes.size());
+        tree.nodes.push_back(ProfileNode{ name, tree.current, 0, 0, 0, {} });
+        tree.nodes[tree.current].children.push_back(node);
+    }
+    tree.current = node;
+    return node;
+}
+
+void Profiler::Trace(const char* name, bool isBegin, u32 rangeBegin, u32 rangeEnd)
+{
+    const u64 nanoseconds = static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - sTraceStart).count());
+    getThreadTree().events.push_back(TraceEvent{ name, nanoseconds, rangeBegin, rangeEnd, isBegin });
+}
+
+void Profiler::Exit(u32 node, u64 nanoseconds, u64 bytes)
+{
+    ProfileTree& tree = *sThreadTree;
+    ProfileNode& exited = tree.nodes[node];
+    ++exited.calls;
+    exited.nanoseconds += nanoseconds;
+    exited.bytes += bytes;
+    tree.current = exited.parent;
+}
+
+void ProfileScope::Begin(const char* name, u32 modes)
+{
+    if ((modes & Profiler::kProfiling) != 0)
+        node = Profiler::Enter(name);
+    if ((modes & Profiler::kTracing) != 0)
+    {
+        tracedName = name;
+        Profiler::Trace(name, true);
+    }
+    start = Clock::now();
+}
+
+void ProfileScope::End()
+{
+    const u64 nanoseconds = static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+    if (tracedName != nullptr)
+        Profiler::Trace(tracedName, false);
+    if (node != kNoNode)
+        Profiler::Exit(node, nanoseconds, bytes);
+}
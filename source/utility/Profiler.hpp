@@ -0,0 +1,154 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Scoped timers for the stages of a job, enabled at run time with Profiler::SetEnabled. Scopes nest into a tree per
+// thread without locks, the trees of all threads are merged by path when collected.
+// With Profiler::SetTracing the same scopes, and the bands of the thread pool, also append begin and end events to a
+// buffer of their thread, written as a Chrome trace that shows what every thread did when.
+// While both are disabled a scope costs a load and a branch; building with NOISE_PROFILING 0 removes scopes entirely.
+#if !defined(NOISE_PROFILING)
+#define NOISE_PROFILING 1
+#endif
+
+class Profiler final
+{
+public:
+    struct Entry
+    {
+        const char* name;
+        // 0 for scopes that are not nested in another one.
+        u32 depth;
+        u64 calls;
+        u64 nanoseconds;
+        u64 bytes;
+    };
+
+    // Bits of GetModes.
+    static constexpr u32 kProfiling = 1;
+    static constexpr u32 kTracing = 2;
+
+    static void SetEnabled(bool enabled) { SetMode(kProfiling, enabled); }
+    static bool IsEnabled() { return (GetModes() & kProfiling) != 0; }
+    // Trace times count from the call that enables tracing.
+    static void SetTracing(bool enabled);
+    static bool IsTracing() { return (GetModes() & kTracing) != 0; }
+    static u32 GetModes() { return sModes.load(std::memory_order_relaxed); }
+
+    // Scopes of every thread, depth first with children in the order they first ran. Times of scopes that ran on
+    // several threads are summed, so children can add up to more than their parent. Only call while no scope is open.
+    static std::vector<Entry> Collect();
+    static void Print();
+    // Writes the events of every thread in the Chrome trace event format, which chrome://tracing and the Perfetto UI
+    // open. Only call while no scope is open. Returns false if the file could not be written.
+    static bool WriteTrace(const std::string& fileName);
+    // Forgets every scope and event. Only call while no scope is open.
+    static void Reset();
+
+    // Used by ProfileScope and TraceScope.
+    static u32 Enter(const char* name);
+    static void Exit(u32 node, u64 nanoseconds, u64 bytes);
+    static void Trace(const char* name, bool isBegin, u32 rangeBegin = 0, u32 rangeEnd = 0);
+
+private:
+    static void SetMode(u32 mode, bool enabled);
+
+    static inline std::atomic<u32> sModes{ 0 };
+};
+
+class ProfileScope final
+{
+public:
+    ProfileScope() = delete;
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope(ProfileScope&&) = delete;
+    explicit ProfileScope(const char* name)
+    {
+        const u32 modes = Profiler::GetModes();
+        if (modes != 0)
+            Begin(name, modes);
+    }
+    // countBytes returns the amount of data the stage processes. It is only called while profiling is enabled.
+    template<class ByteCounter>
+    ProfileScope(const char* name, const ByteCounter& countBytes)
+    {
+        const u32 modes = Profiler::GetModes();
+        if (modes != 0)
+        {
+            if ((modes & Profiler::kProfiling) != 0)
+                bytes = countBytes();
+            Begin(name, modes);
+        }
+    }
+    ~ProfileScope()
+    {
+        if (node != kNoNode || tracedName != nullptr)
+            End();
+    }
+
+    ProfileScope& operator =(const ProfileScope&) = delete;
+    ProfileScope& operator =(ProfileScope&&) = delete;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+    static constexpr u32 kNoNode = ~0u;
+
+    void Begin(const char* name, u32 modes);
+    void End();
+
+    u32 node = kNoNode;
+    const char* tracedName = nullptr;
+    u64 bytes = 0;
+    Clock::time_point start;
+};
+
+// A trace event pair for a range of a larger task, like a band of ThreadPool::ParallelFor. Profiling ignores it, so
+// the breakdown of stages stays the same however work is split.
+class TraceScope final
+{
+public:
+    TraceScope() = delete;
+    TraceScope(const TraceScope&) = delete;
+    TraceScope(TraceScope&&) = delete;
+    TraceScope(const char* name, u32 rangeBegin, u32 rangeEnd)
+    {
+        if (Profiler::IsTracing())
+        {
+            tracedName = name;
+            Profiler::Trace(name, true, rangeBegin, rangeEnd);
+        }
+    }
+    ~TraceScope()
+    {
+        if (tracedName != nullptr)
+            Profiler::Trace(tracedName, false);
+    }
+
+    TraceScope& operator =(const TraceScope&) = delete;
+    TraceScope& operator =(TraceScope&&) = delete;
+
+private:
+    const char* tracedName = nullptr;
+};
+
+#define NOISE_PROFILE_CONCATENATE_INNER(a, b) a##b
+#define NOISE_PROFILE_CONCATENATE(a, b) NOISE_PROFILE_CONCATENATE_INNER(a, b)
+
+#if NOISE_PROFILING
+// Times the rest of the enclosing block as a stage called name.
+#define PROFILE_SCOPE(name) ProfileScope NOISE_PROFILE_CONCATENATE(profileScope, __LINE__)(name)
+// Like PROFILE_SCOPE, for a stage that processes the given number of bytes. The count is not evaluated while profiling
+// is disabled.
+#define PROFILE_SCOPE_BYTES(name, bytes) ProfileScope NOISE_PROFILE_CONCATENATE(profileScope, __LINE__)(name, [&]() -> u64 { return (bytes); })
+// Traces the rest of the enclosing block as the range [rangeBegin; rangeEnd) of a task.
+#define TRACE_RANGE(name, rangeBegin, rangeEnd) TraceScope NOISE_PROFILE_CONCATENATE(traceScope, __LINE__)(name, rangeBegin, rangeEnd)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_SCOPE_BYTES(name, bytes) ((void)0)
+#define TRACE_RANGE(name, rangeBegin, rangeEnd) ((void)0)
+#endif
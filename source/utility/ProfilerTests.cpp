@@ -0,0 +1,154 @@
+#include "Profiler.hpp"
+
+#include "testing/TestFixture.hpp"
+#include "testing/TestRunner.hpp"
+#include "testing/TestSuite.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Category 1: Collection
+// 1.1: Nested scopes are collected below their parent with their calls and bytes summed
+// 1.2: Scopes with the same path on different threads are merged into one entry
+// Category 2: Disabled profiling
+// 2.1: Scopes record nothing while profiling is disabled
+// Category 3: Tracing
+// 3.1: Traced scopes and ranges are written as begin and end events of their thread
+
+struct ProfilerFixture
+{
+	virtual ~ProfilerFixture() = default;
+
+	// Fixtures live as long as the test runner, so every test profiles from a clean state of its own.
+	struct Session
+	{
+		Session()
+		{
+			Profiler::Reset();
+			Profiler::SetEnabled(true);
+		}
+
+		~Session()
+		{
+			Profiler::SetEnabled(false);
+			Profiler::SetTracing(false);
+			Profiler::Reset();
+		}
+	};
+
+	static u64 SixtyFourBytes() { return 64; }
+};
+
+// Category 1: Collection
+TEST_SUITE(Profiler_Collection)
+{
+	// 1.1: Nested scopes are collected below their parent with their calls and bytes summed
+	TEST_FIXTURE(ProfilerFixture, NestedScopes_Collect_FormTree)
+	{
+		Session session;
+		{
+			ProfileScope outer("outer");
+			for (u32 i = 0; i < 3; ++i)
+				ProfileScope inner("inner", SixtyFourBytes);
+		}
+		{
+			ProfileScope sibling("sibling");
+		}
+
+		std::vector<Profiler::Entry> entries = Profiler::Collect();
+		CheckEqual(entries.size(), static_cast<size_t>(3));
+		if (entries.size() != 3)
+			return;
+		Check(strcmp(entries[0].name, "outer") == 0 && entries[0].depth == 0 && entries[0].calls == 1 && entries[0].bytes == 0);
+		Check(strcmp(entries[1].name, "inner") == 0 && entries[1].depth == 1 && entries[1].calls == 3 && entries[1].bytes == 192);
+		Check(strcmp(entries[2].name, "sibling") == 0 && entries[2].depth == 0 && entries[2].calls == 1);
+		Check(entries[1].nanoseconds <= entries[0].nanoseconds);
+	}
+
+	// 1.2: Scopes with the same path on different threads are merged into one entry
+	TEST_FIXTURE(ProfilerFixture, ScopesOnThreads_Collect_Merged)
+	{
+		Session session;
+		auto work = []()
+		{
+			ProfileScope scope("work", SixtyFourBytes);
+		};
+		std::thread first(work);
+		std::thread second(work);
+		first.join();
+		second.join();
+		work();
+
+		std::vector<Profiler::Entry> entries = Profiler::Collect();
+		CheckEqual(entries.size(), static_cast<size_t>(1));
+		if (entries.size() != 1)
+			return;
+		Check(entries[0].calls == 3 && entries[0].bytes == 192);
+	}
+}
+
+// Category 2: Disabled profiling
+TEST_SUITE(Profiler_Disabled)
+{
+	// 2.1: Scopes record nothing while profiling is disabled
+	TEST_FIXTURE(ProfilerFixture, DisabledScopes_Collect_Nothing)
+	{
+		Session session;
+		Profiler::SetEnabled(false);
+		bool isCounted = false;
+		{
+			ProfileScope scope("skipped", [&]() -> u64 { isCounted = true; return 64; });
+		}
+
+		Check(Profiler::Collect().empty());
+		Check(!isCounted);
+	}
+}
+
+// Category 3: Tracing
+TEST_SUITE(Profiler_Tracing)
+{
+	// 3.1: Traced scopes and ranges are written as begin and end events of their thread
+	TEST_FIXTURE(ProfilerFixture, TracedScopes_WriteTrace_BalancedEvents)
+	{
+		static const char* const kTraceFileName = "profiler_test_trace.json";
+
+		Session session;
+		Profiler::SetEnabled(false);
+		Profiler::SetTracing(true);
+		{
+			ProfileScope stage("stage");
+			TraceScope band("band", 16, 32);
+		}
+		std::thread other([]() { ProfileScope stage("stage"); });
+		other.join();
+
+		Check(Profiler::Collect().empty());
+		Check(Profiler::WriteTrace(kTraceFileName));
+
+		std::ifstream file(kTraceFileName);
+		const std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		file.close();
+		std::error_code error;
+		std::filesystem::remove(kTraceFileName, error);
+
+		auto count = [&text](const std::string& pattern)
+		{
+			u32 found = 0;
+			for (size_t position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + 1))
+				++found;
+			return found;
+		};
+		CheckEqual(count("\"ph\":\"B\""), 3u);
+		CheckEqual(count("\"ph\":\"E\""), 3u);
+		CheckEqual(count("\"ph\":\"M\""), 2u);
+		Check(text.find("\"name\":\"band\",\"ph\":\"B\"") != std::string::npos);
+		Check(text.find("\"args\":{\"begin\":16,\"end\":32}") != std::string::npos);
+		Check(text.rfind("]}") != std::string::npos);
+	}
+}
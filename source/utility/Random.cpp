@@ -2,6 +2,8 @@
 
 #include <cmath>
 
+static constexpr u32 kMultiplier = 3039177861;
+
 Random::Random(u32 seed) :
     x(seed > 0 ? seed : 1)
 {
@@ -9,10 +11,23 @@ Random::Random(u32 seed) :
 
 u32 Random::Next()
 {
-    x *= 3039177861;
+    x *= kMultiplier;
     return x;
 }
 
+void Random::Skip(u32 count)
+{
+    // x * kMultiplier^count, squaring the multiplier for every bit of count.
+    u32 multiplier = kMultiplier;
+    while (count > 0)
+    {
+        if ((count & 1) != 0)
+            x *= multiplier;
+        multiplier *= multiplier;
+        count >>= 1;
+    }
+}
+
 f32 Random::Uniform()
 {
     return static_cast<f32>(static_cast<f64>(Next()) / static_cast<f64>(~0u));
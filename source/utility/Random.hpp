@@ -11,6 +11,8 @@ struct Random
     ~Random() = default;
     
     u32 Next();
+    // Same state as calling Next count times, in O(log count) steps.
+    void Skip(u32 count);
     
     // Uniform distribution
     f32 Uniform();
@@ -0,0 +1,31 @@
+#include "Random.hpp"
+
+#include "testing/TestFixture.hpp"
+#include "testing/TestRunner.hpp"
+#include "testing/TestSuite.hpp"
+
+// Category 1: Skip
+// 1.1: Skipping matches calling Next, for counts from 0 to 1000
+
+struct RandomFixture
+{
+	virtual ~RandomFixture() = default;
+};
+
+// Category 1: Skip
+TEST_SUITE(Random_Skip)
+{
+	// 1.1: Skipping matches calling Next, for counts from 0 to 1000
+	TEST_FIXTURE(RandomFixture, Counts_Skip_MatchesNext)
+	{
+		Random sequential(7);
+		bool matches = true;
+		for (u32 count = 0; count <= 1000; ++count)
+		{
+			Random skipped(7);
+			skipped.Skip(count);
+			matches = matches && skipped.Next() == sequential.Next();
+		}
+		Check(matches);
+	}
+}
@@ -0,0 +1,123 @@
+#include "ResultCache.hpp"
+
+#include "ContentHash.hpp"
+#include "MappedFile.hpp"
+#include "Profiler.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+// An entry lists its files, one "<suffix> <size> <checksum>" line each. The files are kept next to it.
+static const char* const kEntrySuffix = ".entry";
+
+static std::string toHex(u64 value)
+{
+    std::ostringstream text;
+    text << std::hex << std::setw(16) << std::setfill('0') << value;
+    return text.str();
+}
+
+static bool writeFile(const std::string& fileName, const u8* data, u64 size)
+{
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+    file.close();
+    return !file.fail();
+}
+
+// The file is written under a temporary name and renamed, so a reader never sees a partly written file.
+static bool writeFileAtomically(const std::string& fileName, const std::string& temporaryTag, const u8* data, u64 size)
+{
+    std::string temporaryName = fileName + "." + temporaryTag;
+    std::error_code error;
+    if (writeFile(temporaryName, data, size))
+        std::filesystem::rename(temporaryName, fileName, error);
+    else
+        error = std::make_error_code(std::errc::io_error);
+
+    if (error)
+        std::filesystem::remove(temporaryName, error);
+    return !error;
+}
+
+ResultCache::ResultCache(const std::string& cacheDirectory)
+    : directory(cacheDirectory)
+    , hits(0)
+    , misses(0)
+    , bytesSaved(0)
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+}
+
+bool ResultCache::Fetch(u64 key, const std::string& baseFileName)
+{
+    PROFILE_SCOPE("cache fetch");
+    std::ifstream entry(GetPath(key, kEntrySuffix));
+    bool isValid = entry.is_open();
+    u64 fetchedBytes = 0;
+    u32 fileCount = 0;
+
+    std::string suffix;
+    u64 size;
+    u64 checksum;
+    while (isValid && entry >> suffix >> std::dec >> size >> std::hex >> checksum)
+    {
+        MappedFile file(GetPath(key, suffix));
+        isValid = file.IsOpen() && file.GetSize() == size && ContentHash::Of(file.GetData(), size) == checksum &&
+            writeFile(baseFileName + suffix, file.GetData(), size);
+        fetchedBytes += size;
+        ++fileCount;
+    }
+    // A damaged entry stops being read before its end.
+    isValid = isValid && fileCount > 0 && entry.eof();
+
+    if (!isValid)
+    {
+        misses.fetch_add(1);
+        return false;
+    }
+
+    hits.fetch_add(1);
+    bytesSaved.fetch_add(fetchedBytes);
+    return true;
+}
+
+void ResultCache::Store(u64 key, const std::string& baseFileName, const std::vector<std::string>& suffixes)
+{
+    PROFILE_SCOPE("cache store");
+    // Jobs write different output files, so the output name keeps apart the temporary files of jobs storing one key.
+    const std::string temporaryTag = toHex(ContentHash::Of(baseFileName.data(), baseFileName.size())) + ".tmp";
+
+    std::ostringstream entry;
+    for (const std::string& suffix : suffixes)
+    {
+        MappedFile file(baseFileName + suffix);
+        if (!file.IsOpen())
+            return;
+
+        u64 checksum = ContentHash::Of(file.GetData(), file.GetSize());
+        if (!writeFileAtomically(GetPath(key, suffix), temporaryTag, file.GetData(), file.GetSize()))
+            return;
+        entry << suffix << ' ' << file.GetSize() << ' ' << toHex(checksum) << '\n';
+    }
+
+    std::string text = entry.str();
+    writeFileAtomically(GetPath(key, kEntrySuffix), temporaryTag, reinterpret_cast<const u8*>(text.data()), text.size());
+}
+
+ResultCache::Stats ResultCache::GetStats() const
+{
+    Stats stats;
+    stats.hits = hits.load();
+    stats.misses = misses.load();
+    stats.bytesSaved = bytesSaved.load();
+    return stats;
+}
+
+std::string ResultCache::GetPath(u64 key, const std::string& suffix) const
+{
+    return (std::filesystem::path(directory) / (toHex(key) + suffix)).string();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Output files of generated images, kept in a directory under a key of everything that determines them. Every file of an
+// entry is checked against its checksum before it is copied, so a damaged entry is generated again instead of used.
+// Jobs on different threads may use one cache at the same time, as long as they write different output files.
+class ResultCache final
+{
+public:
+    struct Stats
+    {
+        u64 hits;
+        u64 misses;
+        // Size of the files copied from the cache instead of being generated.
+        u64 bytesSaved;
+    };
+
+    ResultCache() = delete;
+    ResultCache(const ResultCache&) = delete;
+    ResultCache(ResultCache&&) = delete;
+    explicit ResultCache(const std::string& directory);
+    ~ResultCache() = default;
+
+    ResultCache& operator =(const ResultCache&) = delete;
+    ResultCache& operator =(ResultCache&&) = delete;
+
+    // Copies the files cached under key to baseFileName followed by the suffix each file was stored with. Returns false
+    // if the entry is missing or damaged, in which case some of the files may have been copied already.
+    bool Fetch(u64 key, const std::string& baseFileName);
+    // Keeps copies of the files baseFileName + suffix under key. The entry only becomes visible once all files are in
+    // place, so an interrupted Store leaves no entry behind.
+    void Store(u64 key, const std::string& baseFileName, const std::vector<std::string>& suffixes);
+
+    Stats GetStats() const;
+
+private:
+    std::string GetPath(u64 key, const std::string& suffix) const;
+
+    std::string directory;
+    std::atomic<u64> hits;
+    std::atomic<u64> misses;
+    std::atomic<u64> bytesSaved;
+};
@@ -0,0 +1,95 @@
+#include "ResultCache.hpp"
+
+#include "testing/TestFixture.hpp"
+#include "testing/TestRunner.hpp"
+#include "testing/TestSuite.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+// Category 1: Hits
+// 1.1: Stored files are copied back byte for byte and counted as a hit with their size saved
+// Category 2: Misses
+// 2.1: A key that was never stored misses
+// 2.2: A cached file that no longer matches its checksum misses
+
+static const char* const kCacheDirectory = "result_cache_test";
+static const char* const kCacheOutputName = "result_cache_test_output";
+
+struct ResultCacheFixture
+{
+	virtual ~ResultCacheFixture()
+	{
+		std::error_code error;
+		std::filesystem::remove_all(kCacheDirectory, error);
+		std::filesystem::remove(std::string(kCacheOutputName) + ".dds", error);
+		std::filesystem::remove(std::string(kCacheOutputName) + "_mip1.tga", error);
+	}
+
+	ResultCache cache{ kCacheDirectory };
+
+	static void WriteText(const std::string& fileName, const std::string& text)
+	{
+		std::ofstream file(fileName, std::ios::binary);
+		file << text;
+	}
+
+	static std::string ReadText(const std::string& fileName)
+	{
+		std::ifstream file(fileName, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+};
+
+// Category 1: Hits
+TEST_SUITE(ResultCache_Hits)
+{
+	// 1.1: Stored files are copied back byte for byte and counted as a hit with their size saved
+	TEST_FIXTURE(ResultCacheFixture, StoredFiles_Fetch_CopiesFiles)
+	{
+		const std::string output(kCacheOutputName);
+		WriteText(output + ".dds", "first file");
+		WriteText(output + "_mip1.tga", std::string("second\0file", 11));
+		cache.Store(42, output, { ".dds", "_mip1.tga" });
+		WriteText(output + ".dds", "overwritten");
+		std::error_code error;
+		std::filesystem::remove(output + "_mip1.tga", error);
+
+		Check(cache.Fetch(42, output));
+		Check(ReadText(output + ".dds") == "first file");
+		Check(ReadText(output + "_mip1.tga") == std::string("second\0file", 11));
+		ResultCache::Stats stats = cache.GetStats();
+		Check(stats.hits == 1 && stats.misses == 0 && stats.bytesSaved == 21);
+	}
+}
+
+// Category 2: Misses
+TEST_SUITE(ResultCache_Misses)
+{
+	// 2.1: A key that was never stored misses
+	TEST_FIXTURE(ResultCacheFixture, UnknownKey_Fetch_Misses)
+	{
+		Check(!cache.Fetch(7, kCacheOutputName));
+		ResultCache::Stats stats = cache.GetStats();
+		Check(stats.hits == 0 && stats.misses == 1 && stats.bytesSaved == 0);
+	}
+
+	// 2.2: A cached file that no longer matches its checksum misses
+	TEST_FIXTURE(ResultCacheFixture, DamagedFile_Fetch_Misses)
+	{
+		const std::string output(kCacheOutputName);
+		WriteText(output + ".dds", "original");
+		cache.Store(42, output, { ".dds" });
+		std::error_code error;
+		for (const std::filesystem::directory_entry& file : std::filesystem::directory_iterator(kCacheDirectory, error))
+		{
+			if (file.path().extension() == ".dds")
+				WriteText(file.path().string(), "damaged!");
+		}
+
+		Check(!cache.Fetch(42, output));
+		Check(cache.GetStats().misses == 1);
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+// Vector code paths are compiled in when the target instruction set allows them.
+// Every vector path has a scalar fallback that produces the same results.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NOISE_SIMD_SSE2 1
+#else
+#define NOISE_SIMD_SSE2 0
+#endif
+
+#if defined(__AVX2__) && defined(__FMA__)
+#define NOISE_SIMD_AVX2 1
+#else
+#define NOISE_SIMD_AVX2 0
+#endif
+
+#if NOISE_SIMD_AVX2 && defined(__AVX512F__)
+#define NOISE_SIMD_AVX512 1
+#else
+#define NOISE_SIMD_AVX512 0
+#endif
+
+// Half precision conversions come with AVX2 on every target that has it, MSVC does not announce them separately.
+#if NOISE_SIMD_AVX2 && (defined(__F16C__) || (defined(_MSC_VER) && !defined(__clang__)))
+#define NOISE_SIMD_F16C 1
+#else
+#define NOISE_SIMD_F16C 0
+#endif
+
+#if NOISE_SIMD_SSE2 || NOISE_SIMD_AVX2
+#include <immintrin.h>
+#endif
@@ -0,0 +1,145 @@
+#include "ThreadPool.hpp"
+
+#include "Profiler.hpp"
+
+// More bands than threads keeps the load balanced when rows have different cost.
+static constexpr u32 kBandsPerThread = 4;
+
+static thread_local bool sIsInsideTask = false;
+
+ThreadPool::ThreadPool()
+    : nextBand(0)
+    , finishedBands(0)
+{
+}
+
+ThreadPool::~ThreadPool()
+{
+    StopWorkers();
+}
+
+ThreadPool& ThreadPool::Instance()
+{
+    static ThreadPool threadPool;
+    return threadPool;
+}
+
+void ThreadPool::SetThreadCount(u32 count)
+{
+    if (count == 0)
+        count = std::thread::hardware_concurrency();
+    count = count > 0 ? count : 1;
+
+    std::lock_guard<std::mutex> dispatchLock(dispatchMutex);
+    if (count == threadCount)
+        return;
+
+    StopWorkers();
+
+    threadCount = count;
+    stopping = false;
+    workers.reserve(count - 1);
+    for (u32 i = 1; i < count; ++i)
+        workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+void ThreadPool::Run(u32 count, TaskFunction function, void* context)
+{
+    if (count == 0)
+        return;
+
+    if (sIsInsideTask || threadCount == 1 || count == 1)
+    {
+        function(context, 0, count);
+        return;
+    }
+
+    std::lock_guard<std::mutex> dispatchLock(dispatchMutex);
+
+    u32 bands = threadCount * kBandsPerThread;
+    bands = bands < count ? bands : count;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        taskFunction = function;
+        taskContext = context;
+        taskCount = count;
+        bandSize = (count + bands - 1) / bands;
+        bandCount = (count + bandSize - 1) / bandSize;
+        nextBand.store(0);
+        finishedBands.store(0);
+        ++generation;
+    }
+    wakeCondition.notify_all();
+
+    RunBands();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    // Workers still holding this task must leave before its state can be reused.
+    doneCondition.wait(lock, [this]() { return finishedBands.load() == bandCount && activeWorkers == 0; });
+    taskFunction = nullptr;
+    taskContext = nullptr;
+}
+
+void ThreadPool::RunBands()
+{
+    sIsInsideTask = true;
+    for (;;)
+    {
+        u32 band = nextBand.fetch_add(1);
+        if (band >= bandCount)
+            break;
+
+        u32 begin = band * bandSize;
+        u32 end = begin + bandSize;
+        end = end < taskCount ? end : taskCount;
+        {
+            TRACE_RANGE("band", begin, end);
+            taskFunction(taskContext, begin, end);
+        }
+
+        if (finishedBands.fetch_add(1) + 1 == bandCount)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            doneCondition.notify_all();
+        }
+    }
+    sIsInsideTask = false;
+}
+
+void ThreadPool::WorkerLoop()
+{
+    u64 seenGeneration = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;)
+    {
+        wakeCondition.wait(lock, [this, seenGeneration]() { return stopping || generation != seenGeneration; });
+        if (stopping)
+            return;
+
+        seenGeneration = generation;
+        if (taskFunction == nullptr)
+            continue;
+
+        ++activeWorkers;
+        lock.unlock();
+        RunBands();
+        lock.lock();
+        --activeWorkers;
+        if (activeWorkers == 0)
+            doneCondition.notify_all();
+    }
+}
+
+void ThreadPool::StopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+
+    for (std::thread& worker : workers)
+        worker.join();
+    workers.clear();
+    threadCount = 1;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool final
+{
+public:
+    typedef void (*TaskFunction)(void* context, u32 begin, u32 end);
+
+    ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ~ThreadPool();
+
+    ThreadPool& operator =(const ThreadPool&) = delete;
+    ThreadPool& operator =(ThreadPool&&) = delete;
+
+    static ThreadPool& Instance();
+
+    // 0 selects the number of hardware threads. The calling thread is counted as one of the threads.
+    void SetThreadCount(u32 count);
+    u32 GetThreadCount() const { return threadCount; }
+
+    // Splits [0; count) into bands and calls function(begin, end) for every band, blocking until all bands are done.
+    // Bands are independent, so the result does not depend on the number of threads.
+    // Calls made from inside a running band are executed on the calling thread.
+    template<class Function>
+    void ParallelFor(u32 count, const Function& function)
+    {
+        Run(count, &Invoke<Function>, const_cast<void*>(static_cast<const void*>(&function)));
+    }
+
+private:
+    template<class Function>
+    static void Invoke(void* context, u32 begin, u32 end)
+    {
+        (*static_cast<const Function*>(context))(begin, end);
+    }
+
+    void Run(u32 count, TaskFunction function, void* context);
+    void RunBands();
+    void WorkerLoop();
+    void StopWorkers();
+
+    std::vector<std::thread> workers;
+    std::mutex dispatchMutex;
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+
+    TaskFunction taskFunction = nullptr;
+    void* taskContext = nullptr;
+    u32 taskCount = 0;
+    u32 bandSize = 0;
+    u32 bandCount = 0;
+    std::atomic<u32> nextBand;
+    std::atomic<u32> finishedBands;
+    u32 activeWorkers = 0;
+    u64 generation = 0;
+    bool stopping = false;
+
+    u32 threadCount = 1;
+};
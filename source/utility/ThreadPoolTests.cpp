@@ -0,0 +1,107 @@
+#include "ThreadPool.hpp"
+
+#include "testing/TestFixture.hpp"
+#include "testing/TestRunner.hpp"
+#include "testing/TestSuite.hpp"
+
+// Category 1: Parallel for
+// 1.1: Several threads, every index visited exactly once
+// 1.2: Single thread, one band covers the whole range
+// 1.3: Empty range, function is not called
+// 1.4: Nested parallel for, every index visited exactly once
+
+struct ThreadPoolFixture
+{
+	ThreadPool pool;
+	std::vector<std::atomic<u32>> visits;
+
+	void Prepare(u32 threadCount, u32 count)
+	{
+		pool.SetThreadCount(threadCount);
+		std::vector<std::atomic<u32>> cleared(count);
+		visits.swap(cleared);
+	}
+
+	bool AllVisitedOnce() const
+	{
+		for (const std::atomic<u32>& visit : visits)
+		{
+			if (visit.load() != 1)
+				return false;
+		}
+		return true;
+	}
+};
+
+// Category 1: Parallel for
+TEST_SUITE(ThreadPool_ParallelFor)
+{
+	// 1.1: Several threads, every index visited exactly once
+	TEST_FIXTURE(ThreadPoolFixture, FourThreads_ParallelFor_EveryIndexVisitedOnce)
+	{
+		const u32 count = 1000;
+		Prepare(4, count);
+
+		pool.ParallelFor(count, [this](u32 begin, u32 end)
+		{
+			for (u32 i = begin; i < end; ++i)
+				++visits[i];
+		});
+
+		Check(AllVisitedOnce());
+	}
+
+	// 1.2: Single thread, one band covers the whole range
+	TEST_FIXTURE(ThreadPoolFixture, OneThread_ParallelFor_SingleBand)
+	{
+		const u32 count = 100;
+		Prepare(1, count);
+		u32 bands = 0;
+
+		pool.ParallelFor(count, [this, &bands](u32 begin, u32 end)
+		{
+			++bands;
+			for (u32 i = begin; i < end; ++i)
+				++visits[i];
+		});
+
+		CheckEqual(1u, bands);
+		Check(AllVisitedOnce());
+	}
+
+	// 1.3: Empty range, function is not called
+	TEST_FIXTURE(ThreadPoolFixture, EmptyRange_ParallelFor_FunctionNotCalled)
+	{
+		Prepare(4, 0);
+		bool called = false;
+
+		pool.ParallelFor(0, [&called](u32, u32)
+		{
+			called = true;
+		});
+
+		Check(!called);
+	}
+
+	// 1.4: Nested parallel for, every index visited exactly once
+	TEST_FIXTURE(ThreadPoolFixture, NestedParallelFor_EveryIndexVisitedOnce)
+	{
+		const u32 rows = 16;
+		const u32 columns = 64;
+		Prepare(4, rows * columns);
+
+		pool.ParallelFor(rows, [this, columns](u32 rowBegin, u32 rowEnd)
+		{
+			for (u32 row = rowBegin; row < rowEnd; ++row)
+			{
+				pool.ParallelFor(columns, [this, row, columns](u32 begin, u32 end)
+				{
+					for (u32 i = begin; i < end; ++i)
+						++visits[row * columns + i];
+				});
+			}
+		});
+
+		Check(AllVisitedOnce());
+	}
+}
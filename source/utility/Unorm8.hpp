@@ -0,0 +1,39 @@
+#pragma once
+
+#include "utility/Simd.hpp"
+#include "utility/Types.hpp"
+
+#include <cmath>
+
+// Conversion of pixel values to 8 bit normalized integers, shared by the file formats.
+// Values are clamped to [0; 1] and rounded to the nearest step. The vector overload returns the same bytes as the scalar one.
+
+inline u8 ToUnorm8(f32 value)
+{
+    f32 clamped = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    // Kept as a separate multiply and add, so the vector conversion rounds the same way.
+    f32 scaled = clamped * 255.0f;
+    return static_cast<u8>(floor(scaled + 0.5f));
+}
+
+#if NOISE_SIMD_AVX2
+// Converts 32 values, the returned bytes are in the order of the values.
+inline __m256i ToUnorm8(const f32* values)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 scale = _mm256_set1_ps(255.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    // Packing interleaves the 128 bit halves, the permutation puts the values back in order.
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    __m256i integers[4];
+    for (u32 j = 0; j < 4; ++j)
+    {
+        __m256 clamped = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(values + j * 8), zero), one);
+        integers[j] = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_add_ps(_mm256_mul_ps(clamped, scale), half)));
+    }
+    __m256i bytes = _mm256_packus_epi16(_mm256_packs_epi32(integers[0], integers[1]), _mm256_packs_epi32(integers[2], integers[3]));
+    return _mm256_permutevar8x32_epi32(bytes, order);
+}
+#endif